@@ -1,12 +1,17 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Cannon.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "FPSCharacterMovementComponent.h"
+#include "InteractableComponent.h"
+#include "FPS.h"
 
 // Sets default values
 ACannon::ACannon()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// the cannon only reacts to interactions, it never needs to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
 
@@ -38,6 +43,12 @@ ACannon::ACannon()
 		StartLocationMesh->SetStaticMesh(StartCubeMeshAsset.Object);
 		StartLocationMesh->SetRelativeScale3D(FVector(1.f));
 	}
+
+	// Interaction
+	InteractableComponent = CreateDefaultSubobject<UInteractableComponent>(TEXT("Interactable"));
+	InteractableComponent->SetAnchor(StartLocationMesh);
+
+	BakeCharacterClass = AFPSCharacter::StaticClass();
 }
 
 // Called when the game starts or when spawned
@@ -49,17 +60,161 @@ void ACannon::BeginPlay()
 	{
 		ShootDirection = ShootLocation->GetComponentLocation();
 	}
+
+	// only trust the baked table if nothing it depends on changed since the bake
+	const bool bTableMatchesGrid = BakedCells.Num() == BakeGridSize * BakeGridSize && FMath::IsNearlyEqual(BakedCellSize, BakeCellSize);
+	const bool bTableMatchesShot = FMath::IsNearlyEqual(BakedShootPower, ShootPower) && FMath::IsNearlyEqual(BakedUpwardBoost, UpwardBoost);
+	const bool bTableMatchesTarget = BakedTargetOffset.Equals(GetTableFrame().InverseTransformPosition(ShootDirection), 1.f);
+
+	bUseBakedTable = bTableMatchesGrid && bTableMatchesShot && bTableMatchesTarget;
+
+	if (!bUseBakedTable && BakedCells.Num() > 0)
+	{
+		UE_LOG(LogFPS, Warning, TEXT("'%s' trajectory table is out of date and will be ignored. Rebake it from the details panel."), *GetNameSafe(this));
+	}
 }
 
-// Called every frame
-void ACannon::Tick(float DeltaTime)
+void ACannon::ShootPlayer(AFPSCharacter* Player)
 {
-	Super::Tick(DeltaTime);
+	// standing on the baked grid, launch straight from the table
+	FVector LaunchVelocity;
+	if (FindBakedLaunch(Player->GetActorLocation(), LaunchVelocity))
+	{
+		Player->LaunchCharacter(LaunchVelocity, true, true);
+		return;
+	}
 
+	// off the grid or blocked at bake time, solve the launch from where the player actually stands
+	Player->StartShoot(ShootPower, UpwardBoost, ShootDirection);
 }
 
-void ACannon::ShootPlayer(AFPSCharacter* Player)
+void ACannon::Interact(AFPSCharacter* Character)
+{
+	ShootPlayer(Character);
+	UE_LOG(LogFPS, Log, TEXT("'%s' interacted with cannon '%s'"), *GetNameSafe(Character), *GetNameSafe(this));
+}
+
+FTransform ACannon::GetTableFrame() const
 {
-	Player->StartShoot(ShootPower, UpwardBoost, ShootDuration, ShootDirection);
+	return FTransform(FRotator(0.f, GetActorRotation().Yaw, 0.f), GetActorLocation());
+}
+
+bool ACannon::FindBakedLaunch(const FVector& Location, FVector& OutVelocity) const
+{
+	if (!bUseBakedTable)
+	{
+		return false;
+	}
+
+	const FTransform Frame = GetTableFrame();
+	const FVector Local = Frame.InverseTransformPosition(Location) - BakedGridOrigin;
+
+	const int32 CellX = FMath::FloorToInt32(Local.X / BakeCellSize + BakeGridSize * .5f);
+	const int32 CellY = FMath::FloorToInt32(Local.Y / BakeCellSize + BakeGridSize * .5f);
+
+	if (CellX < 0 || CellY < 0 || CellX >= BakeGridSize || CellY >= BakeGridSize)
+	{
+		return false;
+	}
+
+	const FCannonLaunchCell& Cell = BakedCells[CellY * BakeGridSize + CellX];
+	if (!Cell.bValid || !Cell.bClear)
+	{
+		return false;
+	}
+
+	OutVelocity = Frame.TransformVectorNoScale(FVector(Cell.Velocity));
+	return true;
 }
 
+#if WITH_EDITOR
+void ACannon::BakeTrajectoryTable()
+{
+	UWorld* World = GetWorld();
+	if (!World || !ShootLocation || !StartLocationMesh || !BakeCharacterClass)
+	{
+		return;
+	}
+
+	const AFPSCharacter* CharacterDefaults = BakeCharacterClass.GetDefaultObject();
+	const UFPSCharacterMovementComponent* Movement = Cast<UFPSCharacterMovementComponent>(CharacterDefaults->GetCharacterMovement());
+	const UCapsuleComponent* Capsule = CharacterDefaults->GetCapsuleComponent();
+
+	if (!Movement || !Capsule)
+	{
+		UE_LOG(LogFPS, Warning, TEXT("'%s' can't bake a trajectory table for '%s', it doesn't use UFPSCharacterMovementComponent."), *GetNameSafe(this), *GetNameSafe(BakeCharacterClass));
+		return;
+	}
+
+	Modify();
+
+	const FTransform Frame = GetTableFrame();
+	const FPSMovementKernel::FBallisticParams Params = Movement->GetBallisticParams(World->GetGravityZ() * Movement->GravityScale);
+	const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	const float CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	// the player stands on top of the start pad
+	const FBox PadBounds = StartLocationMesh->Bounds.GetBox();
+	const FVector GridCenter(PadBounds.GetCenter().X, PadBounds.GetCenter().Y, PadBounds.Max.Z + CapsuleHalfHeight);
+	const FVector Target = ShootLocation->GetComponentLocation();
+
+	BakedGridOrigin = Frame.InverseTransformPosition(GridCenter);
+	BakedTargetOffset = Frame.InverseTransformPosition(Target);
+	BakedShootPower = ShootPower;
+	BakedUpwardBoost = UpwardBoost;
+	BakedCellSize = BakeCellSize;
+
+	BakedCells.Reset();
+	BakedCells.SetNum(BakeGridSize * BakeGridSize);
+
+	const FCollisionShape CapsuleShape = FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight);
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CannonTrajectoryBake), false, this);
+
+	int32 UnsolvedCells = 0;
+	int32 BlockedCells = 0;
+
+	for (int32 CellY = 0; CellY < BakeGridSize; ++CellY)
+	{
+		for (int32 CellX = 0; CellX < BakeGridSize; ++CellX)
+		{
+			FCannonLaunchCell& Cell = BakedCells[CellY * BakeGridSize + CellX];
+
+			const FVector CellOffset((CellX + .5f - BakeGridSize * .5f) * BakeCellSize, (CellY + .5f - BakeGridSize * .5f) * BakeCellSize, 0.f);
+			const FVector Start = Frame.TransformPosition(BakedGridOrigin + CellOffset);
+
+			FPSMovementKernel::FLaunchSolution Solution;
+			if (!FPSMovementKernel::SolveLaunchVelocity(UFPSCharacterMovementComponent::ToKernel(Target - Start), ShootPower, UpwardBoost, Params, Solution))
+			{
+				++UnsolvedCells;
+				continue;
+			}
+
+			const FVector LaunchVelocity = UFPSCharacterMovementComponent::FromKernel(Solution.Velocity);
+
+			Cell.Velocity = FVector3f(Frame.InverseTransformVectorNoScale(LaunchVelocity));
+			Cell.bValid = true;
+			Cell.bClear = true;
+
+			// sweep the capsule along the arc. The last step is skipped since we expect to touch the landing spot
+			FVector Previous = Start;
+			for (float Time = BakeSweepStep; Time < Solution.FlightTime - BakeSweepStep; Time += BakeSweepStep)
+			{
+				const FVector Next = Start + UFPSCharacterMovementComponent::FromKernel(FPSMovementKernel::ArcOffset(Solution.Velocity, Time, Params));
+
+				if (World->SweepTestByChannel(Previous, Next, FQuat::Identity, ECC_Pawn, CapsuleShape, QueryParams))
+				{
+					Cell.bClear = false;
+					++BlockedCells;
+					break;
+				}
+
+				Previous = Next;
+			}
+		}
+	}
+
+	bUseBakedTable = true;
+
+	UE_LOG(LogFPS, Log, TEXT("'%s' baked %d trajectory cells. %d couldn't be solved, %d are blocked along the arc."), *GetNameSafe(this), BakedCells.Num(), UnsolvedCells, BlockedCells);
+}
+#endif
@@ -6,12 +6,35 @@
 #include "GameFramework/Actor.h"
 #include "FPSCharacter.h"
 #include "Components/BoxComponent.h"
+#include "FPSInteractable.h"
 #include "Cannon.generated.h"
 
 class UBoxComponent;
+class UInteractableComponent;
+
+/**
+ *  One cell of a cannon's baked trajectory table
+ */
+USTRUCT()
+struct FCannonLaunchCell
+{
+	GENERATED_BODY()
+
+	/** Launch velocity, in the cannon's yaw frame */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon")
+	FVector3f Velocity = FVector3f::ZeroVector;
+
+	/** True if a launch could be solved from this cell */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon")
+	bool bValid = false;
+
+	/** True if the capsule sweep along the arc didn't hit anything */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon")
+	bool bClear = false;
+};
 
 UCLASS()
-class FPS_API ACannon : public AActor
+class FPS_API ACannon : public AActor, public IFPSInteractable
 {
 	GENERATED_BODY()
 	
@@ -23,23 +46,35 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 public:
 	void ShootPlayer(AFPSCharacter* Player);
 
+	//~Begin IFPSInteractable interface
+	virtual void Interact(AFPSCharacter* Character) override;
+	//~End IFPSInteractable interface
+
+#if WITH_EDITOR
+	/** Solves the launch from every cell around the start pad, sweeps the player capsule along each arc and stores the result */
+	UFUNCTION(CallInEditor, Category = "Cannon|Bake")
+	void BakeTrajectoryTable();
+#endif
+
 protected:
+
+	/** Looks up the baked launch velocity for a player at the given location. Returns false if there's no usable cell, or the arc from it is blocked */
+	bool FindBakedLaunch(const FVector& Location, FVector& OutVelocity) const;
+
+	/** Frame the trajectory table is stored in. Only follows the cannon's yaw so gravity stays down */
+	FTransform GetTableFrame() const;
+
+	/** Horizontal launch speed cap. The arc gets lofted if reaching the target would take more than this */
 	UPROPERTY(EditAnywhere, Category = "Cannon")
 	float ShootPower = 100.f;
 
+	/** Minimum vertical launch speed */
 	UPROPERTY(EditAnywhere, Category = "Cannon")
 	float UpwardBoost = 300.f;
 
-	UPROPERTY(EditAnywhere, Category = "Cannon")
-	float ShootDuration = 1.f;
-
 	UPROPERTY(EditAnywhere, Category = "Cannon")
 	FVector ShootDirection;
 
@@ -55,4 +90,49 @@ protected:
 	UPROPERTY(VisibleAnywhere, Category = "Cannon")
 	UStaticMeshComponent* StartLocationMesh;
 
+	/** Lets players standing at the start pad interact with the cannon */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon")
+	UInteractableComponent* InteractableComponent;
+
+	/** Character the trajectory table is baked for. Its capsule and movement settings are used */
+	UPROPERTY(EditAnywhere, Category = "Cannon|Bake")
+	TSubclassOf<AFPSCharacter> BakeCharacterClass;
+
+	/** Number of table cells along each side of the grid around the start pad */
+	UPROPERTY(EditAnywhere, Category = "Cannon|Bake", meta = (ClampMin = 1, ClampMax = 32))
+	int32 BakeGridSize = 5;
+
+	/** Size of each table cell */
+	UPROPERTY(EditAnywhere, Category = "Cannon|Bake", meta = (ClampMin = 1, Units = "cm"))
+	float BakeCellSize = 50.f;
+
+	/** Time between capsule sweeps along each arc */
+	UPROPERTY(EditAnywhere, Category = "Cannon|Bake", meta = (ClampMin = 0.005, Units = "s"))
+	float BakeSweepStep = 1.f / 30.f;
+
+	/** Center of the baked grid, in the table frame */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon|Bake")
+	FVector BakedGridOrigin = FVector::ZeroVector;
+
+	/** Target the table was baked for, in the table frame */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon|Bake")
+	FVector BakedTargetOffset = FVector::ZeroVector;
+
+	/** Shoot settings the table was baked with */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon|Bake")
+	float BakedShootPower = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cannon|Bake")
+	float BakedUpwardBoost = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Cannon|Bake")
+	float BakedCellSize = 0.f;
+
+	/** Baked trajectory table, BakeGridSize x BakeGridSize cells, row major */
+	UPROPERTY(VisibleAnywhere, Category = "Cannon|Bake")
+	TArray<FCannonLaunchCell> BakedCells;
+
+	/** Set at BeginPlay if the baked table still matches the cannon setup */
+	bool bUseBakedTable = false;
+
 };
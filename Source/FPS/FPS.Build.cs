@@ -25,6 +25,7 @@ public class FPS : ModuleRules
 
 		PublicIncludePaths.AddRange(new string[] {
 			"FPS",
+			"FPS/MovementKernel",
 			"FPS/Variant_Horror",
 			"FPS/Variant_Horror/UI",
 			"FPS/Variant_Shooter",
@@ -3,6 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 /** Main log category used across the project */
-DECLARE_LOG_CATEGORY_EXTERN(LogFPS, Log, All);
\ No newline at end of file
+DECLARE_LOG_CATEGORY_EXTERN(LogFPS, Log, All);
+
+/** Stat group for the project's gameplay systems */
+DECLARE_STATS_GROUP(TEXT("FPS"), STATGROUP_FPS, STATCAT_Advanced);
\ No newline at end of file
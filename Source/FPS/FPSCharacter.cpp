@@ -7,12 +7,25 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "EnhancedInputComponent.h"
 #include "InputActionValue.h"
-#include "GameFramework/CharacterMovementComponent.h"
-#include "Cannon.h"
+#include "FPSCharacterMovementComponent.h"
+#include "InteractableComponent.h"
+#include "FPSInteractionSubsystem.h"
+#include "FPSDebugDrawSubsystem.h"
+#include "FPSCharacterTickSubsystem.h"
+#include "FPSInventoryComponent.h"
 #include "PlayerAnimInstance.h"
+#include "HAL/IConsoleManager.h"
 #include "FPS.h"
 
-AFPSCharacter::AFPSCharacter()
+static TAutoConsoleVariable<bool> CVarAsyncEnvironmentProbes(
+	TEXT("fps.AsyncEnvironmentProbes"),
+	true,
+	TEXT("If true, FPSCharacter interaction probes are issued as async traces and their results are used the following frame.\n")
+	TEXT("If false, they run as synchronous traces on the game thread."),
+	ECVF_Default);
+
+AFPSCharacter::AFPSCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UFPSCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(55.f, 96.0f);
@@ -35,6 +48,9 @@ AFPSCharacter::AFPSCharacter()
 	FirstPersonMesh->FirstPersonPrimitiveType = EFirstPersonPrimitiveType::FirstPerson;
 	FirstPersonMesh->SetCollisionProfileName(FName("NoCollision"));
 
+	// Create the weapon inventory
+	Inventory = CreateDefaultSubobject<UFPSInventoryComponent>(TEXT("Inventory"));
+
 	// configure the character comps
 	GetMesh()->SetOwnerNoSee(true);
 	GetMesh()->FirstPersonPrimitiveType = EFirstPersonPrimitiveType::WorldSpaceRepresentation;
@@ -78,24 +94,34 @@ void AFPSCharacter::BeginPlay()
 			PlayerAnimInstance = Cast<UPlayerAnimInstance>(AnimInstance);
 		}
 	}
+
+	// hand our per frame work over to the character tick subsystem
+	if (UFPSCharacterTickSubsystem* CharacterTick = GetWorld()->GetSubsystem<UFPSCharacterTickSubsystem>())
+	{
+		CharacterTick->RegisterCharacter(this);
+	}
+}
+
+void AFPSCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	if (UFPSCharacterTickSubsystem* CharacterTick = GetWorld()->GetSubsystem<UFPSCharacterTickSubsystem>())
+	{
+		CharacterTick->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AFPSCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// When on ground check to make sure bools have been reset
-	if (GetCharacterMovement()->IsMovingOnGround())
+	// falling gravity, koyote time and wall running are simulated by UFPSCharacterMovementComponent.
+	// The rest only runs here while the character tick subsystem isn't updating characters in bulk
+	if (UFPSCharacterTickSubsystem* CharacterTick = GetWorld()->GetSubsystem<UFPSCharacterTickSubsystem>())
 	{
-		bHasDoubleJumped = false;
-		bHasDashed = false;
+		CharacterTick->TickCharacter(this);
 	}
-
-	DebugFunc();
-	KoyoteJump(DeltaTime);
-	FallingGravity(DeltaTime);
-	CheckForWall(DeltaTime);
-	CheckForInteraction(DeltaTime);
 }
 
 void AFPSCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -129,351 +155,243 @@ void AFPSCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompon
 	}
 }
 
-void AFPSCharacter::Jump()
+bool AFPSCharacter::CanJumpInternal_Implementation() const
+{
+	// the movement component decides which air jump applies. Holding the button down never triggers one
+	return Super::CanJumpInternal_Implementation() || (JumpKeyHoldTime == 0.f && GetFPSMovement()->CanAirJump());
+}
+
+void AFPSCharacter::PostLoad()
 {
-	UCharacterMovementComponent* Character = GetCharacterMovement();
+	Super::PostLoad();
 
-	// Jump off of Wall Run
-	if (bIsWallRunning)
+#if WITH_EDITORONLY_DATA
+	// carry tuning overridden before it moved to the movement component over to it. Values still at the old default were never overridden
+	if (UFPSCharacterMovementComponent* Movement = GetFPSMovement())
 	{
-		FVector Forward = FirstPersonCameraComponent->GetForwardVector();
-		Forward.Z = 0.0f;
-		Forward.Normalize();
+		const AFPSCharacter* Defaults = GetDefault<AFPSCharacter>();
 
-		// Make sure the jump is not into the wall
-		float Dot = FVector::DotProduct(Forward, CurrentWallNormal);
-		//UE_LOG(LogTemp, Warning, TEXT("Wall Run Dot: %f"), Dot);
-		if (Dot < 0.f)
-		{
-			Forward = FVector::VectorPlaneProject(Forward, CurrentWallNormal * 15.f).GetSafeNormal();
-		}
+		auto Migrate = [](float& Deprecated, float Default, float& Target)
+			{
+				if (Deprecated != Default)
+				{
+					Target = Deprecated;
+					Deprecated = Default;
+				}
+			};
+
+		Migrate(FallGravityScaler_DEPRECATED, Defaults->FallGravityScaler_DEPRECATED, Movement->FallGravityScaler);
+		Migrate(FallGravityMultiplierMin_DEPRECATED, Defaults->FallGravityMultiplierMin_DEPRECATED, Movement->FallGravityMultiplierMin);
+		Migrate(FallGravityMultiplierMax_DEPRECATED, Defaults->FallGravityMultiplierMax_DEPRECATED, Movement->FallGravityMultiplierMax);
+		Migrate(KoyoteTime_DEPRECATED, Defaults->KoyoteTime_DEPRECATED, Movement->KoyoteTime);
+		Migrate(DoubleJumpForwardBoost_DEPRECATED, Defaults->DoubleJumpForwardBoost_DEPRECATED, Movement->DoubleJumpForwardBoost);
+		Migrate(WallCheckDistance_DEPRECATED, Defaults->WallCheckDistance_DEPRECATED, Movement->WallCheckDistance);
+		Migrate(WallRunGravityScale_DEPRECATED, Defaults->WallRunGravityScale_DEPRECATED, Movement->WallRunGravityScale);
+		Migrate(WallRunSpeed_DEPRECATED, Defaults->WallRunSpeed_DEPRECATED, Movement->WallRunSpeed);
+		Migrate(DashPower_DEPRECATED, Defaults->DashPower_DEPRECATED, Movement->DashPower);
+		Migrate(DashUpwardBoost_DEPRECATED, Defaults->DashUpwardBoost_DEPRECATED, Movement->DashUpwardBoost);
+	}
+#endif
+}
 
-		FVector JumpVelocity = Forward * WallRunSpeed;
-		JumpVelocity.Z = Character->JumpZVelocity;
+UFPSCharacterMovementComponent* AFPSCharacter::GetFPSMovement() const
+{
+	return CastChecked<UFPSCharacterMovementComponent>(GetCharacterMovement());
+}
 
-		LaunchCharacter(JumpVelocity, true, true);
-		PreviousDirection = GetActorForwardVector();
-		bHasDoubleJumped = false;
-		StopWallRun();
-		//UE_LOG(LogTemp, Warning, TEXT("Wall Run Jump"));
-		return;
-	}
+void AFPSCharacter::DebugFunc()
+{
+#if FPS_DEBUG_DRAW
+	float DebugDistance = 500.f; // How far the line goes
+	FVector Start = GetActorLocation();
+	FVector End = Start + (GetActorForwardVector() * DebugDistance);
+
+	FPS_DEBUG_LINE(GetWorld(), Character, Start, End, FColor::Cyan);
+#endif
+}
 
-	bool bCanKoyoteJump = !Character->IsMovingOnGround() && TimeSinceLeftGround <= KoyoteTime;
-	bool bCanNormalJump = Character->IsMovingOnGround();
+bool AFPSCharacter::UseAsyncEnvironmentProbes()
+{
+	return CVarAsyncEnvironmentProbes.GetValueOnGameThread();
+}
 
-	if (bCanNormalJump)
+bool AFPSCharacter::ConsumeAsyncProbe(FTraceHandle& Handle, bool& bOutHit, FHitResult& OutHit) const
+{
+	// nothing was issued last frame
+	if (!Handle.IsValid())
 	{
-		Super::Jump();
-		PreviousDirection = GetActorForwardVector();
-		bHasDoubleJumped = false;
-		//UE_LOG(LogTemp, Warning, TEXT("Normal Jump"));
-		return;
+		return false;
 	}
 
-	if (bCanKoyoteJump)
+	// the handle is only good for one frame, so clear it either way
+	FTraceDatum Datum;
+	const bool bHasResult = GetWorld()->QueryTraceData(Handle, Datum);
+	Handle = FTraceHandle();
+
+	if (!bHasResult)
 	{
-		LaunchCharacter(FVector(0, 0, Character->JumpZVelocity), false, true);
-		PreviousDirection = GetActorForwardVector();
-		bHasDoubleJumped = false;
-		//UE_LOG(LogTemp, Warning, TEXT("Koyote Jump"));
-		return;
+		return false;
 	}
 
-	// Double jump
-	if (!bHasDoubleJumped && Character->IsFalling())
+	bOutHit = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+	if (bOutHit)
 	{
-		FVector Forward = FirstPersonCameraComponent->GetForwardVector();
-		Forward.Z = 0.0f;
-		Forward.Normalize();
-
-		FVector JumpVelocity = Forward * DoubleJumpForwardBoost + FVector(0, 0, Character->JumpZVelocity);
-		LaunchCharacter(JumpVelocity, true, true);
-
-		bHasDoubleJumped = true;
+		OutHit = Datum.OutHits[0];
 	}
+
+	return true;
 }
 
-void AFPSCharacter::DebugFunc()
+void AFPSCharacter::StartDash()
 {
-	float DebugDistance = 500.f; // How far the line goes
-	FVector Start = GetActorLocation();
-	FVector End = Start + (GetActorForwardVector() * DebugDistance);
-
-	DrawDebugLine(GetWorld(), Start, End, FColor::Cyan, false, 0.f, 0, 1.0f);
+	// the dash itself runs inside the movement update
+	GetFPSMovement()->RequestDash();
 }
 
-void AFPSCharacter::FallingGravity(float DeltaTime)
+void AFPSCharacter::ConsumeInteractionProbe()
 {
-	bool bIsFalling = GetCharacterMovement()->IsFalling();
+	// finish the confirm trace issued last frame
+	FHitResult Hit;
+	bool bHit = false;
 
-	if (!bIsFalling)
+	const bool bProbeIssued = InteractionProbe.IsValid();
+
+	if (ConsumeAsyncProbe(InteractionProbe, bHit, Hit))
 	{
-		FallGravityMultiplier = FallGravityMultiplierMin;
-		return;
-	}
+		ConfirmFocus(PendingFocus.Get(), bHit, Hit, InteractionProbeStart, InteractionProbeEnd);
+
+	} else if (bProbeIssued && PendingFocus.IsValid()) {
 
-	FallGravityMultiplier = (FallGravityMultiplier < FallGravityMultiplierMax) ? FallGravityMultiplier + DeltaTime * FallGravityScaler : FallGravityMultiplierMax;
-	FVector tempVel = GetCharacterMovement()->Velocity;
-	tempVel.Z -= FallGravityMultiplier * DeltaTime;
-	GetCharacterMovement()->Velocity = tempVel;
+		// the result was lost. The focus is only queried again once we move, so trace the candidate again
+		IssueInteractionProbe();
+	}
 }
 
-void AFPSCharacter::KoyoteJump(float DeltaTime)
+void AFPSCharacter::IssueInteractionProbe()
 {
-	bool bIsGrounded = GetCharacterMovement()->IsMovingOnGround();
-	if (bIsGrounded) {
-		TimeSinceLeftGround = 0.f;
-	}
-	else {
-		TimeSinceLeftGround += DeltaTime;
-	}
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(FPSInteractionProbe), false, this);
+	InteractionProbe = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, InteractionProbeStart, InteractionProbeEnd, ECC_Visibility, Params);
 }
 
-void AFPSCharacter::CheckForWall(float DeltaTime)
+void AFPSCharacter::UpdateFocus(UFPSInteractionSubsystem* Interaction, const FVector& Start, const FVector& Forward)
 {
-	WallConnectTimer += DeltaTime;
+	UInteractableComponent* Candidate = Interaction->FindFocus(Start, Forward, InteractCheckDistance);
 
-	if (WallConnectTimer < .1f)
+	// nothing new to confirm
+	if (Candidate == PendingFocus.Get() || (Candidate == FocusedInteractable.Get() && !PendingFocus.IsValid()))
 	{
 		return;
 	}
 
-	FVector Start = GetActorLocation();
-	FVector RightVector = GetActorRightVector();
-	FVector EndRight = Start + (RightVector * WallCheckDistance);
-	FVector EndLeft = Start - (RightVector * WallCheckDistance);
-
-	FHitResult RightHit;
-	FHitResult LeftHit;
-
-	FCollisionQueryParams Params;
-	Params.AddIgnoredActor(this);
-
-	bool bHitRight = GetWorld()->LineTraceSingleByChannel(
-		RightHit,
-		Start,
-		EndRight,
-		ECC_Visibility,
-		Params
-	);
+	if (!Candidate)
+	{
+		PendingFocus = nullptr;
+		InteractionProbe = FTraceHandle();
+		SetFocusedInteractable(nullptr);
+		return;
+	}
 
-	bool bHitLeft = GetWorld()->LineTraceSingleByChannel(
-		LeftHit,
-		Start,
-		EndLeft,
-		ECC_Visibility,
-		Params
-	);
-	
-	// Debug lines
-	DrawDebugLine(GetWorld(), Start, EndRight, FColor::Blue, false, 0.f, 0, 1.0f);
-	DrawDebugLine(GetWorld(), Start, EndLeft, FColor::Red, false, 0.f, 0, 1.0f);
+	// make sure nothing is in the way before we focus it
+	PendingFocus = Candidate;
 
-	auto IsValidWall = [](AActor* HitActor)
-		{
-			return HitActor && HitActor->ActorHasTag(FName("WallRun"));
-		};
+	const FVector End = Candidate->GetInteractLocation();
 
-	if ((bHitRight && IsValidWall(RightHit.GetActor())) || (bHitLeft && IsValidWall(LeftHit.GetActor())))
+	if (UseAsyncEnvironmentProbes())
 	{
-		if (!GetCharacterMovement()->IsMovingOnGround())
-		{
-			CurrentWallNormal = (bHitRight && IsValidWall(RightHit.GetActor())) ? RightHit.ImpactNormal : LeftHit.ImpactNormal;
-			StartWallRun(CurrentWallNormal);
-		}
+		InteractionProbeStart = Start;
+		InteractionProbeEnd = End;
+		IssueInteractionProbe();
 	}
 	else
 	{
-		StopWallRun();
-		CurrentWallNormal = FVector::ZeroVector;
-	}
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(FPSInteractionProbe), false, this);
+		FHitResult Hit;
 
-	// Disable players from falling when wall running
-	if (bIsWallRunning)
-	{
-		FVector Velocity = GetCharacterMovement()->Velocity;
-		Velocity.Z = 0.0f;
-		GetCharacterMovement()->Velocity = Velocity;
-	}
-}
+		const bool bHit = GetWorld()->LineTraceSingleByChannel(
+			Hit,
+			Start,
+			End,
+			ECC_Visibility,
+			Params
+		);
 
-void AFPSCharacter::StartWallRun(const FVector& WallNormal)
-{
-	if (bIsWallRunning)
-	{
-		return;
+		ConfirmFocus(Candidate, bHit, Hit, Start, End);
 	}
-	bIsWallRunning = true;
-	bHasDashed = false;
-
-	UCharacterMovementComponent* Movement = GetCharacterMovement();
-	Movement->GravityScale = WallRunGravityScale;
-	Movement->Velocity = FVector::VectorPlaneProject(Movement->Velocity, WallNormal).GetSafeNormal() * WallRunSpeed;
-
-	// Lock rotation so player WONT move with rotation while wall running
-	bUseControllerRotationYaw = false;
-	Movement->bOrientRotationToMovement = false;
-
-	//UE_LOG(LogTemp, Warning, TEXT("Wall run started"));
 }
 
-void AFPSCharacter::StopWallRun()
+void AFPSCharacter::ConfirmFocus(UInteractableComponent* Candidate, bool bHit, const FHitResult& Hit, const FVector& Start, const FVector& End)
 {
-	if (!bIsWallRunning)
+	PendingFocus = nullptr;
+
+	// the candidate went away while we were tracing
+	if (!Candidate || !Candidate->IsInteractionEnabled())
 	{
 		return;
 	}
-	bIsWallRunning = false;
 
-	WallConnectTimer = 0.f;
+	// visible if the trace reached it unobstructed
+	const bool bVisible = !bHit || Hit.GetActor() == Candidate->GetOwner();
 
-	GetCharacterMovement()->GravityScale = 1.f;
+	FPS_DEBUG_LINE(GetWorld(), Interaction, Start, End, bVisible ? FColor::Green : FColor::Red);
 
-	// Unlock rotation so player will move with camera
-	bUseControllerRotationYaw = true;
-	GetCharacterMovement()->bOrientRotationToMovement = true;
-
-	//UE_LOG(LogTemp, Warning, TEXT("Wall run stopped"));
+	SetFocusedInteractable(bVisible ? Candidate : nullptr);
 }
 
-void AFPSCharacter::StartDash()
+void AFPSCharacter::SetFocusedInteractable(UInteractableComponent* NewFocus)
 {
-	if (bHasDashed || !GetCharacterMovement()->IsFalling() || bIsWallRunning)
+	UInteractableComponent* OldFocus = FocusedInteractable.Get();
+	if (OldFocus == NewFocus)
 	{
 		return;
 	}
 
-	bHasDashed = true;
-
-	FVector Forward = GetCharacterMovement()->GetForwardVector();
-	Forward.Normalize();
-
-	FVector DashVelocity = Forward * DashPower;
-	DashVelocity.Z += DashUpwardBoost;
-
-	LaunchCharacter(DashVelocity, true, true);
-
-	UE_LOG(LogTemp, Warning, TEXT("Dash Happened!"));
-}
-
-void AFPSCharacter::CheckForInteraction(float DeltaTime)
-{
-	FVector Start = GetActorLocation();
-	FVector Forward = GetActorForwardVector();
-	FVector EndForward = Start + (Forward * InteractCheckDistance);
+	FocusedInteractable = NewFocus;
 
-	FHitResult Hit;
-
-	FCollisionQueryParams Params;
-	Params.AddIgnoredActor(this);
-
-	bool bHit = GetWorld()->LineTraceSingleByChannel(
-		Hit,
-		Start,
-		EndForward,
-		ECC_Visibility,
-		Params
-	);
-
-	// Interact with cannon
-	auto IsValidWall = [](AActor* HitActor)
-		{
-			return HitActor && HitActor->ActorHasTag(FName("Cannon"));
-		};
-
-
-	if ((bHit && IsValidWall(Hit.GetActor())))
+	if (OldFocus)
 	{
-		bCanInteract = true;
-		InteractableActor = Hit.GetActor();
-		DrawDebugLine(GetWorld(), Start, EndForward, FColor::Green, false, 0.f, 0, 1.0f);
+		OldFocus->NotifyFocusLost(this);
 	}
-	else
-	{
-		bCanInteract = false;
-		InteractableActor = nullptr;
-		DrawDebugLine(GetWorld(), Start, EndForward, FColor::Red, false, 0.f, 0, 1.0f);
-	}
-
-	// Pickup weapon
-	auto IsValidWeapon = [](AActor* HitActor)
-		{
-			return HitActor && HitActor->ActorHasTag(FName("Weapon"));
-		};
 
-	if (bHit)
+	if (NewFocus)
 	{
-		AActor* HitActor = Hit.GetActor();
-
-		if (IsValidWeapon(HitActor))
-		{
-			if (AWeapon* Weapon = Cast<AWeapon>(HitActor))
-			{
-				PickupWeapon(Weapon);
-			}
-
-			DrawDebugLine(GetWorld(), Start, EndForward, FColor::Emerald, false, 0.f, 0, 1.0f);
-		}
+		NewFocus->NotifyFocusGained(this);
 	}
 }
 
 void AFPSCharacter::InteractInput()
 {
-	if (!bCanInteract)
+	if (UInteractableComponent* Focus = FocusedInteractable.Get())
 	{
-		return;
-	}
-
-	// Call the ShootPlayer function from Cannon.CPP
-	ACannon* Cannon = Cast<ACannon>(InteractableActor);
-	if (Cannon)
-	{
-		Cannon->ShootPlayer(this);
-		UE_LOG(LogTemp, Warning, TEXT("Interacted with Cannon"));
+		Focus->Interact(this);
 	}
 }
 
-void AFPSCharacter::StartShoot(float Power, float UpwardBoost, float Duration, FVector Direction)
+void AFPSCharacter::StartShoot(float Power, float UpwardBoost, FVector Direction)
 {
 	if (!GetCharacterMovement())
 		return;
 
-	// Current location
-	FVector Start = GetActorLocation();
-	FVector End = Direction;
-
-	// Direction and horizontal distance
-	FVector Delta = End - Start;
-	FVector DeltaXY = FVector(Delta.X, Delta.Y, 0.f);
-	float DistanceXY = DeltaXY.Size();
-	FVector DirectionXY = DeltaXY.GetSafeNormal();
-
-	// Gravity
-	float Gravity = FMath::Abs(GetCharacterMovement()->GetGravityZ());
+	// Direction is the target location
+	const FVector Delta = Direction - GetActorLocation();
 
-	// Simplified arc: vertical velocity = upward boost + some from distance
-	float InitialZ = UpwardBoost + FMath::Sqrt(2 * Gravity * FMath::Max(Delta.Z, 0.f));
-
-	// Flight time estimate (simple linear approx)
-	float Time = DistanceXY / Power;
-	if (Time <= 0.f) Time = 0.1f; // avoid divide by zero
-
-	// Compute horizontal velocity
-	FVector HorizontalVelocity = DirectionXY * (DistanceXY / Time);
+	// solve against the falling gravity ramp and falling braking so we land on the target
+	FPSMovementKernel::FLaunchSolution Solution;
+	if (!FPSMovementKernel::SolveLaunchVelocity(UFPSCharacterMovementComponent::ToKernel(Delta), Power, UpwardBoost, GetFPSMovement()->GetBallisticParams(GetCharacterMovement()->GetGravityZ()), Solution))
+	{
+		UE_LOG(LogFPS, Warning, TEXT("'%s' couldn't solve a launch to %s"), *GetNameSafe(this), *Direction.ToString());
+		return;
+	}
 
-	// Combine horizontal + vertical
-	FVector LaunchVelocity = HorizontalVelocity;
-	LaunchVelocity.Z = InitialZ;
+	const FVector LaunchVelocity = UFPSCharacterMovementComponent::FromKernel(Solution.Velocity);
 
 	// Launch the character
 	LaunchCharacter(LaunchVelocity, true, true);
-
-	//UE_LOG(LogTemp, Warning, TEXT("Launched to target: %s"), *TargetLocation.ToString());
 }
 
 void AFPSCharacter::ShootWeapon()
 {
+	AWeapon* SelectedWeapon = GetSelectedWeapon();
+
 	if (SelectedWeapon == nullptr)
 	{
 		return;
@@ -493,14 +411,22 @@ void AFPSCharacter::PickupWeapon(AWeapon* Weapon)
 		return;
 	}
 
-	// Don't add duplicate weapons
-	if (OwnedWeapons.Contains(Weapon))
+	// Don't add duplicate weapons, or more weapons than we have slots for
+	if (Inventory->Contains(Weapon))
+	{
+		return;
+	}
+
+	const int32 Slot = Inventory->AddItem(Weapon);
+	if (Slot == INDEX_NONE)
 	{
 		return;
 	}
 
 	UE_LOG(LogTemp, Warning, TEXT("Picked up weapon"));
-	OwnedWeapons.Add(Weapon);
+
+	// resolve what the HUD needs once, so switching back to the slot doesn't have to
+	Inventory->GetSlot(Slot)->MagazineSize = Weapon->AmmoCount;
 
 	// Attach the weapon actor itself to the player
 	//FAttachmentTransformRules AttachRules(FAttachmentTransformRules::SnapToTargetNotIncludingScale, true);
@@ -531,26 +457,41 @@ void AFPSCharacter::PickupWeapon(AWeapon* Weapon)
 		PlayerAnimInstance->bIsHoldingPistol = true;
 	}
 
-	SelectedWeapon = Weapon;
-}
+	// put away the weapon we were holding and equip the new one
+	SetWeaponEquipped(GetSelectedWeapon(), false);
 
-void AFPSCharacter::SwitchWeapon()
-{
+	Inventory->SetCurrentSlot(Slot);
 }
 
-void AFPSCharacter::ShootPlayer(float DeltaTime)
+void AFPSCharacter::SwitchWeapon()
 {
-	if (!bStartedShoot)
+	// ensure we have another weapon to switch to
+	const int32 NextSlot = Inventory->GetNextSlot();
+	if (NextSlot == INDEX_NONE)
 	{
 		return;
 	}
 
-	if (ShootDuration > 0.f)
+	SetWeaponEquipped(GetSelectedWeapon(), false);
+
+	Inventory->SetCurrentSlot(NextSlot);
+
+	SetWeaponEquipped(GetSelectedWeapon(), true);
+}
+
+void AFPSCharacter::SetWeaponEquipped(AWeapon* Weapon, bool bEquipped)
+{
+	if (Weapon)
 	{
-		ShootDuration -= DeltaTime;
+		Weapon->SetActorHiddenInGame(!bEquipped);
 	}
 }
 
+AWeapon* AFPSCharacter::GetSelectedWeapon() const
+{
+	return Inventory->GetCurrentItem<AWeapon>();
+}
+
 
 void AFPSCharacter::MoveInput(const FInputActionValue& Value)
 {
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Logging/LogMacros.h"
+#include "WorldCollision.h"
 #include "Weapon.h"
 #include "PlayerAnimInstance.h"
 #include "FPSCharacter.generated.h"
@@ -13,6 +14,10 @@ class UInputComponent;
 class USkeletalMeshComponent;
 class UCameraComponent;
 class UInputAction;
+class UFPSCharacterMovementComponent;
+class UInteractableComponent;
+class UFPSInteractionSubsystem;
+class UFPSInventoryComponent;
 struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
@@ -25,6 +30,8 @@ class AFPSCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend class UFPSCharacterTickSubsystem;
+
 	/** Pawn mesh: first person view (arms; seen only by self) */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	USkeletalMeshComponent* FirstPersonMesh;
@@ -33,6 +40,10 @@ class AFPSCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* FirstPersonCameraComponent;
 
+	/** Weapons picked up by the character */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UFPSInventoryComponent* Inventory;
+
 	UPROPERTY()
 	TSubclassOf<UAnimInstance> UnarmedAnimClass;
 
@@ -70,7 +81,7 @@ protected:
 	UInputAction* ShootAction;
 	
 public:
-	AFPSCharacter();
+	AFPSCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
 protected:
 
@@ -99,121 +110,147 @@ protected:
 protected:
 	virtual void BeginPlay() override;
 
+	/** Gameplay cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void Tick(float DeltaTime) override;
 
 	/** Set up input action bindings */
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
-	
-	virtual void Jump() override;
 
-public:
+	/** Allows wall, koyote and double jumps on top of the regular jump rules */
+	virtual bool CanJumpInternal_Implementation() const override;
 
-	/** Returns the first person mesh **/
-	USkeletalMeshComponent* GetFirstPersonMesh() const { return FirstPersonMesh; }
+	//~Begin UObject interface
+	virtual void PostLoad() override;
+	//~End UObject interface
 
-	/** Returns first person camera component **/
-	UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
+#if WITH_EDITORONLY_DATA
+	/**
+	 *  Jump, dash and wall run tuning saved before it moved to UFPSCharacterMovementComponent
+	 *  Old saved values load into these through the property redirects in DefaultEngine.ini, and PostLoad moves overrides over
+	 */
+	UPROPERTY()
+	float FallGravityScaler_DEPRECATED = 5.f;
 
 	UPROPERTY()
-	UPlayerAnimInstance* PlayerAnimInstance;
+	float FallGravityMultiplierMin_DEPRECATED = 10.f;
 
-private:
-	void DebugFunc();
+	UPROPERTY()
+	float FallGravityMultiplierMax_DEPRECATED = 100.f;
 
-	// Handles additional gravity when player is falling
-	void FallingGravity(float DeltaTime);
+	UPROPERTY()
+	float KoyoteTime_DEPRECATED = .2f;
 
-	float FallGravityMultiplier;
+	UPROPERTY()
+	float DoubleJumpForwardBoost_DEPRECATED = 600.f;
 
-	UPROPERTY(EditAnywhere, Category = "Falling")
-	float FallGravityScaler = 5.f;
+	UPROPERTY()
+	float WallCheckDistance_DEPRECATED = 100.f;
 
-	UPROPERTY(EditAnywhere, Category = "Falling")
-	float FallGravityMultiplierMin = 10.f;
+	UPROPERTY()
+	float WallRunGravityScale_DEPRECATED = .2f;
 
-	UPROPERTY(EditAnywhere, Category = "Falling")
-	float FallGravityMultiplierMax = 100.f;
+	UPROPERTY()
+	float WallRunSpeed_DEPRECATED = 600.f;
 
-	// Koyote Time
-	void KoyoteJump(float DeltaTime);
+	UPROPERTY()
+	float DashPower_DEPRECATED = 100.f;
 
-	UPROPERTY(VisibleAnywhere, Category = "Jumping")
-	float TimeSinceLeftGround = 0.f;
+	UPROPERTY()
+	float DashUpwardBoost_DEPRECATED = 300.f;
+#endif
 
-	UPROPERTY(EditAnywhere, Category = "Jumping")
-	float KoyoteTime = .2f;
+public:
 
-	// Double Jump
-	bool bHasDoubleJumped = false;
-	FVector PreviousDirection = FVector::ZeroVector;
+	/** Returns the first person mesh **/
+	USkeletalMeshComponent* GetFirstPersonMesh() const { return FirstPersonMesh; }
 
-	UPROPERTY(EditAnywhere, Category = "Double Jump")
-	float DoubleJumpForwardBoost = 600.f;
+	/** Returns first person camera component **/
+	UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
 
-protected:
-	void CheckForWall(float DeltaTime);
-	void StartWallRun(const FVector& WallNormal);
-	void StopWallRun();
+	/** Returns the weapon inventory **/
+	UFPSInventoryComponent* GetInventory() const { return Inventory; }
 
-	bool bIsWallRunning = false;
-	FVector CurrentWallNormal = FVector::ZeroVector;
+	/** Returns the FPS character movement component **/
+	UFPSCharacterMovementComponent* GetFPSMovement() const;
 
-	UPROPERTY(VisibleAnywhere, Category = "Wall Run")
-	float WallConnectTimer = 0.f;
+	UPROPERTY()
+	UPlayerAnimInstance* PlayerAnimInstance;
 
-	UPROPERTY(EditAnywhere, Category = "Wall Run")
-	float WallCheckDistance = 100.f;
+private:
+	void DebugFunc();
 
-	UPROPERTY(EditAnywhere, Category = "Wall Run")
-	float WallRunGravityScale = .2f;
+protected:
+	/** Returns true if environment probes should be issued as async traces and consumed the following frame */
+	static bool UseAsyncEnvironmentProbes();
 
-	UPROPERTY(EditAnywhere, Category = "Wall Run")
-	float WallRunSpeed = 600.f;
+	/** Retrieves the result of an async probe issued last frame. Returns false if no result is available */
+	bool ConsumeAsyncProbe(FTraceHandle& Handle, bool& bOutHit, FHitResult& OutHit) const;
 
 protected:
 	void StartDash();
 
-	UPROPERTY(EditAnywhere, Category = "Dash")
-	float DashPower = 100;
+protected:
+	void InteractInput();
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dash")
-	float DashUpwardBoost = 300.f;
+	/** Confirms or rejects the focus candidate with the async trace issued last frame */
+	void ConsumeInteractionProbe();
 
-	FVector DashDirection;
+	/** Finds what we're looking at and starts confirming it if it changed */
+	void UpdateFocus(UFPSInteractionSubsystem* Interaction, const FVector& Start, const FVector& Forward);
 
-	bool bHasDashed = false;
+	/** Checks the result of the visibility trace for a focus candidate */
+	void ConfirmFocus(UInteractableComponent* Candidate, bool bHit, const FHitResult& Hit, const FVector& Start, const FVector& End);
 
-protected:
-	void CheckForInteraction(float DeltaTime);
-	void InteractInput();
+	/** Changes the focused interactable and dispatches the focus callbacks */
+	void SetFocusedInteractable(UInteractableComponent* NewFocus);
+
+	/** Async interaction probe issued last frame */
+	FTraceHandle InteractionProbe;
+
+	/** Start and end of the interaction probe, kept to confirm or re-issue it */
+	FVector InteractionProbeStart = FVector::ZeroVector;
+	FVector InteractionProbeEnd = FVector::ZeroVector;
 
-	bool bCanInteract = false;
+	/** Issues the async confirm trace for the pending focus */
+	void IssueInteractionProbe();
 
 	UPROPERTY(EditAnywhere, Category = "Interact")
 	float InteractCheckDistance = 100.f;
 
-	UPROPERTY()
-	AActor* InteractableActor;
+	/** Distance we need to move before the focus is queried again. Read when the character registers with the tick subsystem */
+	UPROPERTY(EditAnywhere, Category = "Interact", meta = (ClampMin = 0, Units = "cm"))
+	float FocusMoveThreshold = 5.f;
+
+	/** Angle we need to turn before the focus is queried again. Read when the character registers with the tick subsystem */
+	UPROPERTY(EditAnywhere, Category = "Interact", meta = (ClampMin = 0, ClampMax = 90, Units = "Degrees"))
+	float FocusAngleThreshold = 2.f;
+
+	/** Interactable we're currently looking at */
+	TWeakObjectPtr<UInteractableComponent> FocusedInteractable;
 
-	void ShootPlayer(float DeltaTime);
-	bool bStartedShoot = false;
-	float ShootPower;
-	float ShootDuration;
-	FVector ShootDirection;
+	/** Candidate waiting on its visibility trace */
+	TWeakObjectPtr<UInteractableComponent> PendingFocus;
 
 public:
-	void StartShoot(float Power, float UpwardBoost, float Duration, FVector Direction);
+	void StartShoot(float Power, float UpwardBoost, FVector Direction);
+
+public:
+	void PickupWeapon(AWeapon* Weapon);
 
 protected:
 	void ShootWeapon();
-	void PickupWeapon(AWeapon* Weapon);
+
+	/** Equips the next picked up weapon, in slot order */
+	UFUNCTION(BlueprintCallable, Category = "Weapons")
 	void SwitchWeapon();
 
-	// Current chosen weapon
-	AWeapon* SelectedWeapon;
+	/** Shows or hides a picked up weapon */
+	void SetWeaponEquipped(AWeapon* Weapon, bool bEquipped);
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapons")
-	TArray<AWeapon*> OwnedWeapons;
+	/** Returns the currently equipped weapon */
+	AWeapon* GetSelectedWeapon() const;
 
 };
 
@@ -0,0 +1,488 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSCharacterMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "FPSDebugDrawSubsystem.h"
+
+/**
+ *  Saved move for UFPSCharacterMovementComponent
+ *  Sends the dash input through a compressed flag and keeps the ability state needed to replay the move
+ */
+class FSavedMove_FPSCharacter : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	uint8 bSavedWantsToDash : 1;
+	uint8 bSavedHasDoubleJumped : 1;
+	uint8 bSavedHasDashed : 1;
+
+	float SavedFallGravityMultiplier = 0.f;
+	float SavedTimeSinceLeftGround = 0.f;
+	float SavedWallConnectTimer = 0.f;
+	FVector SavedWallNormal = FVector::ZeroVector;
+
+	FSavedMove_FPSCharacter()
+		: bSavedWantsToDash(0)
+		, bSavedHasDoubleJumped(0)
+		, bSavedHasDashed(0)
+	{
+	}
+
+	virtual void Clear() override
+	{
+		Super::Clear();
+
+		bSavedWantsToDash = 0;
+		bSavedHasDoubleJumped = 0;
+		bSavedHasDashed = 0;
+		SavedFallGravityMultiplier = 0.f;
+		SavedTimeSinceLeftGround = 0.f;
+		SavedWallConnectTimer = 0.f;
+		SavedWallNormal = FVector::ZeroVector;
+	}
+
+	virtual uint8 GetCompressedFlags() const override
+	{
+		uint8 Result = Super::GetCompressedFlags();
+
+		if (bSavedWantsToDash)
+		{
+			Result |= FLAG_Custom_0;
+		}
+
+		return Result;
+	}
+
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override
+	{
+		// never merge away a dash
+		if (bSavedWantsToDash || static_cast<FSavedMove_FPSCharacter*>(NewMove.Get())->bSavedWantsToDash)
+		{
+			return false;
+		}
+
+		return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+	}
+
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override
+	{
+		Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+		if (const UFPSCharacterMovementComponent* Movement = Cast<UFPSCharacterMovementComponent>(C->GetCharacterMovement()))
+		{
+			bSavedWantsToDash = Movement->bWantsToDash;
+			bSavedHasDoubleJumped = Movement->bHasDoubleJumped;
+			bSavedHasDashed = Movement->bHasDashed;
+			SavedFallGravityMultiplier = Movement->FallGravityMultiplier;
+			SavedTimeSinceLeftGround = Movement->TimeSinceLeftGround;
+			SavedWallConnectTimer = Movement->WallConnectTimer;
+			SavedWallNormal = Movement->CurrentWallNormal;
+		}
+	}
+
+	virtual void PrepMoveFor(ACharacter* C) override
+	{
+		Super::PrepMoveFor(C);
+
+		// restore the ability state this move started with so the replay matches the original simulation
+		if (UFPSCharacterMovementComponent* Movement = Cast<UFPSCharacterMovementComponent>(C->GetCharacterMovement()))
+		{
+			Movement->bHasDoubleJumped = bSavedHasDoubleJumped;
+			Movement->bHasDashed = bSavedHasDashed;
+			Movement->FallGravityMultiplier = SavedFallGravityMultiplier;
+			Movement->TimeSinceLeftGround = SavedTimeSinceLeftGround;
+			Movement->WallConnectTimer = SavedWallConnectTimer;
+			Movement->CurrentWallNormal = SavedWallNormal;
+		}
+	}
+};
+
+/**
+ *  Client prediction data for UFPSCharacterMovementComponent
+ */
+class FNetworkPredictionData_Client_FPSCharacter : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_FPSCharacter(const UCharacterMovementComponent& ClientMovement)
+		: Super(ClientMovement)
+	{
+	}
+
+	virtual FSavedMovePtr AllocateNewMove() override
+	{
+		return FSavedMovePtr(new FSavedMove_FPSCharacter());
+	}
+};
+
+////////////////////////////////////////////////////////////////////
+
+UFPSCharacterMovementComponent::UFPSCharacterMovementComponent()
+{
+	FallGravityMultiplier = FallGravityMultiplierMin;
+}
+
+void UFPSCharacterMovementComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	// pick up any edited minimum
+	FallGravityMultiplier = FallGravityMultiplierMin;
+}
+
+void UFPSCharacterMovementComponent::RequestDash()
+{
+	bWantsToDash = true;
+}
+
+bool UFPSCharacterMovementComponent::IsWallRunning() const
+{
+	return MovementMode == MOVE_Custom && CustomMovementMode == static_cast<uint8>(EFPSCustomMovementMode::WallRun);
+}
+
+bool UFPSCharacterMovementComponent::CanAirJump() const
+{
+	if (IsWallRunning())
+	{
+		return true;
+	}
+
+	if (IsMovingOnGround())
+	{
+		return false;
+	}
+
+	return FPSMovementKernel::CanKoyoteJump(TimeSinceLeftGround, KoyoteTime) || (!bHasDoubleJumped && IsFalling());
+}
+
+FPSMovementKernel::FBallisticParams UFPSCharacterMovementComponent::GetBallisticParams(float InGravityZ) const
+{
+	FPSMovementKernel::FBallisticParams Params;
+	Params.Gravity = FMath::Abs(InGravityZ);
+
+	// the ramp restarts whenever we start falling, so a launch from the ground starts at the minimum
+	Params.FallGravityStart = IsFalling() ? FallGravityMultiplier : FallGravityMultiplierMin;
+	Params.FallGravityScaler = FallGravityScaler;
+	Params.FallGravityMax = FallGravityMultiplierMax;
+
+	// without input we brake at the falling deceleration for the whole flight
+	Params.BrakingDeceleration = BrakingDecelerationFalling;
+
+	return Params;
+}
+
+FNetworkPredictionData_Client* UFPSCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UFPSCharacterMovementComponent* MutableThis = const_cast<UFPSCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_FPSCharacter(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UFPSCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToDash = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+void UFPSCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	// When on ground make sure the air abilities have been reset
+	if (IsMovingOnGround())
+	{
+		bHasDoubleJumped = false;
+		bHasDashed = false;
+		TimeSinceLeftGround = 0.f;
+	}
+	else
+	{
+		TimeSinceLeftGround += DeltaSeconds;
+	}
+
+	// the wall reconnect timer only runs while we're off the wall
+	if (!IsWallRunning())
+	{
+		WallConnectTimer += DeltaSeconds;
+	}
+
+	// consume the dash input
+	if (bWantsToDash)
+	{
+		bWantsToDash = false;
+
+		if (!bHasDashed && IsFalling())
+		{
+			bHasDashed = true;
+
+			FVector DashVelocity = UpdatedComponent->GetForwardVector() * DashPower;
+			DashVelocity.Z += DashUpwardBoost;
+
+			Velocity = DashVelocity;
+		}
+	}
+
+	// latch onto a wall if we're falling next to one
+	if (IsFalling() && WallConnectTimer >= WallReconnectDelay)
+	{
+		FHitResult WallHit;
+		if (FindWallRunSurface(WallHit))
+		{
+			StartWallRun(WallHit.ImpactNormal);
+		}
+	}
+}
+
+bool UFPSCharacterMovementComponent::DoJump(bool bReplayingMoves, float DeltaTime)
+{
+	if (!CharacterOwner)
+	{
+		return false;
+	}
+
+	// Jump off of Wall Run
+	if (IsWallRunning())
+	{
+		// Make sure the jump is not into the wall
+		const FVector Forward = FromKernel(FPSMovementKernel::WallJumpDirection(ToKernel(GetFlatControlForward()), ToKernel(CurrentWallNormal)));
+
+		Velocity = Forward * WallRunSpeed;
+		Velocity.Z = JumpZVelocity;
+
+		bHasDoubleJumped = false;
+		ConsumeKoyoteTime();
+		SetMovementMode(MOVE_Falling);
+		return true;
+	}
+
+	// Normal jump
+	if (IsMovingOnGround())
+	{
+		bHasDoubleJumped = false;
+		ConsumeKoyoteTime();
+		return Super::DoJump(bReplayingMoves, DeltaTime);
+	}
+
+	// Holding the button only sustains the jump we already did, air jumps need a fresh press
+	if (CharacterOwner->JumpKeyHoldTime > 0.f)
+	{
+		return Super::DoJump(bReplayingMoves, DeltaTime);
+	}
+
+	// Koyote jump
+	if (FPSMovementKernel::CanKoyoteJump(TimeSinceLeftGround, KoyoteTime))
+	{
+		Velocity.Z = JumpZVelocity;
+
+		bHasDoubleJumped = false;
+		ConsumeKoyoteTime();
+		SetMovementMode(MOVE_Falling);
+		return true;
+	}
+
+	// Double jump
+	if (!bHasDoubleJumped && IsFalling())
+	{
+		Velocity = FromKernel(FPSMovementKernel::DoubleJumpVelocity(ToKernel(GetFlatControlForward()), DoubleJumpForwardBoost, JumpZVelocity));
+
+		bHasDoubleJumped = true;
+		return true;
+	}
+
+	return false;
+}
+
+void UFPSCharacterMovementComponent::ConsumeKoyoteTime()
+{
+	// stays past the window until we touch the ground again
+	TimeSinceLeftGround = TNumericLimits<float>::Max();
+}
+
+bool UFPSCharacterMovementComponent::CanAttemptJump() const
+{
+	return Super::CanAttemptJump() || (IsJumpAllowed() && IsWallRunning());
+}
+
+float UFPSCharacterMovementComponent::GetMaxSpeed() const
+{
+	return IsWallRunning() ? WallRunSpeed : Super::GetMaxSpeed();
+}
+
+FVector UFPSCharacterMovementComponent::NewFallVelocity(const FVector& InitialVelocity, const FVector& Gravity, float DeltaTime) const
+{
+	// Handles additional gravity when player is falling
+	return Super::NewFallVelocity(InitialVelocity, Gravity - FVector(0.f, 0.f, FallGravityMultiplier), DeltaTime);
+}
+
+void UFPSCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	const bool bWasWallRunning = PreviousMovementMode == MOVE_Custom && PreviousCustomMode == static_cast<uint8>(EFPSCustomMovementMode::WallRun);
+
+	if (IsWallRunning() && !bWasWallRunning)
+	{
+		// Lock rotation so player WONT move with rotation while wall running
+		if (CharacterOwner)
+		{
+			bSavedUseControllerRotationYaw = CharacterOwner->bUseControllerRotationYaw;
+			CharacterOwner->bUseControllerRotationYaw = false;
+		}
+
+		bSavedOrientRotationToMovement = bOrientRotationToMovement;
+		bOrientRotationToMovement = false;
+
+	} else if (bWasWallRunning && !IsWallRunning()) {
+
+		WallConnectTimer = 0.f;
+
+		// Unlock rotation so player will move with camera
+		if (CharacterOwner)
+		{
+			CharacterOwner->bUseControllerRotationYaw = bSavedUseControllerRotationYaw;
+		}
+
+		bOrientRotationToMovement = bSavedOrientRotationToMovement;
+	}
+
+	// the falling gravity ramp restarts every time we start falling
+	if (!IsFalling())
+	{
+		FallGravityMultiplier = FallGravityMultiplierMin;
+	}
+}
+
+void UFPSCharacterMovementComponent::PhysFalling(float deltaTime, int32 Iterations)
+{
+	// ramp up the extra falling gravity
+	FPSMovementKernel::FFallGravityParams FallParams;
+	FallParams.Scaler = FallGravityScaler;
+	FallParams.Max = FallGravityMultiplierMax;
+
+	FallGravityMultiplier = FPSMovementKernel::StepFallGravity(FallGravityMultiplier, deltaTime, FallParams);
+
+	Super::PhysFalling(deltaTime, Iterations);
+}
+
+void UFPSCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
+{
+	switch (static_cast<EFPSCustomMovementMode>(CustomMovementMode))
+	{
+	case EFPSCustomMovementMode::WallRun:
+		PhysWallRun(deltaTime, Iterations);
+		break;
+
+	default:
+		Super::PhysCustom(deltaTime, Iterations);
+		break;
+	}
+}
+
+void UFPSCharacterMovementComponent::PhysWallRun(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	float RemainingTime = deltaTime;
+
+	while ((RemainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) && CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || (CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)))
+	{
+		++Iterations;
+		const float TimeTick = GetSimulationTimeStep(RemainingTime, Iterations);
+		RemainingTime -= TimeTick;
+
+		// drop off once there's no wall to run on
+		FHitResult WallHit;
+		if (!FindWallRunSurface(WallHit))
+		{
+			SetMovementMode(MOVE_Falling);
+			StartNewPhysics(RemainingTime + TimeTick, Iterations - 1);
+			return;
+		}
+
+		CurrentWallNormal = WallHit.ImpactNormal;
+
+		// run along the wall at wall run speed. Reduced gravity only sinks us a little each step and never accumulates
+		const FVector RunDirection = FVector::VectorPlaneProject(Velocity, CurrentWallNormal).GetSafeNormal2D();
+		Velocity = RunDirection * WallRunSpeed;
+		Velocity.Z = GetGravityZ() * WallRunGravityScale * TimeTick;
+
+		const FVector Delta = Velocity * TimeTick;
+
+		FHitResult Hit(1.f);
+		SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+
+		if (Hit.IsValidBlockingHit())
+		{
+			// did we run into the ground?
+			if (IsValidLandingSpot(UpdatedComponent->GetComponentLocation(), Hit))
+			{
+				RemainingTime += TimeTick * (1.f - Hit.Time);
+				ProcessLanded(Hit, RemainingTime, Iterations);
+				return;
+			}
+
+			HandleImpact(Hit, TimeTick, Delta);
+			SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
+		}
+	}
+}
+
+bool UFPSCharacterMovementComponent::FindWallRunSurface(FHitResult& OutHit) const
+{
+	const FVector Start = UpdatedComponent->GetComponentLocation();
+	const FVector RightVector = UpdatedComponent->GetRightVector();
+	const FVector EndRight = Start + (RightVector * WallCheckDistance);
+	const FVector EndLeft = Start - (RightVector * WallCheckDistance);
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(FPSWallRunProbe), false, CharacterOwner);
+
+	// Debug lines. Skipped while replaying moves, which would draw the same probes several times a frame
+	if (!CharacterOwner->bClientUpdating)
+	{
+		FPS_DEBUG_LINE(GetWorld(), WallRun, Start, EndRight, FColor::Blue);
+		FPS_DEBUG_LINE(GetWorld(), WallRun, Start, EndLeft, FColor::Red);
+	}
+
+	auto IsValidWall = [this](const FHitResult& Hit)
+		{
+			return Hit.GetActor() && Hit.GetActor()->ActorHasTag(WallRunTag);
+		};
+
+	// the right side wins if both sides have a wall
+	if (GetWorld()->LineTraceSingleByChannel(OutHit, Start, EndRight, ECC_Visibility, Params) && IsValidWall(OutHit))
+	{
+		return true;
+	}
+
+	return GetWorld()->LineTraceSingleByChannel(OutHit, Start, EndLeft, ECC_Visibility, Params) && IsValidWall(OutHit);
+}
+
+void UFPSCharacterMovementComponent::StartWallRun(const FVector& WallNormal)
+{
+	CurrentWallNormal = WallNormal;
+	bHasDashed = false;
+
+	Velocity = FVector::VectorPlaneProject(Velocity, WallNormal).GetSafeNormal() * WallRunSpeed;
+
+	SetMovementMode(MOVE_Custom, static_cast<uint8>(EFPSCustomMovementMode::WallRun));
+}
+
+FVector UFPSCharacterMovementComponent::GetFlatControlForward() const
+{
+	// the first person camera follows the control rotation, so this matches the camera facing
+	return FRotator(0.f, CharacterOwner->GetControlRotation().Yaw, 0.f).Vector();
+}
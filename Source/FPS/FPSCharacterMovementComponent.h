@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "FPSMovementKernel.h"
+#include "FPSCharacterMovementComponent.generated.h"
+
+class FSavedMove_FPSCharacter;
+
+/**
+ *  Custom movement modes handled by UFPSCharacterMovementComponent::PhysCustom
+ */
+UENUM(BlueprintType)
+enum class EFPSCustomMovementMode : uint8
+{
+	None		UMETA(Hidden),
+	WallRun		UMETA(DisplayName = "Wall Run"),
+	MAX			UMETA(Hidden)
+};
+
+/**
+ *  Character movement for AFPSCharacter
+ *  Simulates falling gravity, koyote time, double jump, dash and wall running inside the movement update
+ *  so they are sub-stepped with the rest of the movement and replayed during client prediction
+ */
+UCLASS()
+class FPS_API UFPSCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_FPSCharacter;
+
+	/** Moves tuning saved on the character before it lived here */
+	friend class AFPSCharacter;
+
+protected:
+
+	/** How fast the extra falling gravity ramps up, per second */
+	UPROPERTY(EditAnywhere, Category = "Falling")
+	float FallGravityScaler = 5.f;
+
+	/** Extra falling gravity applied as soon as we start falling */
+	UPROPERTY(EditAnywhere, Category = "Falling")
+	float FallGravityMultiplierMin = 10.f;
+
+	/** Max extra falling gravity */
+	UPROPERTY(EditAnywhere, Category = "Falling")
+	float FallGravityMultiplierMax = 100.f;
+
+	/** Time after leaving the ground during which we can still jump */
+	UPROPERTY(EditAnywhere, Category = "Jumping")
+	float KoyoteTime = .2f;
+
+	/** Forward speed added by the double jump */
+	UPROPERTY(EditAnywhere, Category = "Double Jump")
+	float DoubleJumpForwardBoost = 600.f;
+
+	/** Length of the side probes used to find walls to run on */
+	UPROPERTY(EditAnywhere, Category = "Wall Run")
+	float WallCheckDistance = 100.f;
+
+	/** Fraction of gravity applied while wall running */
+	UPROPERTY(EditAnywhere, Category = "Wall Run")
+	float WallRunGravityScale = .2f;
+
+	/** Speed along the wall while wall running */
+	UPROPERTY(EditAnywhere, Category = "Wall Run")
+	float WallRunSpeed = 600.f;
+
+	/** Time after leaving a wall before we can latch onto a wall again */
+	UPROPERTY(EditAnywhere, Category = "Wall Run", meta = (ClampMin = 0, Units = "s"))
+	float WallReconnectDelay = .1f;
+
+	/** Actor tag required on walls that can be run on */
+	UPROPERTY(EditAnywhere, Category = "Wall Run")
+	FName WallRunTag = FName("WallRun");
+
+	/** Forward speed of the dash */
+	UPROPERTY(EditAnywhere, Category = "Dash")
+	float DashPower = 100;
+
+	/** Vertical speed added by the dash */
+	UPROPERTY(EditAnywhere, Category = "Dash")
+	float DashUpwardBoost = 300.f;
+
+	/** Current extra falling gravity */
+	float FallGravityMultiplier = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Jumping")
+	float TimeSinceLeftGround = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Wall Run")
+	float WallConnectTimer = 0.f;
+
+	/** Normal of the wall we're currently running on */
+	FVector CurrentWallNormal = FVector::ZeroVector;
+
+	/** Rotation settings to restore once the wall run ends */
+	bool bSavedUseControllerRotationYaw = true;
+	bool bSavedOrientRotationToMovement = false;
+
+	bool bHasDoubleJumped = false;
+
+	bool bHasDashed = false;
+
+	/** Dash input for the next movement update. Sent to the server through the saved move flags */
+	bool bWantsToDash = false;
+
+public:
+
+	/** Constructor */
+	UFPSCharacterMovementComponent();
+
+	/** Requests a dash on the next movement update */
+	void RequestDash();
+
+	/** Returns true if we're currently running along a wall */
+	bool IsWallRunning() const;
+
+	/** Returns the normal of the wall we're running on */
+	const FVector& GetWallNormal() const { return CurrentWallNormal; }
+
+	/** Returns true if a jump is possible while airborne (wall jump, koyote jump or double jump) */
+	bool CanAirJump() const;
+
+	/**
+	 *  Returns the flight parameters used to solve launches for this character
+	 *  Takes the gravity so it can also be used on the class defaults, which have no world to read it from
+	 */
+	FPSMovementKernel::FBallisticParams GetBallisticParams(float InGravityZ) const;
+
+	/** Converts between engine vectors and the movement kernel vectors */
+	static FPSMovementKernel::FVec3 ToKernel(const FVector& V) { return FPSMovementKernel::FVec3{ float(V.X), float(V.Y), float(V.Z) }; }
+	static FVector FromKernel(const FPSMovementKernel::FVec3& V) { return FVector(V.X, V.Y, V.Z); }
+
+	//~Begin UCharacterMovementComponent interface
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual bool DoJump(bool bReplayingMoves, float DeltaTime) override;
+	virtual bool CanAttemptJump() const override;
+	virtual float GetMaxSpeed() const override;
+	virtual FVector NewFallVelocity(const FVector& InitialVelocity, const FVector& Gravity, float DeltaTime) const override;
+	//~End UCharacterMovementComponent interface
+
+protected:
+
+	//~Begin UCharacterMovementComponent interface
+	virtual void InitializeComponent() override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual void PhysFalling(float deltaTime, int32 Iterations) override;
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+	//~End UCharacterMovementComponent interface
+
+	/** Closes the koyote window after a jump, so it can't be used for a second one */
+	void ConsumeKoyoteTime();
+
+	/** Moves the character along the wall it's running on */
+	void PhysWallRun(float deltaTime, int32 Iterations);
+
+	/** Probes both sides of the character for a wall we can run on */
+	bool FindWallRunSurface(FHitResult& OutHit) const;
+
+	/** Latches onto the wall with the given normal */
+	void StartWallRun(const FVector& WallNormal);
+
+	/** Returns the control rotation forward vector flattened on the ground plane */
+	FVector GetFlatControlForward() const;
+};
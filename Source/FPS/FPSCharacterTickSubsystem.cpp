@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSCharacterTickSubsystem.h"
+#include "FPSCharacter.h"
+#include "FPSInteractionSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarAggregateCharacterTick(
+	TEXT("fps.CharacterTick.Aggregate"),
+	true,
+	TEXT("If true, FPSCharacters are updated in bulk by the character tick subsystem and their actor ticks are disabled.\n")
+	TEXT("If false, each character updates itself from its own actor tick."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Character Tick"), STAT_FPSCharacterTick, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Aggregated Characters"), STAT_FPSAggregatedCharacters, STATGROUP_FPS);
+
+void UFPSCharacterTickSubsystem::RegisterCharacter(AFPSCharacter* Character)
+{
+	if (CharacterIndices.Contains(Character))
+	{
+		return;
+	}
+
+	CharacterIndices.Add(Character, Characters.Num());
+	Characters.Add(Character);
+
+	ViewLocations.Add(Character->GetActorLocation());
+	ViewForwards.Add(Character->GetActorForwardVector());
+
+	// force a focus query on the first frame
+	FocusLocations.Add(FVector(TNumericLimits<float>::Max()));
+	FocusForwards.Add(FVector::ZeroVector);
+	FocusGenerations.Add(0);
+
+	FocusMoveThresholdsSquared.Add(FMath::Square(Character->FocusMoveThreshold));
+	FocusAngleThresholdsCos.Add(FMath::Cos(FMath::DegreesToRadians(Character->FocusAngleThreshold)));
+
+	NeedsFocusQuery.Add(true);
+
+	if (bAggregating && CanDisableActorTick(Character))
+	{
+		Character->SetActorTickEnabled(false);
+	}
+
+	SET_DWORD_STAT(STAT_FPSAggregatedCharacters, Characters.Num());
+}
+
+void UFPSCharacterTickSubsystem::UnregisterCharacter(AFPSCharacter* Character)
+{
+	int32 Index;
+	if (!CharacterIndices.RemoveAndCopyValue(Character, Index))
+	{
+		return;
+	}
+
+	// fill the gap with the last character
+	const int32 LastIndex = Characters.Num() - 1;
+	if (Index != LastIndex)
+	{
+		CharacterIndices[Characters[LastIndex]] = Index;
+	}
+
+	Characters.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	ViewLocations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	ViewForwards.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	FocusLocations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	FocusForwards.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	FocusGenerations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	FocusMoveThresholdsSquared.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	FocusAngleThresholdsCos.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	NeedsFocusQuery.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	SET_DWORD_STAT(STAT_FPSAggregatedCharacters, Characters.Num());
+}
+
+void UFPSCharacterTickSubsystem::TickCharacter(AFPSCharacter* Character)
+{
+	// the subsystem already took care of this character
+	if (bAggregating)
+	{
+		return;
+	}
+
+	const int32* Index = CharacterIndices.Find(Character);
+	if (!Index)
+	{
+		return;
+	}
+
+	UFPSInteractionSubsystem* Interaction = GetWorld()->GetSubsystem<UFPSInteractionSubsystem>();
+
+	GatherViews(*Index, 1);
+	TestFocusThresholds(*Index, 1, Interaction ? Interaction->GetGeneration() : 0);
+	ApplyCharacter(*Index, Interaction);
+}
+
+bool UFPSCharacterTickSubsystem::IsAggregationEnabled()
+{
+	return CVarAggregateCharacterTick.GetValueOnGameThread();
+}
+
+void UFPSCharacterTickSubsystem::Tick(float DeltaTime)
+{
+	// follow the cvar so it can be flipped at runtime for comparisons
+	if (bAggregating != IsAggregationEnabled())
+	{
+		SetAggregating(!bAggregating);
+	}
+
+	if (!bAggregating || Characters.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FPSCharacterTick);
+
+	UFPSInteractionSubsystem* Interaction = GetWorld()->GetSubsystem<UFPSInteractionSubsystem>();
+	const uint32 Generation = Interaction ? Interaction->GetGeneration() : 0;
+
+	// actor transforms have to be read on the game thread
+	GatherViews(0, Characters.Num());
+
+	TestFocusThresholds(0, Characters.Num(), Generation);
+
+	// traces, callbacks and debug draw stay on the game thread
+	for (int32 Index = 0; Index < Characters.Num(); ++Index)
+	{
+		ApplyCharacter(Index, Interaction);
+	}
+}
+
+TStatId UFPSCharacterTickSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSCharacterTickSubsystem, STATGROUP_Tickables);
+}
+
+void UFPSCharacterTickSubsystem::GatherViews(int32 First, int32 Count)
+{
+	for (int32 Index = First; Index < First + Count; ++Index)
+	{
+		const FTransform& Transform = Characters[Index]->GetActorTransform();
+
+		ViewLocations[Index] = Transform.GetLocation();
+		ViewForwards[Index] = Transform.GetUnitAxis(EAxis::X);
+	}
+}
+
+void UFPSCharacterTickSubsystem::TestFocusThresholds(int32 First, int32 Count, uint32 Generation)
+{
+	for (int32 Index = First; Index < First + Count; ++Index)
+	{
+		const bool bMoved = FVector::DistSquared(ViewLocations[Index], FocusLocations[Index]) > FocusMoveThresholdsSquared[Index];
+		const bool bTurned = FVector::DotProduct(ViewForwards[Index], FocusForwards[Index]) < FocusAngleThresholdsCos[Index];
+
+		NeedsFocusQuery[Index] = bMoved || bTurned || Generation != FocusGenerations[Index];
+	}
+}
+
+void UFPSCharacterTickSubsystem::ApplyCharacter(int32 Index, UFPSInteractionSubsystem* Interaction)
+{
+	AFPSCharacter* Character = Characters[Index];
+
+	Character->DebugFunc();
+
+	if (!Interaction)
+	{
+		return;
+	}
+
+	// the confirm trace result is consumed before the new query, same as the actor tick did
+	Character->ConsumeInteractionProbe();
+
+	if (NeedsFocusQuery[Index])
+	{
+		FocusLocations[Index] = ViewLocations[Index];
+		FocusForwards[Index] = ViewForwards[Index];
+
+		// read before the query so registry changes caused by our own focus callbacks trigger a requery next frame
+		FocusGenerations[Index] = Interaction->GetGeneration();
+		Character->UpdateFocus(Interaction, ViewLocations[Index], ViewForwards[Index]);
+	}
+}
+
+void UFPSCharacterTickSubsystem::SetAggregating(bool bEnable)
+{
+	bAggregating = bEnable;
+
+	for (AFPSCharacter* Character : Characters)
+	{
+		if (CanDisableActorTick(Character))
+		{
+			Character->SetActorTickEnabled(!bEnable);
+		}
+	}
+}
+
+bool UFPSCharacterTickSubsystem::CanDisableActorTick(const AFPSCharacter* Character)
+{
+	// blueprint tick events still need the actor tick
+	return !Character->GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AActor, ReceiveTick));
+}
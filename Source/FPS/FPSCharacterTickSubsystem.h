@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSCharacterTickSubsystem.generated.h"
+
+class AFPSCharacter;
+class UFPSInteractionSubsystem;
+
+/**
+ *  Runs the per frame work of every AFPSCharacter in the world from a single tick
+ *  Per character state is kept in parallel arrays so the focus requery test runs as one tight loop.
+ *  While aggregation is enabled the characters' own actor ticks are turned off
+ */
+UCLASS()
+class FPS_API UFPSCharacterTickSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Registered characters. Every array below is indexed the same way */
+	UPROPERTY()
+	TArray<TObjectPtr<AFPSCharacter>> Characters;
+
+	/** View location and facing gathered this frame */
+	TArray<FVector> ViewLocations;
+	TArray<FVector> ViewForwards;
+
+	/** View location and facing the focus was last queried with */
+	TArray<FVector> FocusLocations;
+	TArray<FVector> FocusForwards;
+
+	/** Interaction registry generation the focus was last queried with */
+	TArray<uint32> FocusGenerations;
+
+	/** Focus requery thresholds, cached from the character when it registers */
+	TArray<float> FocusMoveThresholdsSquared;
+	TArray<float> FocusAngleThresholdsCos;
+
+	/** Set by the threshold test when the focus needs to be queried again */
+	TArray<uint8> NeedsFocusQuery;
+
+	/** Index of each character in the arrays */
+	TMap<AFPSCharacter*, int32> CharacterIndices;
+
+	/** Aggregation state the registered characters' actor ticks were last set up for */
+	bool bAggregating = false;
+
+public:
+
+	/** Adds a character to the arrays */
+	void RegisterCharacter(AFPSCharacter* Character);
+
+	/** Removes a character from the arrays */
+	void UnregisterCharacter(AFPSCharacter* Character);
+
+	/** Runs a single character's frame. Called from the character's own tick while aggregation is disabled */
+	void TickCharacter(AFPSCharacter* Character);
+
+	/** Returns true if characters should be updated in bulk instead of through their actor ticks */
+	static bool IsAggregationEnabled();
+
+	//~Begin FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End FTickableGameObject interface
+
+protected:
+
+	/** Reads the view of a range of characters */
+	void GatherViews(int32 First, int32 Count);
+
+	/** Flags the characters in a range that moved, turned or saw the registry change since their last focus query */
+	void TestFocusThresholds(int32 First, int32 Count, uint32 Generation);
+
+	/** Runs the game thread work of a single character */
+	void ApplyCharacter(int32 Index, UFPSInteractionSubsystem* Interaction);
+
+	/** Turns the registered characters' actor ticks on or off to match the aggregation state */
+	void SetAggregating(bool bEnable);
+
+	/** Returns true if this character's actor tick can be turned off without skipping blueprint logic */
+	static bool CanDisableActorTick(const AFPSCharacter* Character);
+};
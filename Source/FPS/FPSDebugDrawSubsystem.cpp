@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSDebugDrawSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+#if FPS_DEBUG_DRAW
+
+static TAutoConsoleVariable<bool> CVarDebugDrawCharacter(
+	TEXT("fps.DebugDraw.Character"),
+	true,
+	TEXT("Draws the FPSCharacter facing line."),
+	ECVF_Cheat);
+
+static TAutoConsoleVariable<bool> CVarDebugDrawWallRun(
+	TEXT("fps.DebugDraw.WallRun"),
+	true,
+	TEXT("Draws the wall run side probes."),
+	ECVF_Cheat);
+
+static TAutoConsoleVariable<bool> CVarDebugDrawInteraction(
+	TEXT("fps.DebugDraw.Interaction"),
+	true,
+	TEXT("Draws the interaction focus confirm traces."),
+	ECVF_Cheat);
+
+#endif
+
+void UFPSDebugDrawSubsystem::AddLine(const UWorld* World, EFPSDebugDrawCategory Category, const FVector& Start, const FVector& End, const FColor& Color)
+{
+#if FPS_DEBUG_DRAW
+	if (!World || World->IsNetMode(NM_DedicatedServer) || !IsCategoryEnabled(Category))
+	{
+		return;
+	}
+
+	if (UFPSDebugDrawSubsystem* Subsystem = World->GetSubsystem<UFPSDebugDrawSubsystem>())
+	{
+		// zero lifetime lines are drawn for a single frame
+		Subsystem->PendingLines.Emplace(Start, End, FLinearColor(Color), 0.f, 1.f, SDPG_World);
+	}
+#endif
+}
+
+bool UFPSDebugDrawSubsystem::IsCategoryEnabled(EFPSDebugDrawCategory Category)
+{
+#if FPS_DEBUG_DRAW
+	switch (Category)
+	{
+	case EFPSDebugDrawCategory::Character:
+		return CVarDebugDrawCharacter.GetValueOnGameThread();
+
+	case EFPSDebugDrawCategory::WallRun:
+		return CVarDebugDrawWallRun.GetValueOnGameThread();
+
+	case EFPSDebugDrawCategory::Interaction:
+		return CVarDebugDrawInteraction.GetValueOnGameThread();
+	}
+#endif
+
+	return false;
+}
+
+bool UFPSDebugDrawSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if FPS_DEBUG_DRAW
+	return Super::ShouldCreateSubsystem(Outer);
+#else
+	return false;
+#endif
+}
+
+void UFPSDebugDrawSubsystem::Tick(float DeltaTime)
+{
+	if (PendingLines.Num() == 0)
+	{
+		return;
+	}
+
+	// hand the whole frame over in one call
+	if (ULineBatchComponent* LineBatcher = GetWorld()->GetLineBatcher(UWorld::ELineBatcherType::World))
+	{
+		LineBatcher->DrawLines(PendingLines);
+	}
+
+	PendingLines.Reset();
+}
+
+TStatId UFPSDebugDrawSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSDebugDrawSubsystem, STATGROUP_Tickables);
+}
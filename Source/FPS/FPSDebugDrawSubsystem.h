@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/LineBatchComponent.h"
+#include "FPSDebugDrawSubsystem.generated.h"
+
+/** Debug drawing is compiled out of builds without debug draw and of dedicated server builds */
+#define FPS_DEBUG_DRAW (ENABLE_DRAW_DEBUG && !UE_SERVER)
+
+/** Diagnostic categories, each toggled by its own fps.DebugDraw cvar */
+enum class EFPSDebugDrawCategory : uint8
+{
+	Character,
+	WallRun,
+	Interaction
+};
+
+#if FPS_DEBUG_DRAW
+	/** Queues a single frame debug line. Arguments aren't evaluated in builds without debug draw */
+	#define FPS_DEBUG_LINE(World, Category, Start, End, Color) UFPSDebugDrawSubsystem::AddLine(World, EFPSDebugDrawCategory::Category, Start, End, Color)
+#else
+	#define FPS_DEBUG_LINE(World, Category, Start, End, Color)
+#endif
+
+/**
+ *  Collects every diagnostic line drawn during the frame and hands them to the world line batcher in one go
+ *  Categories are gated by cvars, and nothing is queued on dedicated servers
+ */
+UCLASS()
+class FPS_API UFPSDebugDrawSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Lines queued this frame */
+	TArray<FBatchedLine> PendingLines;
+
+public:
+
+	/** Queues a line for this frame if its category is enabled */
+	static void AddLine(const UWorld* World, EFPSDebugDrawCategory Category, const FVector& Start, const FVector& End, const FColor& Color);
+
+	/** Returns true if the category's cvar is enabled */
+	static bool IsCategoryEnabled(EFPSDebugDrawCategory Category);
+
+	//~Begin UWorldSubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	//~End UWorldSubsystem interface
+
+	//~Begin FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End FTickableGameObject interface
+};
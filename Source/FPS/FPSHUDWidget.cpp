@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSHUDWidget.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "FPS.h"
+
+DECLARE_CYCLE_STAT(TEXT("HUD Repaint"), STAT_FPSHUDRepaint, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD Repaints/Frame"), STAT_FPSHUDRepaints, STATGROUP_FPS);
+
+void UFPSHUDWidget::MarkHUDDirty()
+{
+	if (bRepaintPending)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+
+	if (!World)
+	{
+		return;
+	}
+
+	bRepaintPending = true;
+	World->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &UFPSHUDWidget::FlushHUD));
+}
+
+void UFPSHUDWidget::FlushHUD()
+{
+	bRepaintPending = false;
+
+	SCOPE_CYCLE_COUNTER(STAT_FPSHUDRepaint);
+	INC_DWORD_STAT(STAT_FPSHUDRepaints);
+
+	RepaintHUD();
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "FPSHUDWidget.generated.h"
+
+/**
+ *  Base class for HUD widgets driven by a native model.
+ *  Gameplay code pushes values into the model, which only marks the widget dirty when a value actually changes.
+ *  Dirty widgets are repainted once on the next frame, no matter how many updates they received,
+ *  so the Blueprint events become cosmetic hooks instead of running on every gameplay update
+ */
+UCLASS(abstract)
+class FPS_API UFPSHUDWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+private:
+
+	/** Set while a repaint is scheduled for the next frame */
+	bool bRepaintPending = false;
+
+protected:
+
+	/** Schedules a repaint for the next frame, unless one is already pending */
+	void MarkHUDDirty();
+
+	/** Pushes the dirty parts of the model to the sub-widgets and Blueprint. Called at most once per frame */
+	virtual void RepaintHUD() {}
+
+private:
+
+	/** Runs the scheduled repaint */
+	void FlushHUD();
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "FPSInteractable.generated.h"
+
+class AFPSCharacter;
+
+// This class does not need to be modified.
+UINTERFACE(MinimalAPI)
+class UFPSInteractable : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ *  Common interface for actors the FPS character can interact with
+ *  Calls are dispatched by the actor's UInteractableComponent
+ */
+class FPS_API IFPSInteractable
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Called when a character starts looking at this interactable */
+	virtual void OnFocusGained(AFPSCharacter* Character) {}
+
+	/** Called when a character stops looking at this interactable */
+	virtual void OnFocusLost(AFPSCharacter* Character) {}
+
+	/** Called when a character presses interact while looking at this interactable */
+	virtual void Interact(AFPSCharacter* Character) {}
+};
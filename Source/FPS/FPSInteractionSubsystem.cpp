@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSInteractionSubsystem.h"
+#include "InteractableComponent.h"
+#include "FPS.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interaction Focus Queries"), STAT_FPSInteractionFocusQueries, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Interaction Focus Queries/s"), STAT_FPSInteractionFocusQueriesPerSecond, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Interactables"), STAT_FPSInteractables, STATGROUP_FPS);
+
+void UFPSInteractionSubsystem::RegisterInteractable(UInteractableComponent* Interactable)
+{
+	Interactables.Update(Interactable, Interactable->GetInteractLocation());
+	MaxInteractRadius = FMath::Max(MaxInteractRadius, Interactable->GetInteractRadius());
+
+	++Generation;
+	SET_DWORD_STAT(STAT_FPSInteractables, Interactables.Num());
+}
+
+void UFPSInteractionSubsystem::UnregisterInteractable(UInteractableComponent* Interactable)
+{
+	if (Interactables.Remove(Interactable))
+	{
+		// the largest radius may have just left, so shrink the lookups back down
+		if (Interactable->GetInteractRadius() >= MaxInteractRadius)
+		{
+			MaxInteractRadius = 0.f;
+			Interactables.ForEachElement([this](UInteractableComponent* Other)
+				{
+					MaxInteractRadius = FMath::Max(MaxInteractRadius, Other->GetInteractRadius());
+				});
+		}
+
+		++Generation;
+		SET_DWORD_STAT(STAT_FPSInteractables, Interactables.Num());
+	}
+}
+
+void UFPSInteractionSubsystem::UpdateInteractable(UInteractableComponent* Interactable)
+{
+	Interactables.Update(Interactable, Interactable->GetInteractLocation());
+	++Generation;
+}
+
+UInteractableComponent* UFPSInteractionSubsystem::FindFocus(const FVector& ViewLocation, const FVector& ViewDirection, float MaxDistance)
+{
+	INC_DWORD_STAT(STAT_FPSInteractionFocusQueries);
+	++WindowFocusQueries;
+
+	UInteractableComponent* BestInteractable = nullptr;
+	double BestDistance = TNumericLimits<double>::Max();
+
+	// look up everything that could touch the view ray
+	const FVector QueryCenter = ViewLocation + ViewDirection * (MaxDistance * .5f);
+	const float QueryRadius = MaxDistance * .5f + MaxInteractRadius;
+
+	Interactables.ForEachInRadius(QueryCenter, QueryRadius, [&](UInteractableComponent* Interactable, const FVector& Location)
+		{
+			// closest point on the view ray
+			const double AlongRay = FMath::Clamp(FVector::DotProduct(Location - ViewLocation, ViewDirection), 0.0, double(MaxDistance));
+			const FVector ClosestPoint = ViewLocation + ViewDirection * AlongRay;
+
+			if (AlongRay < BestDistance && FVector::DistSquared(ClosestPoint, Location) <= FMath::Square(Interactable->GetInteractRadius()))
+			{
+				BestInteractable = Interactable;
+				BestDistance = AlongRay;
+			}
+		});
+
+	return BestInteractable;
+}
+
+void UFPSInteractionSubsystem::Tick(float DeltaTime)
+{
+	// publish the queries per second once a second
+	WindowTime += DeltaTime;
+
+	if (WindowTime >= 1.f)
+	{
+		SET_DWORD_STAT(STAT_FPSInteractionFocusQueriesPerSecond, FMath::RoundToInt32(WindowFocusQueries / WindowTime));
+
+		WindowFocusQueries = 0;
+		WindowTime = 0.f;
+	}
+}
+
+TStatId UFPSInteractionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSInteractionSubsystem, STATGROUP_Tickables);
+}
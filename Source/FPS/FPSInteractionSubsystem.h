@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSpatialHash.h"
+#include "FPSInteractionSubsystem.generated.h"
+
+class UInteractableComponent;
+
+/**
+ *  Keeps every interactable in the world in a spatial hash so characters can find what they're looking at
+ *  without tracing every frame. A generation counter lets characters know when their cached focus may be stale
+ */
+UCLASS()
+class FPS_API UFPSInteractionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Registered interactables */
+	TFPSSpatialHash<UInteractableComponent*> Interactables;
+
+	/** Largest focus radius among the registered interactables, used to widen the hash lookups */
+	float MaxInteractRadius = 0.f;
+
+	/** Bumped every time an interactable is added, removed or moved */
+	uint32 Generation = 0;
+
+	/** Focus queries since the stat window started */
+	int32 WindowFocusQueries = 0;
+
+	/** Time accumulated in the current stat window */
+	float WindowTime = 0.f;
+
+public:
+
+	/** Adds an interactable to the hash */
+	void RegisterInteractable(UInteractableComponent* Interactable);
+
+	/** Removes an interactable from the hash */
+	void UnregisterInteractable(UInteractableComponent* Interactable);
+
+	/** Refreshes an interactable's location in the hash */
+	void UpdateInteractable(UInteractableComponent* Interactable);
+
+	/**
+	 *  Returns the closest interactable whose focus radius is crossed by the view ray
+	 *  @param ViewLocation		Start of the view ray
+	 *  @param ViewDirection	Normalized view direction
+	 *  @param MaxDistance		Length of the view ray
+	 */
+	UInteractableComponent* FindFocus(const FVector& ViewLocation, const FVector& ViewDirection, float MaxDistance);
+
+	/** Returns the registry generation. Changes whenever a cached focus may be stale */
+	uint32 GetGeneration() const { return Generation; }
+
+	//~Begin FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End FTickableGameObject interface
+};
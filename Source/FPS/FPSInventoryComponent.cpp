@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSInventoryComponent.h"
+#include "GameFramework/Actor.h"
+
+UFPSInventoryComponent::UFPSInventoryComponent()
+{
+	// the inventory only changes on grants and switches, we never need to tick
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// size the slots before the owner's BeginPlay can grant items
+	bWantsInitializeComponent = true;
+}
+
+void UFPSInventoryComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	Slots.SetNum(NumSlots);
+}
+
+int32 UFPSInventoryComponent::AddItem(AActor* Item)
+{
+	if (!Item || ClassSlots.Contains(Item->GetClass()))
+	{
+		return INDEX_NONE;
+	}
+
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		if (!Slots[SlotIndex].IsOccupied())
+		{
+			Slots[SlotIndex].Item = Item;
+			ClassSlots.Add(Item->GetClass(), SlotIndex);
+			++NumItems;
+
+			return SlotIndex;
+		}
+	}
+
+	// inventory is full
+	return INDEX_NONE;
+}
+
+void UFPSInventoryComponent::RemoveItem(int32 SlotIndex)
+{
+	FFPSInventorySlot* Slot = GetSlot(SlotIndex);
+
+	if (!Slot || !Slot->IsOccupied())
+	{
+		return;
+	}
+
+	ClassSlots.Remove(Slot->Item->GetClass());
+	*Slot = FFPSInventorySlot();
+	--NumItems;
+
+	if (CurrentSlot == SlotIndex)
+	{
+		CurrentSlot = INDEX_NONE;
+	}
+}
+
+int32 UFPSInventoryComponent::FindSlotByClass(const UClass* ItemClass) const
+{
+	const int32* SlotIndex = ClassSlots.Find(ItemClass);
+	return SlotIndex ? *SlotIndex : INDEX_NONE;
+}
+
+AActor* UFPSInventoryComponent::FindItemByClass(const UClass* ItemClass) const
+{
+	return GetItem(FindSlotByClass(ItemClass));
+}
+
+bool UFPSInventoryComponent::Contains(const AActor* Item) const
+{
+	return Item && GetItem(FindSlotByClass(Item->GetClass())) == Item;
+}
+
+FFPSInventorySlot* UFPSInventoryComponent::GetSlot(int32 SlotIndex)
+{
+	return Slots.IsValidIndex(SlotIndex) ? &Slots[SlotIndex] : nullptr;
+}
+
+const FFPSInventorySlot* UFPSInventoryComponent::GetSlot(int32 SlotIndex) const
+{
+	return Slots.IsValidIndex(SlotIndex) ? &Slots[SlotIndex] : nullptr;
+}
+
+AActor* UFPSInventoryComponent::GetItem(int32 SlotIndex) const
+{
+	const FFPSInventorySlot* Slot = GetSlot(SlotIndex);
+	return Slot ? Slot->Item.Get() : nullptr;
+}
+
+void UFPSInventoryComponent::SetCurrentSlot(int32 SlotIndex)
+{
+	const FFPSInventorySlot* Slot = GetSlot(SlotIndex);
+
+	if (Slot && Slot->IsOccupied())
+	{
+		CurrentSlot = SlotIndex;
+	}
+}
+
+int32 UFPSInventoryComponent::GetNextSlot() const
+{
+	const int32 NumSlotsToCheck = Slots.Num();
+	const int32 StartSlot = CurrentSlot == INDEX_NONE ? NumSlotsToCheck - 1 : CurrentSlot;
+
+	// walk the ring once, starting after the equipped slot
+	for (int32 Offset = 1; Offset <= NumSlotsToCheck; ++Offset)
+	{
+		const int32 SlotIndex = (StartSlot + Offset) % NumSlotsToCheck;
+
+		if (Slots[SlotIndex].IsOccupied())
+		{
+			return SlotIndex == CurrentSlot ? INDEX_NONE : SlotIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
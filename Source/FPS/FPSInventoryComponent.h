@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "FPSInventoryComponent.generated.h"
+
+class UAnimInstance;
+
+/**
+ *  Item held in an inventory slot, along with the data needed to equip it
+ *  The equip data is resolved once when the item is granted, so switching to the slot doesn't query the item
+ */
+USTRUCT()
+struct FFPSInventorySlot
+{
+	GENERATED_BODY()
+
+	/** Item in the slot. Null if the slot is empty */
+	UPROPERTY()
+	TObjectPtr<AActor> Item;
+
+	/** Anim instance class to set on the first person mesh while the item is equipped */
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> FirstPersonAnimClass;
+
+	/** Anim instance class to set on the third person mesh while the item is equipped */
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> ThirdPersonAnimClass;
+
+	/** Anim layers to link into the first person mesh while the item is equipped. Takes priority over the anim instance class */
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> FirstPersonAnimLayers;
+
+	/** Anim layers to link into the third person mesh while the item is equipped. Takes priority over the anim instance class */
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> ThirdPersonAnimLayers;
+
+	/** Magazine size shown on the HUD while the item is equipped */
+	int32 MagazineSize = 0;
+
+	/** Returns true if the slot holds an item */
+	bool IsOccupied() const { return Item != nullptr; }
+};
+
+/**
+ *  Fixed size item inventory shared by the character hierarchies
+ *  Items are indexed by their exact class, so ownership checks don't scan the inventory,
+ *  and switching walks the occupied slots in ring order
+ */
+UCLASS(ClassGroup = (FPS), meta = (BlueprintSpawnableComponent))
+class FPS_API UFPSInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Number of slots in the inventory */
+	UPROPERTY(EditAnywhere, Category = "Inventory", meta = (ClampMin = 1, ClampMax = 16))
+	int32 NumSlots = 4;
+
+	/** Inventory slots. Sized to NumSlots when the component is initialized */
+	UPROPERTY()
+	TArray<FFPSInventorySlot> Slots;
+
+	/** Slot holding each item class */
+	TMap<UClass*, int32> ClassSlots;
+
+	/** Slot of the equipped item */
+	int32 CurrentSlot = INDEX_NONE;
+
+	/** Number of occupied slots */
+	int32 NumItems = 0;
+
+public:
+
+	/** Constructor */
+	UFPSInventoryComponent();
+
+	//~Begin UActorComponent interface
+	virtual void InitializeComponent() override;
+	//~End UActorComponent interface
+
+	/**
+	 *  Adds an item to the first free slot
+	 *  @return the slot index, or INDEX_NONE if the inventory is full or already holds an item of the same class
+	 */
+	int32 AddItem(AActor* Item);
+
+	/** Empties a slot. Clears the equipped slot if it was the one removed */
+	void RemoveItem(int32 SlotIndex);
+
+	/** Returns the slot holding an item of exactly this class, or INDEX_NONE */
+	int32 FindSlotByClass(const UClass* ItemClass) const;
+
+	/** Returns the item of exactly this class, or nullptr */
+	AActor* FindItemByClass(const UClass* ItemClass) const;
+
+	/** Returns true if the item is in the inventory */
+	bool Contains(const AActor* Item) const;
+
+	/** Returns a slot, or nullptr if the index is out of range */
+	FFPSInventorySlot* GetSlot(int32 SlotIndex);
+	const FFPSInventorySlot* GetSlot(int32 SlotIndex) const;
+
+	/** Returns the item in a slot, or nullptr */
+	AActor* GetItem(int32 SlotIndex) const;
+
+	/** Returns the slot of the equipped item, or INDEX_NONE */
+	int32 GetCurrentSlot() const { return CurrentSlot; }
+
+	/** Returns the equipped item, or nullptr */
+	AActor* GetCurrentItem() const { return GetItem(CurrentSlot); }
+
+	/** Returns the equipped item cast to the passed class */
+	template<typename T>
+	T* GetCurrentItem() const { return Cast<T>(GetCurrentItem()); }
+
+	/** Sets the equipped slot. Empty slots are ignored */
+	void SetCurrentSlot(int32 SlotIndex);
+
+	/** Returns the next occupied slot after the equipped one, wrapping around, or INDEX_NONE if there is nothing else to switch to */
+	int32 GetNextSlot() const;
+
+	/** Returns the number of items in the inventory */
+	int32 Num() const { return NumItems; }
+
+	/** Returns true if every slot is occupied */
+	bool IsFull() const { return NumItems >= Slots.Num(); }
+};
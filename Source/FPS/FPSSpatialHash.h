@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Uniform grid of elements bucketed by location
+ *  Elements must be hashable and unique. Lookups only visit the cells overlapping the query
+ */
+template<typename ElementType>
+class TFPSSpatialHash
+{
+public:
+
+	explicit TFPSSpatialHash(float InCellSize = 200.f)
+	{
+		SetCellSize(InCellSize);
+	}
+
+	/** Changes the cell size. Only valid while the hash is empty */
+	void SetCellSize(float InCellSize)
+	{
+		check(ElementCells.Num() == 0);
+
+		CellSize = FMath::Max(InCellSize, 1.f);
+		InvCellSize = 1.f / CellSize;
+	}
+
+	/** Adds an element at the given location */
+	void Add(ElementType Element, const FVector& Location)
+	{
+		const FIntVector Cell = GetCell(Location);
+
+		ElementCells.Add(Element, Cell);
+		Cells.FindOrAdd(Cell).Add(FEntry{ Element, Location });
+	}
+
+	/** Removes an element. Returns false if it wasn't in the hash */
+	bool Remove(ElementType Element)
+	{
+		FIntVector Cell;
+		if (!ElementCells.RemoveAndCopyValue(Element, Cell))
+		{
+			return false;
+		}
+
+		RemoveFromCell(Element, Cell);
+		return true;
+	}
+
+	/** Moves an element to a new location, adding it if needed */
+	void Update(ElementType Element, const FVector& Location)
+	{
+		const FIntVector NewCell = GetCell(Location);
+
+		if (FIntVector* OldCell = ElementCells.Find(Element))
+		{
+			// still in the same cell, just refresh the location
+			if (*OldCell == NewCell)
+			{
+				for (FEntry& Entry : Cells.FindChecked(NewCell))
+				{
+					if (Entry.Element == Element)
+					{
+						Entry.Location = Location;
+						return;
+					}
+				}
+			}
+
+			RemoveFromCell(Element, *OldCell);
+			*OldCell = NewCell;
+		}
+		else
+		{
+			ElementCells.Add(Element, NewCell);
+		}
+
+		Cells.FindOrAdd(NewCell).Add(FEntry{ Element, Location });
+	}
+
+	/** Calls Func(Element, Location) for every element within Radius of Center */
+	template<typename FuncType>
+	void ForEachInRadius(const FVector& Center, float Radius, FuncType&& Func) const
+	{
+		const FIntVector MinCell = GetCell(Center - FVector(Radius));
+		const FIntVector MaxCell = GetCell(Center + FVector(Radius));
+		const double RadiusSquared = FMath::Square(Radius);
+
+		for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+				{
+					const TArray<FEntry>* Entries = Cells.Find(FIntVector(X, Y, Z));
+					if (!Entries)
+					{
+						continue;
+					}
+
+					for (const FEntry& Entry : *Entries)
+					{
+						if (FVector::DistSquared(Entry.Location, Center) <= RadiusSquared)
+						{
+							Func(Entry.Element, Entry.Location);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/** Calls Func(Element) for every element in the hash */
+	template<typename FuncType>
+	void ForEachElement(FuncType&& Func) const
+	{
+		for (const TPair<ElementType, FIntVector>& Pair : ElementCells)
+		{
+			Func(Pair.Key);
+		}
+	}
+
+	/** Returns true if the element is in the hash */
+	bool Contains(ElementType Element) const { return ElementCells.Contains(Element); }
+
+	/** Returns the number of elements in the hash */
+	int32 Num() const { return ElementCells.Num(); }
+
+	/** Removes every element */
+	void Reset()
+	{
+		Cells.Reset();
+		ElementCells.Reset();
+	}
+
+private:
+
+	struct FEntry
+	{
+		ElementType Element;
+		FVector Location;
+	};
+
+	FIntVector GetCell(const FVector& Location) const
+	{
+		return FIntVector(
+			FMath::FloorToInt32(Location.X * InvCellSize),
+			FMath::FloorToInt32(Location.Y * InvCellSize),
+			FMath::FloorToInt32(Location.Z * InvCellSize));
+	}
+
+	void RemoveFromCell(ElementType Element, const FIntVector& Cell)
+	{
+		TArray<FEntry>& Entries = Cells.FindChecked(Cell);
+		Entries.RemoveAllSwap([&Element](const FEntry& Entry) { return Entry.Element == Element; }, EAllowShrinking::No);
+
+		// drop empty cells so lookups stay fast
+		if (Entries.Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+
+	/** Elements in each occupied cell */
+	TMap<FIntVector, TArray<FEntry>> Cells;
+
+	/** Cell each element is in */
+	TMap<ElementType, FIntVector> ElementCells;
+
+	float CellSize = 200.f;
+	float InvCellSize = 1.f / 200.f;
+};
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSSubsystemTickFunction.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+
+void FFPSSubsystemTickFunction::Register(UWorld* World, ETickingGroup Group, FName InDiagnosticName, TFunction<void(float)>&& InOnTick)
+{
+	OnTick = MoveTemp(InOnTick);
+	DiagnosticName = InDiagnosticName;
+
+	bCanEverTick = true;
+	bStartWithTickEnabled = true;
+	bTickEvenWhenPaused = false;
+	TickGroup = Group;
+
+	RegisterTickFunction(World->PersistentLevel);
+}
+
+void FFPSSubsystemTickFunction::Unregister()
+{
+	if (IsTickFunctionRegistered())
+	{
+		UnRegisterTickFunction();
+	}
+
+	OnTick.Reset();
+}
+
+void FFPSSubsystemTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	// only run gameplay work while the world is actually ticking
+	if (TickType != LEVELTICK_ViewportsOnly && OnTick)
+	{
+		OnTick(DeltaTime);
+	}
+}
+
+FString FFPSSubsystemTickFunction::DiagnosticMessage()
+{
+	return DiagnosticName.ToString();
+}
+
+FName FFPSSubsystemTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return DiagnosticName;
+}
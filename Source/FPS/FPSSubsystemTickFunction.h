@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "FPSSubsystemTickFunction.generated.h"
+
+/**
+ *  Tick function owned by a world subsystem
+ *  Unlike FTickableGameObject it runs in a chosen tick group and can take part in tick dependencies,
+ *  so subsystems can order their batched work against movement, physics and each other
+ */
+USTRUCT()
+struct FPS_API FFPSSubsystemTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Called when the tick function runs */
+	TFunction<void(float)> OnTick;
+
+	/** Name reported by tick diagnostics */
+	FName DiagnosticName;
+
+	/**
+	 *  Registers the tick function with the world's persistent level
+	 *  @param World				World to tick in
+	 *  @param Group				Tick group to run in
+	 *  @param InDiagnosticName		Name reported by tick diagnostics
+	 *  @param InOnTick				Called every time the tick function runs
+	 */
+	void Register(UWorld* World, ETickingGroup Group, FName InDiagnosticName, TFunction<void(float)>&& InOnTick);
+
+	/** Unregisters the tick function and drops the callback */
+	void Unregister();
+
+	//~Begin FTickFunction interface
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+	//~End FTickFunction interface
+};
+
+template<>
+struct TStructOpsTypeTraits<FFPSSubsystemTickFunction> : public TStructOpsTypeTraitsBase2<FFPSSubsystemTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSTickBudgetSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarTickBudgetEnabled(
+	TEXT("fps.TickBudget.Enable"),
+	true,
+	TEXT("If true, the tick budget subsystem throttles the ticks of the actor classes listed in FPSTickBudgetSettings."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Tick Budget Significance Update"), STAT_FPSTickBudgetUpdate, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Tick Budget Managed Actors"), STAT_FPSTickBudgetManagedActors, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Tick Budget Disabled Actor Ticks"), STAT_FPSTickBudgetDisabledTicks, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Tick Budget Throttled Actors"), STAT_FPSTickBudgetThrottledActors, STATGROUP_FPS);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Tick Budget Actor Ticks Saved/Frame"), STAT_FPSTickBudgetTicksSaved, STATGROUP_FPS);
+
+void UFPSTickBudgetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	Buckets.SetNum(GetDefault<UFPSTickBudgetSettings>()->ClassBudgets.Num());
+
+	if (Buckets.Num() == 0)
+	{
+		return;
+	}
+
+	// pick up the actors already in the level, then everything spawned later
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		RegisterActor(*It);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UFPSTickBudgetSubsystem::RegisterActor));
+}
+
+void UFPSTickBudgetSubsystem::Deinitialize()
+{
+	if (ActorSpawnedHandle.IsValid())
+	{
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+		ActorSpawnedHandle.Reset();
+	}
+
+	Buckets.Reset();
+	DisabledActors.Reset();
+
+	SET_DWORD_STAT(STAT_FPSTickBudgetManagedActors, 0);
+	SET_DWORD_STAT(STAT_FPSTickBudgetDisabledTicks, 0);
+	SET_DWORD_STAT(STAT_FPSTickBudgetThrottledActors, 0);
+	SET_FLOAT_STAT(STAT_FPSTickBudgetTicksSaved, 0.f);
+
+	Super::Deinitialize();
+}
+
+void UFPSTickBudgetSubsystem::RegisterActor(AActor* Actor)
+{
+	// nothing to manage if the actor never ticks
+	if (!Actor || !Actor->PrimaryActorTick.bCanEverTick || !CVarTickBudgetEnabled.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	const TArray<FFPSTickBudgetClass>& ClassBudgets = GetDefault<UFPSTickBudgetSettings>()->ClassBudgets;
+
+	for (int32 BudgetIndex = 0; BudgetIndex < ClassBudgets.Num(); ++BudgetIndex)
+	{
+		if (!ClassBudgets[BudgetIndex].ActorClass || !Actor->IsA(ClassBudgets[BudgetIndex].ActorClass))
+		{
+			continue;
+		}
+
+		// budgeted classes have no native tick work, so without a blueprint tick there's nothing to run
+		if (!Actor->GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AActor, ReceiveTick)))
+		{
+			Actor->SetActorTickEnabled(false);
+
+			DisabledActors.Add(Actor);
+			SET_DWORD_STAT(STAT_FPSTickBudgetDisabledTicks, DisabledActors.Num());
+			return;
+		}
+
+		Buckets[BudgetIndex].Actors.Add(Actor);
+		return;
+	}
+}
+
+void UFPSTickBudgetSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+
+	if (TimeSinceUpdate < GetDefault<UFPSTickBudgetSettings>()->UpdateInterval)
+	{
+		return;
+	}
+
+	TimeSinceUpdate = 0.f;
+
+	if (CVarTickBudgetEnabled.GetValueOnGameThread())
+	{
+		UpdateSignificance(DeltaTime);
+	}
+}
+
+TStatId UFPSTickBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSTickBudgetSubsystem, STATGROUP_Tickables);
+}
+
+void UFPSTickBudgetSubsystem::UpdateSignificance(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPSTickBudgetUpdate);
+
+	TArray<FVector> ViewLocations;
+	TArray<FVector> ViewForwards;
+	GatherViews(ViewLocations, ViewForwards);
+
+	const TArray<FFPSTickBudgetClass>& ClassBudgets = GetDefault<UFPSTickBudgetSettings>()->ClassBudgets;
+
+	int32 ManagedActors = 0;
+	int32 ThrottledActors = 0;
+	float TicksSaved = 0.f;
+
+	// scratch reused by every bucket
+	TArray<TPair<float, AActor*>> Scored;
+
+	for (int32 BudgetIndex = 0; BudgetIndex < Buckets.Num() && BudgetIndex < ClassBudgets.Num(); ++BudgetIndex)
+	{
+		const FFPSTickBudgetClass& Budget = ClassBudgets[BudgetIndex];
+		TArray<TWeakObjectPtr<AActor>>& Actors = Buckets[BudgetIndex].Actors;
+
+		Actors.RemoveAllSwap([](const TWeakObjectPtr<AActor>& Actor) { return !Actor.IsValid(); }, EAllowShrinking::No);
+
+		// score by squared distance to the closest viewer, lower is more significant
+		Scored.Reset();
+
+		for (const TWeakObjectPtr<AActor>& Actor : Actors)
+		{
+			const FVector Location = Actor->GetActorLocation();
+
+			float ClosestDistanceSquared = ViewLocations.Num() > 0 ? TNumericLimits<float>::Max() : 0.f;
+			for (const FVector& ViewLocation : ViewLocations)
+			{
+				ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, float(FVector::DistSquared(Location, ViewLocation)));
+			}
+
+			Scored.Emplace(ClosestDistanceSquared, Actor.Get());
+		}
+
+		Scored.Sort([](const TPair<float, AActor*>& A, const TPair<float, AActor*>& B) { return A.Key < B.Key; });
+
+		const float FarDistanceSquared = FMath::Square(Budget.FarDistance);
+
+		for (int32 Rank = 0; Rank < Scored.Num(); ++Rank)
+		{
+			AActor* Actor = Scored[Rank].Value;
+
+			// the budget lets the top actors tick every frame, every extra group of actors ticks one frame slower
+			float Interval = (Rank / FMath::Max(Budget.TicksPerFrame, 1)) * DeltaTime;
+
+			if (Scored[Rank].Key > FarDistanceSquared)
+			{
+				Interval = FMath::Max(Interval, Budget.FarTickInterval);
+			}
+
+			if (!IsVisibleToPlayers(Actor, ViewLocations, ViewForwards))
+			{
+				Interval = FMath::Max(Interval, Budget.HiddenTickInterval);
+			}
+
+			Interval = FMath::Min(Interval, Budget.MaxTickInterval);
+
+			if (!FMath::IsNearlyEqual(Actor->GetActorTickInterval(), Interval))
+			{
+				Actor->SetActorTickInterval(Interval);
+			}
+
+			// a frame's worth of interval still ticks every frame
+			if (Interval > DeltaTime)
+			{
+				++ThrottledActors;
+				TicksSaved += 1.f - DeltaTime / Interval;
+			}
+		}
+
+		ManagedActors += Scored.Num();
+	}
+
+	// destroyed actors no longer save anything
+	DisabledActors.RemoveAllSwap([](const TWeakObjectPtr<AActor>& Actor) { return !Actor.IsValid(); }, EAllowShrinking::No);
+
+	SET_DWORD_STAT(STAT_FPSTickBudgetManagedActors, ManagedActors);
+	SET_DWORD_STAT(STAT_FPSTickBudgetDisabledTicks, DisabledActors.Num());
+	SET_DWORD_STAT(STAT_FPSTickBudgetThrottledActors, ThrottledActors);
+	SET_FLOAT_STAT(STAT_FPSTickBudgetTicksSaved, TicksSaved + DisabledActors.Num());
+}
+
+bool UFPSTickBudgetSubsystem::IsVisibleToPlayers(const AActor* Actor, TConstArrayView<FVector> ViewLocations, TConstArrayView<FVector> ViewForwards) const
+{
+	// listen servers and clients render, so they know what was on screen
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		return Actor->WasRecentlyRendered(.2f);
+	}
+
+	// a dedicated server never renders anything, so settle for being in front of a player
+	const float ViewConeCos = FMath::Cos(FMath::DegreesToRadians(GetDefault<UFPSTickBudgetSettings>()->ViewConeHalfAngle));
+	const FVector Location = Actor->GetActorLocation();
+
+	for (int32 Index = 0; Index < ViewLocations.Num(); ++Index)
+	{
+		const FVector ViewDir = (Location - ViewLocations[Index]).GetSafeNormal();
+
+		if (FVector::DotProduct(ViewDir, ViewForwards[Index]) >= ViewConeCos)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UFPSTickBudgetSubsystem::GatherViews(TArray<FVector>& OutViewLocations, TArray<FVector>& OutViewForwards) const
+{
+	// clients only care about their own players, the server about everyone
+	const bool bIsServer = GetWorld()->GetNetMode() != NM_Client;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+
+		if (PlayerController && (bIsServer || PlayerController->IsLocalController()))
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			OutViewLocations.Add(ViewLocation);
+			OutViewForwards.Add(ViewRotation.Vector());
+		}
+	}
+}
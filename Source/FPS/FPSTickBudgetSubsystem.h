@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSTickBudgetSubsystem.generated.h"
+
+/**
+ *  Tick budget for a class of actors
+ */
+USTRUCT()
+struct FFPSTickBudgetClass
+{
+	GENERATED_BODY()
+
+	/** Actors of this class and its subclasses are managed by this budget */
+	UPROPERTY(EditAnywhere, Category = "Tick Budget")
+	TSubclassOf<AActor> ActorClass;
+
+	/** Actor ticks the class may spend per frame. The most significant actors tick every frame and the rest are spread out */
+	UPROPERTY(EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 1))
+	int32 TicksPerFrame = 8;
+
+	/** Actors further than this from every viewer tick at FarTickInterval or slower */
+	UPROPERTY(EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 0, Units = "cm"))
+	float FarDistance = 3000.f;
+
+	UPROPERTY(EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 0, Units = "s"))
+	float FarTickInterval = .25f;
+
+	/** Actors that weren't rendered recently tick at this interval or slower */
+	UPROPERTY(EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 0, Units = "s"))
+	float HiddenTickInterval = .5f;
+
+	/** Slowest tick interval the budget may push an actor to */
+	UPROPERTY(EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 0, Units = "s"))
+	float MaxTickInterval = 1.f;
+};
+
+/**
+ *  Tick budget configuration, read from the [/Script/FPS.FPSTickBudgetSettings] section of DefaultGame.ini
+ */
+UCLASS(config = Game, defaultconfig)
+class FPS_API UFPSTickBudgetSettings : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Managed actor classes. The first entry an actor's class matches is used */
+	UPROPERTY(config, EditAnywhere, Category = "Tick Budget")
+	TArray<FFPSTickBudgetClass> ClassBudgets;
+
+	/** Time between significance updates */
+	UPROPERTY(config, EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 0, Units = "s"))
+	float UpdateInterval = .25f;
+
+	/** Half angle of the player view cone actors have to be in to count as visible on a dedicated server, where nothing is rendered */
+	UPROPERTY(config, EditAnywhere, Category = "Tick Budget", meta = (ClampMin = 0, ClampMax = 180, Units = "deg"))
+	float ViewConeHalfAngle = 60.f;
+};
+
+/**
+ *  Scores actors of the budgeted classes by distance and visibility to the players and throttles their ticks to fit the budget
+ *  Managed actors whose blueprint doesn't implement Tick have their actor tick turned off entirely, since they have no tick work
+ */
+UCLASS()
+class FPS_API UFPSTickBudgetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Actors managed by a single class budget */
+	struct FBudgetBucket
+	{
+		TArray<TWeakObjectPtr<AActor>> Actors;
+	};
+
+	/** One bucket per entry in UFPSTickBudgetSettings::ClassBudgets */
+	TArray<FBudgetBucket> Buckets;
+
+	/** Handle for the actor spawned callback */
+	FDelegateHandle ActorSpawnedHandle;
+
+	/** Time since the last significance update */
+	float TimeSinceUpdate = 0.f;
+
+	/** Managed actors whose ticks were turned off. Only the live ones count towards the stats */
+	TArray<TWeakObjectPtr<AActor>> DisabledActors;
+
+public:
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+	//~Begin FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End FTickableGameObject interface
+
+protected:
+
+	/** Starts managing the actor if its class has a budget */
+	void RegisterActor(AActor* Actor);
+
+	/** Scores the actors in every bucket and updates their tick intervals */
+	void UpdateSignificance(float DeltaTime);
+
+	/** Returns the view locations and directions of the players we're scoring against */
+	void GatherViews(TArray<FVector>& OutViewLocations, TArray<FVector>& OutViewForwards) const;
+
+	/** Returns true if the actor was rendered recently, or is in view of a player on a dedicated server */
+	bool IsVisibleToPlayers(const AActor* Actor, TConstArrayView<FVector> ViewLocations, TConstArrayView<FVector> ViewForwards) const;
+};
@@ -0,0 +1,443 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSTimerSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "TimerManager.h"
+#include "FPS.h"
+
+DECLARE_CYCLE_STAT(TEXT("Timing Wheel Advance"), STAT_FPSTimingWheelAdvance, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Timing Wheel Timers"), STAT_FPSTimingWheelTimers, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Timing Wheel Timers Fired/Frame"), STAT_FPSTimingWheelFired, STATGROUP_FPS);
+
+FFPSTimingWheel::FFPSTimingWheel(double InResolution, double StartTime)
+{
+	Resolution = FMath::Max(InResolution, UE_DOUBLE_KINDA_SMALL_NUMBER);
+	InvResolution = 1.0 / Resolution;
+
+	Reset(StartTime);
+}
+
+void FFPSTimingWheel::Reset(double StartTime)
+{
+	Timers.Reset();
+	Expiring.Reset();
+
+	for (int32 Level = 0; Level < NumLevels; ++Level)
+	{
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			Heads[Level][Slot] = INDEX_NONE;
+		}
+	}
+
+	FirstFree = INDEX_NONE;
+	Origin = StartTime;
+	CurrentTime = StartTime;
+	NextTick = 0;
+	NumActive = 0;
+}
+
+FFPSTimerHandle FFPSTimingWheel::SetTimer(FSimpleDelegate&& Delegate, float Delay)
+{
+	// reuse a free node if there is one
+	int32 Index = FirstFree;
+
+	if (Index != INDEX_NONE)
+	{
+		FirstFree = Timers[Index].Next;
+
+	} else {
+
+		Index = Timers.AddDefaulted();
+	}
+
+	// fire on the first tick at or after the due time, but never on a tick that has already been processed
+	const int64 MaxDelta = (int64(1) << (SlotBits * NumLevels)) - 1;
+	const int64 DueTick = FMath::CeilToInt64((CurrentTime + FMath::Max(Delay, 0.0f) - Origin) * InvResolution);
+
+	FTimer& Timer = Timers[Index];
+	Timer.Delegate = MoveTemp(Delegate);
+	Timer.DueTick = FMath::Clamp(DueTick, NextTick, NextTick + MaxDelta);
+
+	Link(Index);
+	++NumActive;
+
+	FFPSTimerHandle Handle;
+	Handle.Index = Index;
+	Handle.Serial = Timer.Serial;
+
+	return Handle;
+}
+
+bool FFPSTimingWheel::ClearTimer(FFPSTimerHandle& Handle)
+{
+	if (!IsTimerActive(Handle))
+	{
+		Handle.Invalidate();
+		return false;
+	}
+
+	// timers in the expiring batch are already out of their slot, freeing them is enough to skip them
+	if (Timers[Handle.Index].Level >= 0)
+	{
+		Unlink(Handle.Index);
+	}
+
+	Free(Handle.Index);
+	Handle.Invalidate();
+
+	return true;
+}
+
+bool FFPSTimingWheel::IsTimerActive(const FFPSTimerHandle& Handle) const
+{
+	return Timers.IsValidIndex(Handle.Index) && Timers[Handle.Index].Serial == Handle.Serial && Timers[Handle.Index].Level != INDEX_NONE;
+}
+
+void FFPSTimingWheel::Advance(double Time)
+{
+	CurrentTime = FMath::Max(CurrentTime, Time);
+
+	const int64 TargetTick = FMath::FloorToInt64((CurrentTime - Origin) * InvResolution);
+
+	while (NextTick <= TargetTick)
+	{
+		const int32 Slot = int32(NextTick & (NumSlots - 1));
+
+		// when the finest level wraps around, bring the next coarse slot down. Keep going up while the coarser levels wrap too
+		if (Slot == 0)
+		{
+			for (int32 Level = 1; Level < NumLevels && Cascade(Level) == 0; ++Level)
+			{
+			}
+		}
+
+		// take the whole slot out in one go, so callbacks can set and clear timers freely
+		Expiring.Reset();
+
+		for (int32 Index = Heads[0][Slot]; Index != INDEX_NONE; Index = Timers[Index].Next)
+		{
+			Expiring.Add(Index);
+			Timers[Index].Level = ExpiringLevel;
+		}
+
+		Heads[0][Slot] = INDEX_NONE;
+
+		++NextTick;
+
+		for (int32 ExpiringIndex = 0; ExpiringIndex < Expiring.Num(); ++ExpiringIndex)
+		{
+			const int32 Index = Expiring[ExpiringIndex];
+
+			// an earlier callback in the batch may have cleared this timer, and maybe reused its node
+			if (Timers[Index].Level != ExpiringLevel)
+			{
+				continue;
+			}
+
+			// free the node before calling out, since the callback may set new timers that reuse it
+			FSimpleDelegate Delegate = MoveTemp(Timers[Index].Delegate);
+			Free(Index);
+
+			++NumFired;
+			Delegate.ExecuteIfBound();
+		}
+	}
+}
+
+void FFPSTimingWheel::Link(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+	const int64 Delta = Timer.DueTick - NextTick;
+
+	// timers due within one turn of the finest level go straight into their tick's slot
+	int32 Level = 0;
+
+	while (Level < NumLevels - 1 && Delta >= (int64(1) << (SlotBits * (Level + 1))))
+	{
+		++Level;
+	}
+
+	const int32 Slot = int32((Timer.DueTick >> (SlotBits * Level)) & (NumSlots - 1));
+
+	Timer.Level = int16(Level);
+	Timer.Slot = int16(Slot);
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = Heads[Level][Slot];
+
+	if (Timer.Next != INDEX_NONE)
+	{
+		Timers[Timer.Next].Prev = Index;
+	}
+
+	Heads[Level][Slot] = Index;
+}
+
+void FFPSTimingWheel::Unlink(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+
+	if (Timer.Prev != INDEX_NONE)
+	{
+		Timers[Timer.Prev].Next = Timer.Next;
+
+	} else {
+
+		Heads[Timer.Level][Timer.Slot] = Timer.Next;
+	}
+
+	if (Timer.Next != INDEX_NONE)
+	{
+		Timers[Timer.Next].Prev = Timer.Prev;
+	}
+
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = INDEX_NONE;
+	Timer.Level = INDEX_NONE;
+}
+
+int32 FFPSTimingWheel::Cascade(int32 Level)
+{
+	const int32 Slot = int32((NextTick >> (SlotBits * Level)) & (NumSlots - 1));
+
+	int32 Index = Heads[Level][Slot];
+	Heads[Level][Slot] = INDEX_NONE;
+
+	// relink every timer of the slot. They're now close enough to land in a finer level
+	while (Index != INDEX_NONE)
+	{
+		const int32 Next = Timers[Index].Next;
+
+		Link(Index);
+		Index = Next;
+	}
+
+	return Slot;
+}
+
+void FFPSTimingWheel::Free(int32 Index)
+{
+	FTimer& Timer = Timers[Index];
+
+	Timer.Delegate.Unbind();
+	Timer.Level = INDEX_NONE;
+
+	// zero marks a handle that was never set
+	if (++Timer.Serial == 0)
+	{
+		Timer.Serial = 1;
+	}
+
+	Timer.Next = FirstFree;
+	FirstFree = Index;
+
+	--NumActive;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ *  Same timer workload run through a timing wheel and an FTimerManager
+ */
+struct FFPSTimerBenchmark
+{
+	FFPSTimingWheel Wheel;
+	FTimerManager TimerManager;
+
+	TArray<FFPSTimerHandle> WheelHandles;
+	TArray<FTimerHandle> ManagerHandles;
+
+	/** Separate streams with the same seed, so both schedulers get the same delays */
+	FRandomStream WheelStream;
+	FRandomStream ManagerStream;
+
+	int32 Count = 0;
+	int32 Frames = 0;
+	int32 Frame = 0;
+	double Time = 0.0;
+
+	double WheelInsertSeconds = 0.0;
+	double ManagerInsertSeconds = 0.0;
+	double WheelCancelSeconds = 0.0;
+	double ManagerCancelSeconds = 0.0;
+	double WheelTickSeconds = 0.0;
+	double ManagerTickSeconds = 0.0;
+
+	uint64 WheelFired = 0;
+	uint64 ManagerFired = 0;
+
+	static constexpr float StepTime = 1.0f / 60.0f;
+
+	FFPSTimerBenchmark(int32 InCount, int32 InFrames)
+		: Wheel(StepTime)
+		, WheelStream(InCount)
+		, ManagerStream(InCount)
+		, Count(InCount)
+		, Frames(InFrames)
+	{
+		WheelHandles.SetNum(Count);
+		ManagerHandles.SetNum(Count);
+
+		double Start = FPlatformTime::Seconds();
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			ArmWheel(Index);
+		}
+
+		WheelInsertSeconds = FPlatformTime::Seconds() - Start;
+		Start = FPlatformTime::Seconds();
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			ArmManager(Index);
+		}
+
+		ManagerInsertSeconds = FPlatformTime::Seconds() - Start;
+
+		// cancel and rearm every other timer, like pickups and projectiles cut short by gameplay
+		Start = FPlatformTime::Seconds();
+
+		for (int32 Index = 0; Index < Count; Index += 2)
+		{
+			Wheel.ClearTimer(WheelHandles[Index]);
+			ArmWheel(Index);
+		}
+
+		WheelCancelSeconds = FPlatformTime::Seconds() - Start;
+		Start = FPlatformTime::Seconds();
+
+		for (int32 Index = 0; Index < Count; Index += 2)
+		{
+			TimerManager.ClearTimer(ManagerHandles[Index]);
+			ArmManager(Index);
+		}
+
+		ManagerCancelSeconds = FPlatformTime::Seconds() - Start;
+	}
+
+	/** Steps both schedulers by one frame. Returns true once every frame has run */
+	bool Step()
+	{
+		Time += StepTime;
+
+		double Start = FPlatformTime::Seconds();
+		Wheel.Advance(Time);
+		WheelTickSeconds += FPlatformTime::Seconds() - Start;
+
+		// the timer manager only ticks once per engine frame, which is why the benchmark is spread over frames
+		Start = FPlatformTime::Seconds();
+		TimerManager.Tick(StepTime);
+		ManagerTickSeconds += FPlatformTime::Seconds() - Start;
+
+		return ++Frame >= Frames;
+	}
+
+	void ArmWheel(int32 Index)
+	{
+		WheelHandles[Index] = Wheel.SetTimer(FSimpleDelegate::CreateRaw(this, &FFPSTimerBenchmark::OnWheelTimer, Index), WheelStream.FRandRange(0.1f, 10.0f));
+	}
+
+	void ArmManager(int32 Index)
+	{
+		TimerManager.SetTimer(ManagerHandles[Index], FTimerDelegate::CreateRaw(this, &FFPSTimerBenchmark::OnManagerTimer, Index), ManagerStream.FRandRange(0.1f, 10.0f), false);
+	}
+
+	void OnWheelTimer(int32 Index)
+	{
+		++WheelFired;
+		ArmWheel(Index);
+	}
+
+	void OnManagerTimer(int32 Index)
+	{
+		++ManagerFired;
+		ArmManager(Index);
+	}
+
+	void Log() const
+	{
+		UE_LOG(LogFPS, Display, TEXT("Timer benchmark: %d live timers, %d frames"), Count, Frames);
+		UE_LOG(LogFPS, Display, TEXT("Timer benchmark: timing wheel    insert %.3f ms, cancel+rearm %.3f ms, tick %.4f ms/frame, %llu fired"),
+			WheelInsertSeconds * 1000.0, WheelCancelSeconds * 1000.0, WheelTickSeconds * 1000.0 / Frames, WheelFired);
+		UE_LOG(LogFPS, Display, TEXT("Timer benchmark: FTimerManager   insert %.3f ms, cancel+rearm %.3f ms, tick %.4f ms/frame, %llu fired"),
+			ManagerInsertSeconds * 1000.0, ManagerCancelSeconds * 1000.0, ManagerTickSeconds * 1000.0 / Frames, ManagerFired);
+	}
+};
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTimerBenchmark(
+	TEXT("fps.Timers.Benchmark"),
+	TEXT("Runs the same one-shot timer workload through a timing wheel and an FTimerManager over the next frames and logs the cost of each.\n")
+	TEXT("Usage: fps.Timers.Benchmark [Count=10000] [Frames=300]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UFPSTimerSubsystem* TimerSubsystem = World ? World->GetSubsystem<UFPSTimerSubsystem>() : nullptr;
+
+		if (!TimerSubsystem)
+		{
+			UE_LOG(LogFPS, Warning, TEXT("fps.Timers.Benchmark needs a game world"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		const int32 Frames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 300;
+
+		TimerSubsystem->StartBenchmark(FMath::Max(Count, 1), FMath::Max(Frames, 1));
+	}));
+
+void UFPSTimerSubsystem::StartBenchmark(int32 Count, int32 Frames)
+{
+	Benchmark = MakeShared<FFPSTimerBenchmark>(Count, Frames);
+}
+#endif
+
+void UFPSTimerSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// turn the wheel after the frame's gameplay, where FTimerManager runs its timers
+	TickFunction.Register(&InWorld, TG_PostUpdateWork, TEXT("FPSTimerSubsystem"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UFPSTimerSubsystem::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Wheel.Reset(0.0);
+
+#if !UE_BUILD_SHIPPING
+	Benchmark.Reset();
+#endif
+
+	Super::Deinitialize();
+}
+
+FFPSTimerHandle UFPSTimerSubsystem::SetTimer(FSimpleDelegate&& Delegate, float Delay)
+{
+	return Wheel.SetTimer(MoveTemp(Delegate), Delay);
+}
+
+void UFPSTimerSubsystem::Tick(float DeltaTime)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FPSTimingWheelAdvance);
+
+		const uint64 FiredBefore = Wheel.GetNumFired();
+
+		Wheel.Advance(GetWorld()->GetTimeSeconds());
+
+		INC_DWORD_STAT_BY(STAT_FPSTimingWheelFired, Wheel.GetNumFired() - FiredBefore);
+		SET_DWORD_STAT(STAT_FPSTimingWheelTimers, Wheel.Num());
+	}
+
+#if !UE_BUILD_SHIPPING
+	if (Benchmark.IsValid() && Benchmark->Step())
+	{
+		Benchmark->Log();
+		Benchmark.Reset();
+	}
+#endif
+}
@@ -0,0 +1,194 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSubsystemTickFunction.h"
+#include "FPSTimerSubsystem.generated.h"
+
+struct FFPSTimerBenchmark;
+
+/**
+ *  Handle to a timer in a timing wheel
+ *  Stays safe to use after the timer has fired or been cleared
+ */
+struct FFPSTimerHandle
+{
+	/** Returns true if the handle was ever set. The timer may have fired since */
+	bool IsValid() const { return Serial != 0; }
+
+	/** Forgets the timer without clearing it */
+	void Invalidate() { Index = INDEX_NONE; Serial = 0; }
+
+private:
+
+	friend class FFPSTimingWheel;
+
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+};
+
+/**
+ *  Hierarchical timing wheel
+ *  Time is split into fixed ticks. Timers due within the next 64 ticks sit in the slot of their tick, later ones sit
+ *  in coarser levels and cascade down as the wheel turns. Setting and clearing a timer are O(1),
+ *  and every timer due on a tick is expired in one batch
+ */
+class FPS_API FFPSTimingWheel
+{
+public:
+
+	/** Number of bits of the tick indexing the slots of each level */
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+
+	/**
+	 *  @param InResolution		Length of a wheel tick in seconds. Timers fire on the first tick at or after their due time
+	 *  @param StartTime		Time the wheel starts turning from
+	 */
+	explicit FFPSTimingWheel(double InResolution = 1.0 / 60.0, double StartTime = 0.0);
+
+	/** Starts a one-shot timer. Delays beyond the wheel's range are clamped to it */
+	FFPSTimerHandle SetTimer(FSimpleDelegate&& Delegate, float Delay);
+
+	/** Clears a timer and invalidates the handle. Returns true if the timer was still pending */
+	bool ClearTimer(FFPSTimerHandle& Handle);
+
+	/** Returns true if the timer hasn't fired or been cleared yet */
+	bool IsTimerActive(const FFPSTimerHandle& Handle) const;
+
+	/** Turns the wheel up to the given time, firing every timer that came due */
+	void Advance(double Time);
+
+	/** Clears every timer */
+	void Reset(double StartTime);
+
+	/** Returns the number of pending timers */
+	int32 Num() const { return NumActive; }
+
+	/** Returns the number of timers fired since the wheel was created */
+	uint64 GetNumFired() const { return NumFired; }
+
+private:
+
+	/** Timer node, linked into the slot it's waiting in */
+	struct FTimer
+	{
+		FSimpleDelegate Delegate;
+		int64 DueTick = 0;
+
+		/** Neighbours in the slot list, or the next free node */
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+
+		/** Bumped every time the node is freed, so stale handles don't match */
+		uint32 Serial = 1;
+
+		/** Level of the slot list the timer is linked into. INDEX_NONE while free, ExpiringLevel while in the expiring batch */
+		int16 Level = INDEX_NONE;
+		int16 Slot = INDEX_NONE;
+	};
+
+	/** Level marking timers taken out of their slot to be fired */
+	static constexpr int16 ExpiringLevel = -2;
+
+	/** Links a timer into the slot matching its due tick */
+	void Link(int32 Index);
+
+	/** Unlinks a timer from its slot */
+	void Unlink(int32 Index);
+
+	/** Moves the timers of a coarse slot down to the finer levels. Returns the slot index */
+	int32 Cascade(int32 Level);
+
+	/** Returns a node to the free list */
+	void Free(int32 Index);
+
+	/** Timer nodes, reused through the free list */
+	TArray<FTimer> Timers;
+
+	/** First node of each slot list */
+	int32 Heads[NumLevels][NumSlots];
+
+	/** First free node */
+	int32 FirstFree = INDEX_NONE;
+
+	/** Timers expiring on the current tick. Kept around to avoid reallocating */
+	TArray<int32> Expiring;
+
+	double Resolution = 1.0 / 60.0;
+	double InvResolution = 60.0;
+	double Origin = 0.0;
+
+	/** Time the wheel was last advanced to */
+	double CurrentTime = 0.0;
+
+	/** Next tick to process */
+	int64 NextTick = 0;
+
+	int32 NumActive = 0;
+	uint64 NumFired = 0;
+};
+
+/**
+ *  Runs a timing wheel on game time for deferred gameplay actions such as respawns and deferred destruction
+ *  Meant for large numbers of one-shot timers, which would otherwise each go through the FTimerManager heap
+ */
+UCLASS()
+class FPS_API UFPSTimerSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Pending timers */
+	FFPSTimingWheel Wheel;
+
+	/** Turns the wheel once per frame */
+	FFPSSubsystemTickFunction TickFunction;
+
+#if !UE_BUILD_SHIPPING
+	/** Benchmark in progress, if any */
+	TSharedPtr<FFPSTimerBenchmark> Benchmark;
+#endif
+
+public:
+
+	/** Starts a one-shot timer calling a delegate after Delay seconds of game time */
+	FFPSTimerHandle SetTimer(FSimpleDelegate&& Delegate, float Delay);
+
+	/** Starts a one-shot timer calling a member function after Delay seconds of game time. Skipped if the object has been destroyed */
+	template<typename UserClass>
+	FFPSTimerHandle SetTimer(UserClass* Object, void (UserClass::*Func)(), float Delay)
+	{
+		return SetTimer(FSimpleDelegate::CreateUObject(Object, Func), Delay);
+	}
+
+	/** Clears a timer and invalidates the handle */
+	void ClearTimer(FFPSTimerHandle& Handle) { Wheel.ClearTimer(Handle); }
+
+	/** Returns true if the timer hasn't fired or been cleared yet */
+	bool IsTimerActive(const FFPSTimerHandle& Handle) const { return Wheel.IsTimerActive(Handle); }
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 *  Runs the same workload through a private timing wheel and a private FTimerManager over the next frames, and logs the results.
+	 *  Every timer that fires is rearmed with a new random delay, so the number of live timers stays constant
+	 *  @param Count	Number of live timers
+	 *  @param Frames	Number of frames to run. Both schedulers are stepped 1/60s per frame
+	 */
+	void StartBenchmark(int32 Count, int32 Frames);
+#endif
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Fires the timers that came due this frame */
+	void Tick(float DeltaTime);
+};
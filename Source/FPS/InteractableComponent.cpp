@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "InteractableComponent.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "FPSInteractable.h"
+#include "FPSInteractionSubsystem.h"
+
+UInteractableComponent::UInteractableComponent()
+{
+	// registration is event driven, we never need to tick
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UInteractableComponent::SetAnchor(USceneComponent* NewAnchor)
+{
+	Anchor = NewAnchor;
+}
+
+void UInteractableComponent::SetInteractionEnabled(bool bEnabled)
+{
+	if (bInteractionEnabled == bEnabled)
+	{
+		return;
+	}
+
+	bInteractionEnabled = bEnabled;
+
+	if (HasBegunPlay())
+	{
+		UpdateRegistration();
+	}
+}
+
+FVector UInteractableComponent::GetInteractLocation() const
+{
+	if (const USceneComponent* AnchorComponent = GetAnchor())
+	{
+		return AnchorComponent->GetComponentLocation();
+	}
+
+	return FVector::ZeroVector;
+}
+
+void UInteractableComponent::NotifyFocusGained(AFPSCharacter* Character)
+{
+	if (Interactable)
+	{
+		Interactable->OnFocusGained(Character);
+	}
+}
+
+void UInteractableComponent::NotifyFocusLost(AFPSCharacter* Character)
+{
+	if (Interactable)
+	{
+		Interactable->OnFocusLost(Character);
+	}
+}
+
+void UInteractableComponent::Interact(AFPSCharacter* Character)
+{
+	if (Interactable && bInteractionEnabled)
+	{
+		Interactable->Interact(Character);
+	}
+}
+
+void UInteractableComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// cache the interface so dispatching doesn't need a cast
+	Interactable = Cast<IFPSInteractable>(GetOwner());
+
+	UpdateRegistration();
+}
+
+void UInteractableComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	bInteractionEnabled = false;
+	UpdateRegistration();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UInteractableComponent::UpdateRegistration()
+{
+	UFPSInteractionSubsystem* Subsystem = GetWorld() ? GetWorld()->GetSubsystem<UFPSInteractionSubsystem>() : nullptr;
+	USceneComponent* AnchorComponent = GetAnchor();
+
+	if (!Subsystem || !AnchorComponent)
+	{
+		return;
+	}
+
+	const bool bShouldRegister = bInteractionEnabled && Interactable != nullptr;
+
+	if (bShouldRegister && !bRegistered)
+	{
+		Subsystem->RegisterInteractable(this);
+		AnchorComponent->TransformUpdated.AddUObject(this, &UInteractableComponent::OnAnchorMoved);
+		bRegistered = true;
+
+	} else if (!bShouldRegister && bRegistered) {
+
+		Subsystem->UnregisterInteractable(this);
+		AnchorComponent->TransformUpdated.RemoveAll(this);
+		bRegistered = false;
+	}
+}
+
+void UInteractableComponent::OnAnchorMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (UFPSInteractionSubsystem* Subsystem = GetWorld()->GetSubsystem<UFPSInteractionSubsystem>())
+	{
+		Subsystem->UpdateInteractable(this);
+	}
+}
+
+USceneComponent* UInteractableComponent::GetAnchor() const
+{
+	return Anchor ? Anchor : (GetOwner() ? GetOwner()->GetRootComponent() : nullptr);
+}
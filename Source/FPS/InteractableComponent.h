@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InteractableComponent.generated.h"
+
+class AFPSCharacter;
+class IFPSInteractable;
+class USceneComponent;
+
+/**
+ *  Registers its owner with the interaction subsystem so characters can focus and interact with it
+ *  The owner must implement IFPSInteractable to receive the callbacks
+ */
+UCLASS(ClassGroup = (FPS), meta = (BlueprintSpawnableComponent))
+class FPS_API UInteractableComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Radius around the anchor that counts as looking at this interactable */
+	UPROPERTY(EditAnywhere, Category = "Interact", meta = (ClampMin = 0, Units = "cm"))
+	float InteractRadius = 50.f;
+
+	/** Component the interactable is centered on. Defaults to the owner's root */
+	UPROPERTY()
+	USceneComponent* Anchor;
+
+	/** Interface on the owner the callbacks are dispatched to */
+	IFPSInteractable* Interactable = nullptr;
+
+	/** If false, the interactable is removed from the subsystem and can't be focused */
+	bool bInteractionEnabled = true;
+
+	/** True while we're in the subsystem */
+	bool bRegistered = false;
+
+public:
+
+	/** Constructor */
+	UInteractableComponent();
+
+	/** Sets the component the interactable is centered on */
+	void SetAnchor(USceneComponent* NewAnchor);
+
+	/** Enables or disables interaction */
+	void SetInteractionEnabled(bool bEnabled);
+
+	/** Returns true if this can currently be focused */
+	bool IsInteractionEnabled() const { return bInteractionEnabled; }
+
+	/** Returns the world location the interactable is centered on */
+	FVector GetInteractLocation() const;
+
+	/** Returns the focus radius */
+	float GetInteractRadius() const { return InteractRadius; }
+
+	/** Dispatches focus gained to the owner */
+	void NotifyFocusGained(AFPSCharacter* Character);
+
+	/** Dispatches focus lost to the owner */
+	void NotifyFocusLost(AFPSCharacter* Character);
+
+	/** Dispatches an interaction to the owner */
+	void Interact(AFPSCharacter* Character);
+
+protected:
+
+	/** Gameplay initialization */
+	virtual void BeginPlay() override;
+
+	/** Gameplay cleanup */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Adds or removes us from the subsystem to match the enabled state */
+	void UpdateRegistration();
+
+	/** Keeps the subsystem location in sync when the anchor moves */
+	void OnAnchorMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/** Returns the anchor, falling back to the owner's root */
+	USceneComponent* GetAnchor() const;
+};
@@ -0,0 +1,286 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementKernel.h"
+#include <cmath>
+#include <algorithm>
+
+namespace FPSMovementKernel
+{
+	static float Dot(const FVec3& A, const FVec3& B)
+	{
+		return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+	}
+
+	static FVec3 SafeNormal(const FVec3& V)
+	{
+		const float SizeSquared = Dot(V, V);
+
+		// same tolerance as FVector::GetSafeNormal
+		if (SizeSquared < 1.e-8f)
+		{
+			return FVec3();
+		}
+
+		const float Scale = 1.f / std::sqrt(SizeSquared);
+		return FVec3{ V.X * Scale, V.Y * Scale, V.Z * Scale };
+	}
+
+	float StepFallGravity(float Multiplier, float DeltaTime, const FFallGravityParams& Params)
+	{
+		return (Multiplier < Params.Max) ? Multiplier + DeltaTime * Params.Scaler : Params.Max;
+	}
+
+	bool CanKoyoteJump(float TimeSinceLeftGround, float KoyoteTime)
+	{
+		return TimeSinceLeftGround <= KoyoteTime;
+	}
+
+	FVec3 DoubleJumpVelocity(const FVec3& FlatForward, float ForwardBoost, float JumpZVelocity)
+	{
+		return FVec3{ FlatForward.X * ForwardBoost, FlatForward.Y * ForwardBoost, FlatForward.Z * ForwardBoost + JumpZVelocity };
+	}
+
+	FVec3 WallJumpDirection(const FVec3& Forward, const FVec3& WallNormal, float WallPushScale)
+	{
+		// only touch the direction if it points into the wall
+		const float IntoWall = Dot(Forward, WallNormal);
+		if (IntoWall >= 0.f)
+		{
+			return Forward;
+		}
+
+		// projecting on the unnormalized scaled normal removes Scale^2 times the wall component, pushing us off the wall
+		const float Push = IntoWall * WallPushScale * WallPushScale;
+		return SafeNormal(FVec3{ Forward.X - WallNormal.X * Push, Forward.Y - WallNormal.Y * Push, Forward.Z - WallNormal.Z * Push });
+	}
+
+	/** Newton iterations used by the ballistic solves. They converge monotonically so this is plenty */
+	static constexpr int32_t MaxNewtonIterations = 16;
+	static constexpr float NewtonTolerance = 1.e-4f;
+
+	/** Returns the first and second time integrals of the extra falling gravity ramp */
+	static void FallGravityRampIntegrals(float Time, const FBallisticParams& Params, float& OutFirst, float& OutSecond)
+	{
+		const float Start = std::min(Params.FallGravityStart, Params.FallGravityMax);
+		const float Scaler = (Start < Params.FallGravityMax) ? std::max(Params.FallGravityScaler, 0.f) : 0.f;
+		const float RampTime = (Scaler > 0.f) ? (Params.FallGravityMax - Start) / Scaler : Time;
+
+		// still ramping up
+		const float RampEnd = std::min(Time, RampTime);
+		OutFirst = Start * RampEnd + .5f * Scaler * RampEnd * RampEnd;
+		OutSecond = .5f * Start * RampEnd * RampEnd + Scaler * RampEnd * RampEnd * RampEnd / 6.f;
+
+		// clamped at the max from then on
+		if (Time > RampEnd)
+		{
+			const float Clamped = Time - RampEnd;
+			OutSecond += OutFirst * Clamped + .5f * Params.FallGravityMax * Clamped * Clamped;
+			OutFirst += Params.FallGravityMax * Clamped;
+		}
+	}
+
+	/** Returns the gravity acting on us after falling for Time */
+	static float FallingAcceleration(float Time, const FBallisticParams& Params)
+	{
+		const float Start = std::min(Params.FallGravityStart, Params.FallGravityMax);
+		return Params.Gravity + std::min(Start + std::max(Params.FallGravityScaler, 0.f) * Time, std::max(Params.FallGravityMax, Start));
+	}
+
+	float FallingDrop(float Time, const FBallisticParams& Params)
+	{
+		float First, Second;
+		FallGravityRampIntegrals(Time, Params, First, Second);
+
+		return .5f * Params.Gravity * Time * Time + Second;
+	}
+
+	float FallingSpeedLoss(float Time, const FBallisticParams& Params)
+	{
+		float First, Second;
+		FallGravityRampIntegrals(Time, Params, First, Second);
+
+		return Params.Gravity * Time + First;
+	}
+
+	float BrakedDistance(float Speed, float Time, float Braking)
+	{
+		if (Braking <= 0.f)
+		{
+			return Speed * Time;
+		}
+
+		// braking stops us before Time
+		const float StopTime = Speed / Braking;
+		if (Time >= StopTime)
+		{
+			return .5f * Speed * StopTime;
+		}
+
+		return Speed * Time - .5f * Braking * Time * Time;
+	}
+
+	/** Returns the horizontal launch speed that covers Distance in Time while braking */
+	static float SpeedForBrakedDistance(float Distance, float Time, float Braking)
+	{
+		if (Braking <= 0.f || Distance >= .5f * Braking * Time * Time)
+		{
+			return Distance / Time + .5f * Braking * Time;
+		}
+
+		// braking will stop us above the target before Time runs out
+		return std::sqrt(2.f * Braking * Distance);
+	}
+
+	/** Returns the time it takes to cover Distance when launched at Speed while braking, or a negative value if we stop short */
+	static float TimeForBrakedDistance(float Distance, float Speed, float Braking)
+	{
+		if (Speed <= 0.f)
+		{
+			return -1.f;
+		}
+
+		if (Braking <= 0.f)
+		{
+			return Distance / Speed;
+		}
+
+		const float Discriminant = Speed * Speed - 2.f * Braking * Distance;
+		if (Discriminant < 0.f)
+		{
+			return -1.f;
+		}
+
+		return (Speed - std::sqrt(Discriminant)) / Braking;
+	}
+
+	/** Finds the time at which we come back down to DeltaZ when launched at VerticalSpeed. Returns false if we never get that high */
+	static bool SolveLandingTime(float VerticalSpeed, float DeltaZ, const FBallisticParams& Params, float& OutTime)
+	{
+		// start from the landing time under the lowest gravity we'll see. The real landing is always earlier,
+		// and the height curve is concave so Newton walks back to it without overshooting
+		const float LowestGravity = FallingAcceleration(0.f, Params);
+		const float Discriminant = VerticalSpeed * VerticalSpeed - 2.f * LowestGravity * DeltaZ;
+		if (LowestGravity <= 0.f || Discriminant < 0.f)
+		{
+			return false;
+		}
+
+		float Time = (VerticalSpeed + std::sqrt(Discriminant)) / LowestGravity;
+
+		for (int32_t Iteration = 0; Iteration < MaxNewtonIterations; ++Iteration)
+		{
+			const float Height = VerticalSpeed * Time - FallingDrop(Time, Params) - DeltaZ;
+			const float Speed = VerticalSpeed - FallingSpeedLoss(Time, Params);
+
+			// we walked past the apex, so the target is higher than we can reach
+			if (Speed >= 0.f)
+			{
+				return false;
+			}
+
+			const float Step = Height / Speed;
+			Time -= Step;
+
+			if (std::abs(Step) < NewtonTolerance)
+			{
+				break;
+			}
+		}
+
+		OutTime = Time;
+		return Time > 0.f;
+	}
+
+	/** Finds the lowest launch that just reaches DeltaZ, landing on the apex */
+	static bool SolveApexLaunch(float DeltaZ, const FBallisticParams& Params, float& OutVerticalSpeed, float& OutTime)
+	{
+		const float LowestGravity = FallingAcceleration(0.f, Params);
+		if (LowestGravity <= 0.f)
+		{
+			return false;
+		}
+
+		// apex height is convex in the apex time, and the low gravity guess starts past the root
+		float Time = std::sqrt(2.f * std::max(DeltaZ, 0.f) / LowestGravity);
+
+		for (int32_t Iteration = 0; Iteration < MaxNewtonIterations && Time > 0.f; ++Iteration)
+		{
+			const float Height = FallingSpeedLoss(Time, Params) * Time - FallingDrop(Time, Params) - DeltaZ;
+			const float Slope = FallingAcceleration(Time, Params) * Time;
+
+			const float Step = Height / Slope;
+			Time -= Step;
+
+			if (std::abs(Step) < NewtonTolerance)
+			{
+				break;
+			}
+		}
+
+		OutTime = std::max(Time, 0.f);
+		OutVerticalSpeed = FallingSpeedLoss(OutTime, Params);
+		return true;
+	}
+
+	FVec3 ArcOffset(const FVec3& LaunchVelocity, float Time, const FBallisticParams& Params)
+	{
+		const float SpeedXY = std::sqrt(LaunchVelocity.X * LaunchVelocity.X + LaunchVelocity.Y * LaunchVelocity.Y);
+
+		FVec3 Result;
+		if (SpeedXY > 1.e-4f)
+		{
+			const float Scale = BrakedDistance(SpeedXY, Time, Params.BrakingDeceleration) / SpeedXY;
+			Result.X = LaunchVelocity.X * Scale;
+			Result.Y = LaunchVelocity.Y * Scale;
+		}
+
+		Result.Z = LaunchVelocity.Z * Time - FallingDrop(Time, Params);
+		return Result;
+	}
+
+	bool SolveLaunchVelocity(const FVec3& Delta, float MaxHorizontalSpeed, float MinVerticalSpeed, const FBallisticParams& Params, FLaunchSolution& OutSolution)
+	{
+		const float DistanceXY = std::sqrt(Delta.X * Delta.X + Delta.Y * Delta.Y);
+
+		// launch with the minimum vertical speed, or just enough to reach the target height
+		float VerticalSpeed = MinVerticalSpeed;
+		float Time = 0.f;
+
+		if (!SolveLandingTime(VerticalSpeed, Delta.Z, Params, Time))
+		{
+			if (!SolveApexLaunch(Delta.Z, Params, VerticalSpeed, Time) || VerticalSpeed < MinVerticalSpeed)
+			{
+				return false;
+			}
+		}
+
+		// if that's too fast horizontally, take longer and loft the arc instead
+		if (MaxHorizontalSpeed > 0.f && Time > 0.f && SpeedForBrakedDistance(DistanceXY, Time, Params.BrakingDeceleration) > MaxHorizontalSpeed)
+		{
+			const float SlowTime = TimeForBrakedDistance(DistanceXY, MaxHorizontalSpeed, Params.BrakingDeceleration);
+			if (SlowTime > Time)
+			{
+				Time = SlowTime;
+				VerticalSpeed = (Delta.Z + FallingDrop(Time, Params)) / Time;
+			}
+		}
+
+		if (Time <= 0.f)
+		{
+			return false;
+		}
+
+		OutSolution.FlightTime = Time;
+		OutSolution.Velocity = FVec3();
+		OutSolution.Velocity.Z = VerticalSpeed;
+
+		if (DistanceXY > 1.e-4f)
+		{
+			const float Scale = SpeedForBrakedDistance(DistanceXY, Time, Params.BrakingDeceleration) / DistanceXY;
+			OutSolution.Velocity.X = Delta.X * Scale;
+			OutSolution.Velocity.Y = Delta.Y * Scale;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ *  Engine independent movement math shared by UFPSCharacterMovementComponent and AFPSCharacter
+ *  Only depends on the C++ standard library so it can be compiled and tested outside of the editor, see Tools/MovementKernel
+ */
+namespace FPSMovementKernel
+{
+	/** Minimal float vector so the kernel doesn't depend on FVector */
+	struct FVec3
+	{
+		float X = 0.f;
+		float Y = 0.f;
+		float Z = 0.f;
+	};
+
+	/** Tuning for the extra falling gravity ramp */
+	struct FFallGravityParams
+	{
+		/** How fast the extra falling gravity ramps up, per second */
+		float Scaler = 5.f;
+
+		/** Max extra falling gravity */
+		float Max = 100.f;
+	};
+
+	/** Returns the extra falling gravity after ramping it up for DeltaTime */
+	float StepFallGravity(float Multiplier, float DeltaTime, const FFallGravityParams& Params);
+
+	/** Returns true if we left the ground recently enough to still jump */
+	bool CanKoyoteJump(float TimeSinceLeftGround, float KoyoteTime);
+
+	/** Returns the launch velocity of a double jump along the flattened camera forward */
+	FVec3 DoubleJumpVelocity(const FVec3& FlatForward, float ForwardBoost, float JumpZVelocity);
+
+	/**
+	 *  Returns the horizontal direction of a jump off a wall
+	 *  If the forward points into the wall it is pushed away from it by projecting on the scaled wall normal
+	 */
+	FVec3 WallJumpDirection(const FVec3& Forward, const FVec3& WallNormal, float WallPushScale = 15.f);
+
+	/** Everything that shapes a launched character's flight */
+	struct FBallisticParams
+	{
+		/** Gravity magnitude */
+		float Gravity = 980.f;
+
+		/** Extra falling gravity when the flight starts */
+		float FallGravityStart = 10.f;
+
+		/** How fast the extra falling gravity ramps up, per second */
+		float FallGravityScaler = 5.f;
+
+		/** Max extra falling gravity */
+		float FallGravityMax = 100.f;
+
+		/** Horizontal deceleration while falling without input */
+		float BrakingDeceleration = 0.f;
+	};
+
+	/** Result of a launch solve */
+	struct FLaunchSolution
+	{
+		/** Launch velocity */
+		FVec3 Velocity;
+
+		/** Time until we reach the target */
+		float FlightTime = 0.f;
+	};
+
+	/** Returns how far gravity and the falling gravity ramp pull a character down after falling for Time */
+	float FallingDrop(float Time, const FBallisticParams& Params);
+
+	/** Returns how much vertical speed gravity and the falling gravity ramp take away after falling for Time */
+	float FallingSpeedLoss(float Time, const FBallisticParams& Params);
+
+	/** Returns the horizontal distance covered after Time when launched at Speed and braking while falling */
+	float BrakedDistance(float Speed, float Time, float Braking);
+
+	/** Returns the offset from the launch location after flying for Time */
+	FVec3 ArcOffset(const FVec3& LaunchVelocity, float Time, const FBallisticParams& Params);
+
+	/**
+	 *  Solves the launch velocity that lands a character on a target, accounting for the falling gravity ramp and falling braking
+	 *  Launches with the minimum vertical speed, and lofts the arc if that would need more than the max horizontal speed
+	 *  @param Delta				Target location minus launch location
+	 *  @param MaxHorizontalSpeed	Horizontal launch speed we'd rather not go over. Zero or less means no limit
+	 *  @param MinVerticalSpeed		Minimum vertical launch speed
+	 *  @param Params				Flight parameters
+	 *  @param OutSolution			Launch velocity and flight time
+	 *  @return false if gravity can't bring us back down
+	 */
+	bool SolveLaunchVelocity(const FVec3& Delta, float MaxHorizontalSpeed, float MinVerticalSpeed, const FBallisticParams& Params, FLaunchSolution& OutSolution);
+}
@@ -31,6 +31,9 @@ void AHorrorCharacter::BeginPlay()
 	// initialize sprint meter to max
 	SprintMeter = SprintTime;
 
+	// the meter is only broadcast when it changes, so let any listeners know about the starting value
+	OnSprintMeterUpdated.Broadcast(GetSprintPercent());
+
 	// Initialize the walk speed
 	GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
 
@@ -97,6 +100,9 @@ void AHorrorCharacter::DoEndSprint()
 
 void AHorrorCharacter::SprintFixedTick()
 {
+	// only broadcast the meter if it actually moves this tick
+	const float PreviousSprintMeter = SprintMeter;
+
 	// are we out of recovery, still have stamina and are moving faster than our walk speed?
 	if (bSprinting && !bRecovering && GetVelocity().Length() > WalkSpeed)
 	{
@@ -123,7 +129,8 @@ void AHorrorCharacter::SprintFixedTick()
 		// recover stamina
 		SprintMeter = FMath::Min(SprintMeter + SprintFixedTickTime, SprintTime);
 
-		if (SprintMeter >= SprintTime)
+		// have we just finished recovering?
+		if (bRecovering && SprintMeter >= SprintTime)
 		{
 			// lower the recovering flag
 			bRecovering = false;
@@ -138,6 +145,9 @@ void AHorrorCharacter::SprintFixedTick()
 	}
 
 	// broadcast the sprint meter updated delegate
-	OnSprintMeterUpdated.Broadcast(SprintMeter / SprintTime);
+	if (SprintMeter != PreviousSprintMeter)
+	{
+		OnSprintMeterUpdated.Broadcast(GetSprintPercent());
+	}
 
 }
@@ -75,6 +75,9 @@ public:
 	/** Delegate called when we start and stop sprinting */
 	FSprintStateChangedDelegate OnSprintStateChanged;
 
+	/** Returns the sprint meter as a 0-1 percent */
+	float GetSprintPercent() const { return SprintTime > 0.0f ? SprintMeter / SprintTime : 1.0f; }
+
 protected:
 
 	/** Constructor */
@@ -3,21 +3,59 @@
 
 #include "HorrorUI.h"
 #include "HorrorCharacter.h"
+#include "Components/ProgressBar.h"
 
 void UHorrorUI::SetupCharacter(AHorrorCharacter* HorrorCharacter)
 {
 	HorrorCharacter->OnSprintMeterUpdated.AddDynamic(this, &UHorrorUI::OnSprintMeterUpdated);
 	HorrorCharacter->OnSprintStateChanged.AddDynamic(this, &UHorrorUI::OnSprintStateChanged);
+
+	// the character only broadcasts changes, so pull the current meter
+	OnSprintMeterUpdated(HorrorCharacter->GetSprintPercent());
 }
 
 void UHorrorUI::OnSprintMeterUpdated(float Percent)
 {
-	// call the BP handler
-	BP_SprintMeterUpdated(Percent);
+	if (Percent == DisplayedSprintPercent)
+	{
+		return;
+	}
+
+	DisplayedSprintPercent = Percent;
+
+	bSprintMeterDirty = true;
+	MarkHUDDirty();
 }
 
 void UHorrorUI::OnSprintStateChanged(bool bSprinting)
 {
-	// call the BP handler
-	BP_SprintStateChanged(bSprinting);
+	// the character only broadcasts actual state changes, so there is nothing to compare against
+	bDisplayedSprinting = bSprinting;
+
+	bSprintStateDirty = true;
+	MarkHUDDirty();
+}
+
+void UHorrorUI::RepaintHUD()
+{
+	if (bSprintMeterDirty)
+	{
+		bSprintMeterDirty = false;
+
+		if (SprintMeterBar)
+		{
+			SprintMeterBar->SetPercent(DisplayedSprintPercent);
+		}
+
+		// call the BP handler
+		BP_SprintMeterUpdated(DisplayedSprintPercent);
+	}
+
+	if (bSprintStateDirty)
+	{
+		bSprintStateDirty = false;
+
+		// call the BP handler
+		BP_SprintStateChanged(bDisplayedSprinting);
+	}
 }
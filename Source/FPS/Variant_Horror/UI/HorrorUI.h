@@ -3,22 +3,42 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Blueprint/UserWidget.h"
+#include "FPSHUDWidget.h"
 #include "HorrorUI.generated.h"
 
 class AHorrorCharacter;
+class UProgressBar;
 
 /**
  *  Simple UI for a first person horror game
  *  Manages character sprint meter display
+ *  The sprint meter is kept in a native model and repainted at most once per frame, only when it changes
  */
 UCLASS(abstract)
-class FPS_API UHorrorUI : public UUserWidget
+class FPS_API UHorrorUI : public UFPSHUDWidget
 {
 	GENERATED_BODY()
-	
-public:
 
+protected:
+
+	/** Optional bar showing the sprint meter, updated natively */
+	UPROPERTY(meta = (BindWidgetOptional))
+	TObjectPtr<UProgressBar> SprintMeterBar;
+
+	/** Displayed sprint meter percent. Negative until first set */
+	float DisplayedSprintPercent = -1.0f;
+
+	/** Displayed sprint state */
+	bool bDisplayedSprinting = false;
+
+	/** Set when the sprint meter changed since the last repaint */
+	bool bSprintMeterDirty = false;
+
+	/** Set when the sprint state changed since the last repaint */
+	bool bSprintStateDirty = false;
+
+public:
+	
 	/** Sets up delegate listeners for the passed character */
 	void SetupCharacter(AHorrorCharacter* HorrorCharacter);
 
@@ -32,6 +52,10 @@ public:
 
 protected:
 
+	//~Begin UFPSHUDWidget interface
+	virtual void RepaintHUD() override;
+	//~End UFPSHUDWidget interface
+
 	/** Passes control to Blueprint to update the sprint meter widgets */
 	UFUNCTION(BlueprintImplementableEvent, Category="Horror", meta = (DisplayName = "Sprint Meter Updated"))
 	void BP_SprintMeterUpdated(float Percent);
@@ -3,7 +3,9 @@
 
 #include "Variant_Shooter/AI/ShooterAIController.h"
 #include "ShooterNPC.h"
-#include "Components/StateTreeAIComponent.h"
+#include "ShooterNoiseBus.h"
+#include "ShooterStateTreeAIComponent.h"
+#include "ShooterAILODSubsystem.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Navigation/PathFollowingComponent.h"
 #include "AI/Navigation/PathFollowingAgentInterface.h"
@@ -11,7 +13,7 @@
 AShooterAIController::AShooterAIController()
 {
 	// create the StateTree component
-	StateTreeAI = CreateDefaultSubobject<UStateTreeAIComponent>(TEXT("StateTreeAI"));
+	StateTreeAI = CreateDefaultSubobject<UShooterStateTreeAIComponent>(TEXT("StateTreeAI"));
 
 	// create the AI perception component. It will be configured in BP
 	AIPerception = CreateDefaultSubobject<UAIPerceptionComponent>(TEXT("AIPerception"));
@@ -33,6 +35,12 @@ void AShooterAIController::OnPossess(APawn* InPawn)
 
 		// subscribe to the pawn's OnDeath delegate
 		NPC->OnPawnDeath.AddDynamic(this, &AShooterAIController::OnPawnDeath);
+
+		// receive weapon noises through the noise bus
+		if (UShooterNoiseBus* NoiseBus = GetWorld()->GetSubsystem<UShooterNoiseBus>())
+		{
+			NoiseBus->RegisterListener(AIPerception);
+		}
 	}
 }
 
@@ -44,6 +52,20 @@ void AShooterAIController::OnPawnDeath()
 	// stop StateTree logic
 	StateTreeAI->StopLogic(FString(""));
 
+	// drop any batched perception updates
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(PerceptionFlushTimer);
+	}
+
+	PendingPerceptionUpdates.Reset();
+
+	// stop listening for noises
+	if (UShooterNoiseBus* NoiseBus = GetWorld()->GetSubsystem<UShooterNoiseBus>())
+	{
+		NoiseBus->UnregisterListener(AIPerception);
+	}
+
 	// unpossess the pawn
 	UnPossess();
 
@@ -61,14 +83,95 @@ void AShooterAIController::ClearCurrentTarget()
 	TargetEnemy = nullptr;
 }
 
+void AShooterAIController::WakeStateTree(EShooterStateTreeWake Reason)
+{
+	StateTreeAI->Wake(Reason);
+}
+
+void AShooterAIController::ApplyLODTier(const FShooterAILODTier& Tier)
+{
+	StateTreeAI->SetAwakeTickInterval(Tier.StateTreeTickInterval);
+
+	PerceptionInterval = Tier.PerceptionInterval;
+
+	// don't hold on to batched updates once we're back at full rate
+	if (PerceptionInterval <= 0.0f)
+	{
+		FlushPerceptionUpdates();
+	}
+}
+
+void AShooterAIController::OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result)
+{
+	Super::OnMoveCompleted(RequestID, Result);
+
+	// let the tree react to the move result right away
+	WakeStateTree(EShooterStateTreeWake::MoveCompleted);
+}
+
 void AShooterAIController::OnPerceptionUpdated(AActor* Actor, FAIStimulus Stimulus)
 {
+	// count the callback for the perception stats
+	if (UShooterNoiseBus* NoiseBus = GetWorld()->GetSubsystem<UShooterNoiseBus>())
+	{
+		NoiseBus->CountPerceptionCallback();
+	}
+
+	// batch the update if our LOD tier processes perception at a lower rate
+	if (PerceptionInterval > 0.0f)
+	{
+		if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+		{
+			// only the latest update for each actor matters
+			TPair<TWeakObjectPtr<AActor>, FAIStimulus>* Pending = PendingPerceptionUpdates.FindByPredicate([Actor](const TPair<TWeakObjectPtr<AActor>, FAIStimulus>& Update) { return Update.Key == Actor; });
+
+			if (Pending)
+			{
+				Pending->Value = Stimulus;
+
+			} else {
+
+				PendingPerceptionUpdates.Emplace(Actor, Stimulus);
+			}
+
+			if (!TimerSubsystem->IsTimerActive(PerceptionFlushTimer))
+			{
+				PerceptionFlushTimer = TimerSubsystem->SetTimer(this, &AShooterAIController::FlushPerceptionUpdates, PerceptionInterval);
+			}
+
+			return;
+		}
+	}
+
 	// pass the data to the StateTree delegate hook
 	OnShooterPerceptionUpdated.ExecuteIfBound(Actor, Stimulus);
 }
 
 void AShooterAIController::OnPerceptionForgotten(AActor* Actor)
 {
+	// a batched update for this actor would bring it back after it's forgotten
+	PendingPerceptionUpdates.RemoveAllSwap([Actor](const TPair<TWeakObjectPtr<AActor>, FAIStimulus>& Update) { return Update.Key == Actor; }, EAllowShrinking::No);
+
 	// pass the data to the StateTree delegate hook
 	OnShooterPerceptionForgotten.ExecuteIfBound(Actor);
 }
+
+void AShooterAIController::FlushPerceptionUpdates()
+{
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(PerceptionFlushTimer);
+	}
+
+	// work on a local copy so the delegate can't change the array under us
+	TArray<TPair<TWeakObjectPtr<AActor>, FAIStimulus>> Updates = MoveTemp(PendingPerceptionUpdates);
+	PendingPerceptionUpdates.Reset();
+
+	for (const TPair<TWeakObjectPtr<AActor>, FAIStimulus>& Update : Updates)
+	{
+		if (AActor* Actor = Update.Key.Get())
+		{
+			OnShooterPerceptionUpdated.ExecuteIfBound(Actor, Update.Value);
+		}
+	}
+}
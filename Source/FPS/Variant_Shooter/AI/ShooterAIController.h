@@ -4,11 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "AIController.h"
+#include "Perception/AIPerceptionTypes.h"
+#include "FPSTimerSubsystem.h"
 #include "ShooterAIController.generated.h"
 
-class UStateTreeAIComponent;
+class UShooterStateTreeAIComponent;
 class UAIPerceptionComponent;
 struct FAIStimulus;
+enum class EShooterStateTreeWake : uint8;
+struct FShooterAILODTier;
 
 DECLARE_DELEGATE_TwoParams(FShooterPerceptionUpdatedDelegate, AActor*, const FAIStimulus&);
 DECLARE_DELEGATE_OneParam(FShooterPerceptionForgottenDelegate, AActor*);
@@ -23,7 +27,7 @@ class FPS_API AShooterAIController : public AAIController
 	
 	/** Runs the behavior StateTree for this NPC */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
-	UStateTreeAIComponent* StateTreeAI;
+	UShooterStateTreeAIComponent* StateTreeAI;
 
 	/** Detects other actors through sight, hearing and other senses */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
@@ -38,6 +42,15 @@ protected:
 	/** Enemy currently being targeted */
 	TObjectPtr<AActor> TargetEnemy;
 
+	/** Time perception updates are batched over before being passed on. Set by the AI LOD tier */
+	float PerceptionInterval = 0.0f;
+
+	/** Latest batched perception update for each actor */
+	TArray<TPair<TWeakObjectPtr<AActor>, FAIStimulus>> PendingPerceptionUpdates;
+
+	/** Passes the batched perception updates on once the interval runs out */
+	FFPSTimerHandle PerceptionFlushTimer;
+
 public:
 
 	/** Called when an AI perception has been updated. StateTree task delegate hook */
@@ -73,6 +86,20 @@ public:
 	/** Returns the targeted enemy */
 	AActor* GetCurrentTarget() const { return TargetEnemy; };
 
+	/** Returns the StateTree component */
+	UShooterStateTreeAIComponent* GetStateTreeAI() const { return StateTreeAI; }
+
+	/** Wakes the StateTree up if its active tasks are waiting on the event */
+	void WakeStateTree(EShooterStateTreeWake Reason);
+
+	/** Applies the StateTree and perception rates of an AI LOD tier */
+	void ApplyLODTier(const FShooterAILODTier& Tier);
+
+protected:
+
+	/** Wakes the StateTree up when a move request finishes */
+	virtual void OnMoveCompleted(FAIRequestID RequestID, const FPathFollowingResult& Result) override;
+
 protected:
 
 	/** Called when the AI perception component updates a perception on a given actor */
@@ -82,4 +109,7 @@ protected:
 	/** Called when the AI perception component forgets a given actor */
 	UFUNCTION()
 	void OnPerceptionForgotten(AActor* Actor);
+
+	/** Passes the batched perception updates on to the StateTree delegate hook */
+	void FlushPerceptionUpdates();
 };
@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterAILODSubsystem.h"
+#include "ShooterNPC.h"
+#include "ShooterAIController.h"
+#include "ShooterPotentialVisibility.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarAILODEnabled(
+	TEXT("fps.AILOD.Enable"),
+	true,
+	TEXT("If true, shooter NPCs run their StateTree, movement, animation and perception at the rates of their AI LOD tier.\n")
+	TEXT("If false, every NPC runs at full rate."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("AI LOD Update"), STAT_ShooterAILODUpdate, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI LOD Tier 0 NPCs"), STAT_ShooterAILODTier0, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI LOD Tier 1 NPCs"), STAT_ShooterAILODTier1, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI LOD Tier 2 NPCs"), STAT_ShooterAILODTier2, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI LOD Tier 3+ NPCs"), STAT_ShooterAILODTier3, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI LOD Transitions/Frame"), STAT_ShooterAILODTransitions, STATGROUP_FPS);
+
+void UShooterAILODSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// NPCs don't cover much ground between updates, and hysteresis absorbs the rest
+	TickFunction.TickInterval = GetDefault<UShooterAILODSettings>()->UpdateInterval;
+	TickFunction.Register(&InWorld, TG_PrePhysics, TEXT("ShooterAILOD"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterAILODSubsystem::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	NPCs.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterAILODSubsystem::IsEnabled() const
+{
+	return CVarAILODEnabled.GetValueOnGameThread() && TickFunction.IsTickFunctionRegistered() && GetDefault<UShooterAILODSettings>()->Tiers.Num() > 0;
+}
+
+void UShooterAILODSubsystem::RegisterNPC(AShooterNPC* NPC)
+{
+	if (!NPC || NPCs.ContainsByPredicate([NPC](const FManagedNPC& Managed) { return Managed.NPC == NPC; }))
+	{
+		return;
+	}
+
+	FManagedNPC& Managed = NPCs.AddDefaulted_GetRef();
+	Managed.NPC = NPC;
+}
+
+void UShooterAILODSubsystem::UnregisterNPC(AShooterNPC* NPC)
+{
+	const int32 Index = NPCs.IndexOfByPredicate([NPC](const FManagedNPC& Managed) { return Managed.NPC == NPC; });
+
+	if (Index != INDEX_NONE)
+	{
+		NPCs.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	}
+}
+
+void UShooterAILODSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterAILODUpdate);
+
+	NPCs.RemoveAllSwap([](const FManagedNPC& Managed) { return !Managed.NPC.IsValid(); }, EAllowShrinking::No);
+
+	if (!IsEnabled())
+	{
+		ResetTiers();
+		return;
+	}
+
+	bTiersApplied = true;
+
+	GatherViews();
+
+	const TArray<FShooterAILODTier>& Tiers = GetDefault<UShooterAILODSettings>()->Tiers;
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	int32 TierCounts[4] = { 0, 0, 0, 0 };
+
+	for (FManagedNPC& Managed : NPCs)
+	{
+		AShooterNPC* NPC = Managed.NPC.Get();
+
+		const int32 Tier = SelectTier(Managed, NPC, Now);
+
+		if (Tier != Managed.Tier)
+		{
+			Managed.Tier = Tier;
+			Managed.TierTime = Now;
+
+			ApplyTier(Managed, NPC, Tiers[Tier]);
+
+			INC_DWORD_STAT(STAT_ShooterAILODTransitions);
+
+		} else if (Managed.AppliedController.Get() != NPC->GetController()) {
+
+			// possessed since the tier was applied, so the new brain is still running at full rate
+			ApplyTier(Managed, NPC, Tiers[Tier]);
+		}
+
+		++TierCounts[FMath::Min(Tier, 3)];
+	}
+
+	SET_DWORD_STAT(STAT_ShooterAILODTier0, TierCounts[0]);
+	SET_DWORD_STAT(STAT_ShooterAILODTier1, TierCounts[1]);
+	SET_DWORD_STAT(STAT_ShooterAILODTier2, TierCounts[2]);
+	SET_DWORD_STAT(STAT_ShooterAILODTier3, TierCounts[3]);
+}
+
+int32 UShooterAILODSubsystem::SelectTier(const FManagedNPC& Managed, const AShooterNPC* NPC, double Now) const
+{
+	const UShooterAILODSettings* Settings = GetDefault<UShooterAILODSettings>();
+	const TArray<FShooterAILODTier>& Tiers = Settings->Tiers;
+
+	// without players to measure against, every NPC gets the furthest tier
+	const FVector Location = NPC->GetActorLocation();
+	float Distance = TNumericLimits<float>::Max();
+
+	for (const FVector& ViewLocation : ViewLocations)
+	{
+		Distance = FMath::Min(Distance, float(FVector::Dist(Location, ViewLocation)));
+	}
+
+	if (ViewLocations.Num() > 0 && !IsVisibleToPlayers(NPC))
+	{
+		Distance *= Settings->HiddenDistanceScale;
+	}
+
+	int32 Tier = Tiers.Num() - 1;
+
+	for (int32 Index = 0; Index < Tiers.Num(); ++Index)
+	{
+		if (Tiers[Index].MaxDistance <= 0.0f || Distance <= Tiers[Index].MaxDistance)
+		{
+			Tier = Index;
+			break;
+		}
+	}
+
+	// a tier removed from the config at runtime can't hold anyone back
+	if (!Tiers.IsValidIndex(Managed.Tier) || Tier <= Managed.Tier)
+	{
+		return Tier;
+	}
+
+	// only drop to a further tier once clearly past the edge of the current one, and not right after entering it
+	const bool bPastEdge = Distance > Tiers[Managed.Tier].MaxDistance + Settings->HysteresisDistance;
+	const bool bSettled = Now - Managed.TierTime >= Settings->MinTimeInTier;
+
+	return bPastEdge && bSettled ? Tier : Managed.Tier;
+}
+
+bool UShooterAILODSubsystem::IsVisibleToPlayers(const AShooterNPC* NPC) const
+{
+	// rendered locally, which only ever happens on clients and listen servers
+	if (NPC->WasRecentlyRendered(0.2f))
+	{
+		return true;
+	}
+
+	const float ViewConeCos = FMath::Cos(FMath::DegreesToRadians(GetDefault<UShooterAILODSettings>()->ViewConeHalfAngle));
+	const UShooterPotentialVisibility* PotentialVisibility = GetWorld()->GetSubsystem<UShooterPotentialVisibility>();
+
+	const FVector Location = NPC->GetActorLocation();
+
+	for (int32 Index = 0; Index < ViewLocations.Num(); ++Index)
+	{
+		const FVector ViewDir = (Location - ViewLocations[Index]).GetSafeNormal();
+
+		if (FVector::DotProduct(ViewDir, ViewForwards[Index]) < ViewConeCos)
+		{
+			continue;
+		}
+
+		// in the view cone, and static geometry doesn't always separate them
+		if (!PotentialVisibility || PotentialVisibility->IsPotentiallyVisible(ViewLocations[Index], Location))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UShooterAILODSubsystem::ApplyTier(FManagedNPC& Managed, AShooterNPC* NPC, const FShooterAILODTier& Tier)
+{
+	NPC->ApplyLODTier(Tier);
+
+	AController* Controller = NPC->GetController();
+
+	if (AShooterAIController* AIController = Cast<AShooterAIController>(Controller))
+	{
+		AIController->ApplyLODTier(Tier);
+	}
+
+	Managed.AppliedController = Controller;
+}
+
+void UShooterAILODSubsystem::ResetTiers()
+{
+	if (!bTiersApplied)
+	{
+		return;
+	}
+
+	bTiersApplied = false;
+
+	// the default tier runs everything at full rate
+	const FShooterAILODTier FullRate;
+
+	for (FManagedNPC& Managed : NPCs)
+	{
+		ApplyTier(Managed, Managed.NPC.Get(), FullRate);
+
+		Managed.Tier = INDEX_NONE;
+	}
+}
+
+void UShooterAILODSubsystem::GatherViews()
+{
+	ViewLocations.Reset();
+	ViewForwards.Reset();
+
+	// clients only care about their own players, the server about everyone
+	const bool bIsServer = GetWorld()->GetNetMode() != NM_Client;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+
+		if (PlayerController && (bIsServer || PlayerController->IsLocalController()))
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			ViewLocations.Add(ViewLocation);
+			ViewForwards.Add(ViewRotation.Vector());
+		}
+	}
+}
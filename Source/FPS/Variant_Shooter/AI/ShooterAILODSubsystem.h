@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterAILODSubsystem.generated.h"
+
+class AShooterNPC;
+class AController;
+
+/**
+ *  Update rates for the NPCs in one AI level of detail tier
+ *  The default values run everything at full rate
+ */
+USTRUCT()
+struct FShooterAILODTier
+{
+	GENERATED_BODY()
+
+	/** NPCs up to this far from the closest player use this tier, unless a nearer tier takes them. Zero takes every NPC */
+	UPROPERTY(EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "cm"))
+	float MaxDistance = 0.0f;
+
+	/** Time between StateTree ticks while awake */
+	UPROPERTY(EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "s"))
+	float StateTreeTickInterval = 0.0f;
+
+	/** Time between character movement updates. Each update catches up on the whole interval in one step, like a simulated proxy */
+	UPROPERTY(EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "s"))
+	float MovementTickInterval = 0.0f;
+
+	/** Frames the third person animation skips between updates */
+	UPROPERTY(EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0))
+	int32 AnimFrameSkip = 0;
+
+	/** If true, the skipped animation frames are interpolated instead of holding the last pose */
+	UPROPERTY(EditAnywhere, Category = "AI LOD")
+	bool bInterpolateSkippedFrames = true;
+
+	/** What the third person animation still updates while the mesh isn't rendered */
+	UPROPERTY(EditAnywhere, Category = "AI LOD")
+	EVisibilityBasedAnimTickOption AnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	/** Time perception updates are batched over before the StateTree processes them */
+	UPROPERTY(EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "s"))
+	float PerceptionInterval = 0.0f;
+};
+
+/**
+ *  AI level of detail configuration, read from the [/Script/FPS.ShooterAILODSettings] section of DefaultGame.ini
+ */
+UCLASS(config = Game, defaultconfig)
+class FPS_API UShooterAILODSettings : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Tiers from nearest to furthest. NPCs past every tier use the last one */
+	UPROPERTY(config, EditAnywhere, Category = "AI LOD")
+	TArray<FShooterAILODTier> Tiers;
+
+	/** Time between tier updates */
+	UPROPERTY(config, EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "s"))
+	float UpdateInterval = .25f;
+
+	/** Distance an NPC has to get past the edge of its tier before it drops to a further one */
+	UPROPERTY(config, EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "cm"))
+	float HysteresisDistance = 500.f;
+
+	/** Time an NPC stays in a tier before it can drop to a further one. Moving to a nearer tier is immediate */
+	UPROPERTY(config, EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, Units = "s"))
+	float MinTimeInTier = 1.f;
+
+	/** NPCs no player can see are tiered as if they were this many times further away */
+	UPROPERTY(config, EditAnywhere, Category = "AI LOD", meta = (ClampMin = 1))
+	float HiddenDistanceScale = 2.f;
+
+	/** Half angle of the player view cone NPCs have to be in to count as visible */
+	UPROPERTY(config, EditAnywhere, Category = "AI LOD", meta = (ClampMin = 0, ClampMax = 180, Units = "deg"))
+	float ViewConeHalfAngle = 60.f;
+};
+
+/**
+ *  Sorts shooter NPCs into level of detail tiers by distance and visibility to the players
+ *  Each tier sets the StateTree tick rate, character movement rate, animation update rate and perception rate of its NPCs.
+ *  NPCs move to a nearer tier as soon as they qualify, but only drop to a further one once they're clearly past the edge
+ *  of their tier and have spent a while in it, so they don't flicker between tiers at the boundaries
+ */
+UCLASS()
+class FPS_API UShooterAILODSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** NPC managed by the subsystem */
+	struct FManagedNPC
+	{
+		TWeakObjectPtr<AShooterNPC> NPC;
+
+		/** Controller the current tier was applied to. The tier is applied again when it changes */
+		TWeakObjectPtr<AController> AppliedController;
+
+		/** Current tier, or INDEX_NONE if none was applied yet */
+		int32 Tier = INDEX_NONE;
+
+		/** Time the NPC entered its current tier */
+		double TierTime = 0.0;
+	};
+
+	/** Managed NPCs */
+	TArray<FManagedNPC> NPCs;
+
+	/** Player views gathered for the current update */
+	TArray<FVector> ViewLocations;
+	TArray<FVector> ViewForwards;
+
+	/** True while the NPCs are running at the tier rates, false once they've been reset to full rate */
+	bool bTiersApplied = false;
+
+	/** Runs the tier updates */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/** Starts managing an NPC */
+	void RegisterNPC(AShooterNPC* NPC);
+
+	/** Stops managing an NPC. Its current rates are left as they are */
+	void UnregisterNPC(AShooterNPC* NPC);
+
+	/** Returns true if NPCs are being tiered */
+	bool IsEnabled() const;
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Picks the tier of every NPC and applies the ones that changed */
+	void Tick(float DeltaTime);
+
+	/** Picks the tier for an NPC, applying hysteresis against its current tier */
+	int32 SelectTier(const FManagedNPC& Managed, const AShooterNPC* NPC, double Now) const;
+
+	/** Returns true if any player can see the NPC */
+	bool IsVisibleToPlayers(const AShooterNPC* NPC) const;
+
+	/** Applies a tier to an NPC and its controller */
+	static void ApplyTier(FManagedNPC& Managed, AShooterNPC* NPC, const FShooterAILODTier& Tier);
+
+	/** Puts every managed NPC back at full rate */
+	void ResetTiers();
+
+	/** Reads the view of the players we're tiering against */
+	void GatherViews();
+};
@@ -10,12 +10,31 @@
 #include "ShooterGameMode.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "TimerManager.h"
+#include "ShooterAILODSubsystem.h"
+
+AShooterNPC::AShooterNPC()
+{
+	// let the AI LOD tiers drive the animation update rate. The parameters only exist if this is on when the mesh registers
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+}
 
 void AShooterNPC::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// remember the configured simulation step before any LOD tier stretches it
+	DefaultMaxSimulationTimeStep = GetCharacterMovement()->MaxSimulationTimeStep;
+
+	// start at full rate, so the update rate optimization skips nothing until a tier says otherwise.
+	// NPCs the AI LOD subsystem never tiers, because it's disabled or has no tiers, stay this way
+	ApplyLODTier(FShooterAILODTier());
+
+	// run at the rates of our AI LOD tier
+	if (UShooterAILODSubsystem* AILOD = GetWorld()->GetSubsystem<UShooterAILODSubsystem>())
+	{
+		AILOD->RegisterNPC(this);
+	}
+
 	// spawn the weapon
 	FActorSpawnParameters SpawnParams;
 	SpawnParams.Owner = this;
@@ -29,8 +48,17 @@ void AShooterNPC::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
+	// stop tiering this NPC
+	if (UShooterAILODSubsystem* AILOD = GetWorld()->GetSubsystem<UShooterAILODSubsystem>())
+	{
+		AILOD->UnregisterNPC(this);
+	}
+
 	// clear the death timer
-	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(DeathTimer);
+	}
 }
 
 float AShooterNPC::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
@@ -123,9 +151,10 @@ FVector AShooterNPC::GetWeaponTargetLocation()
 	return OutHit.bBlockingHit ? OutHit.ImpactPoint : OutHit.TraceEnd;
 }
 
-void AShooterNPC::AddWeaponClass(const TSubclassOf<AShooterWeapon>& InWeaponClass)
+bool AShooterNPC::AddWeaponClass(const TSubclassOf<AShooterWeapon>& InWeaponClass)
 {
 	// unused
+	return false;
 }
 
 void AShooterNPC::OnWeaponActivated(AShooterWeapon* InWeapon)
@@ -172,13 +201,24 @@ void AShooterNPC::Die()
 	GetCharacterMovement()->StopMovementImmediately();
 	GetCharacterMovement()->StopActiveMovement();
 
+	// stop tiering and go back to full rate so the ragdoll stays smooth
+	if (UShooterAILODSubsystem* AILOD = GetWorld()->GetSubsystem<UShooterAILODSubsystem>())
+	{
+		AILOD->UnregisterNPC(this);
+	}
+
+	ApplyLODTier(FShooterAILODTier());
+
 	// enable ragdoll physics on the third person mesh
 	GetMesh()->SetCollisionProfileName(RagdollCollisionProfile);
 	GetMesh()->SetSimulatePhysics(true);
 	GetMesh()->SetPhysicsBlendWeight(1.0f);
 
 	// schedule actor destruction
-	GetWorld()->GetTimerManager().SetTimer(DeathTimer, this, &AShooterNPC::DeferredDestruction, DeferredDestructionTime, false);
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		DeathTimer = TimerSubsystem->SetTimer(this, &AShooterNPC::DeferredDestruction, DeferredDestructionTime);
+	}
 }
 
 void AShooterNPC::DeferredDestruction()
@@ -206,3 +246,32 @@ void AShooterNPC::StopShooting()
 	// signal the weapon
 	Weapon->StopFiring();
 }
+
+void AShooterNPC::ApplyLODTier(const FShooterAILODTier& Tier)
+{
+	// update movement less often, and catch up on the whole interval in one step like a simulated proxy would
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->SetComponentTickInterval(Tier.MovementTickInterval);
+	Movement->MaxSimulationTimeStep = FMath::Max(DefaultMaxSimulationTimeStep, Tier.MovementTickInterval);
+
+	USkeletalMeshComponent* ThirdPersonMesh = GetMesh();
+	ThirdPersonMesh->VisibilityBasedAnimTickOption = Tier.AnimTickOption;
+
+	// drive the update rate optimization from the tier instead of the mesh LOD or screen size
+	if (FAnimUpdateRateParameters* UpdateRateParams = ThirdPersonMesh->AnimUpdateRateParams)
+	{
+		UpdateRateParams->bShouldUseLodMap = true;
+		UpdateRateParams->LODToFrameSkipMap.Reset();
+
+		for (int32 LODIndex = 0; LODIndex < ThirdPersonMesh->GetNumLODs(); ++LODIndex)
+		{
+			UpdateRateParams->LODToFrameSkipMap.Add(LODIndex, Tier.AnimFrameSkip);
+		}
+
+		// servers never render, so this is the rate they run at
+		UpdateRateParams->BaseNonRenderedUpdateRate = Tier.AnimFrameSkip + 1;
+
+		// skipped frames are interpolated while the evaluation rate is below this
+		UpdateRateParams->MaxEvalRateForInterpolation = Tier.bInterpolateSkippedFrames ? Tier.AnimFrameSkip + 2 : 1;
+	}
+}
@@ -5,11 +5,13 @@
 #include "CoreMinimal.h"
 #include "FPSCharacter.h"
 #include "ShooterWeaponHolder.h"
+#include "FPSTimerSubsystem.h"
 #include "ShooterNPC.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FPawnDeathDelegate);
 
 class AShooterWeapon;
+struct FShooterAILODTier;
 
 /**
  *  A simple AI-controlled shooter game NPC
@@ -82,13 +84,21 @@ protected:
 	bool bIsDead = false;
 
 	/** Deferred destruction on death timer */
-	FTimerHandle DeathTimer;
+	FFPSTimerHandle DeathTimer;
+
+	/** Movement simulation step configured on the character movement component, before any AI LOD tier stretched it */
+	float DefaultMaxSimulationTimeStep = 0.05f;
 
 public:
 
 	/** Delegate called when this NPC dies */
 	FPawnDeathDelegate OnPawnDeath;
 
+public:
+
+	/** Constructor */
+	AShooterNPC();
+
 protected:
 
 	/** Gameplay initialization */
@@ -122,7 +132,7 @@ public:
 	virtual FVector GetWeaponTargetLocation() override;
 
 	/** Gives a weapon of this class to the owner */
-	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
+	virtual bool AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
 
 	/** Activates the passed weapon */
 	virtual void OnWeaponActivated(AShooterWeapon* Weapon) override;
@@ -150,4 +160,7 @@ public:
 
 	/** Signals this character to stop shooting */
 	void StopShooting();
+
+	/** Applies the movement and animation rates of an AI LOD tier */
+	void ApplyLODTier(const FShooterAILODTier& Tier);
 };
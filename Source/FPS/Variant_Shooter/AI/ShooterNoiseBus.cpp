@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterNoiseBus.h"
+#include "Perception/AIPerceptionComponent.h"
+#include "Perception/AISense_Hearing.h"
+#include "Perception/AISenseConfig_Hearing.h"
+#include "GenericTeamAgentInterface.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarNoiseBus(
+	TEXT("fps.Noise.Aggregate"),
+	true,
+	TEXT("If true, weapon and projectile noises are merged per instigator and delivered once per listener per window.\n")
+	TEXT("If false, every noise is reported to the hearing sense right away."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNoiseWindow(
+	TEXT("fps.Noise.Window"),
+	0.1f,
+	TEXT("Time in seconds noises from the same instigator are merged over before being delivered."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNoiseMergeRadius(
+	TEXT("fps.Noise.MergeRadius"),
+	300.0f,
+	TEXT("Distance in cm within which noises from the same instigator are merged."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Noise Bus Deliver"), STAT_ShooterNoiseBusDeliver, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Noise Listeners"), STAT_ShooterNoiseListeners, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Perception Callbacks/s"), STAT_ShooterPerceptionCallbacksPerSecond, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Noises Reported/Frame"), STAT_ShooterNoisesReported, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Noise Stimuli Delivered/Frame"), STAT_ShooterNoiseStimuliDelivered, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception Callbacks/Frame"), STAT_ShooterPerceptionCallbacks, STATGROUP_FPS);
+
+void UShooterNoiseBus::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// hearing ranges are tens of meters, so use big cells to keep the lookups to a handful of cells
+	ListenerHash.SetCellSize(5000.0f);
+
+	TickFunction.Register(&InWorld, TG_PostUpdateWork, TEXT("ShooterNoiseBus"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterNoiseBus::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Clusters.Reset();
+	Listeners.Reset();
+	ListenerHash.Reset();
+
+	Super::Deinitialize();
+}
+
+void UShooterNoiseBus::MakeNoise(AActor* NoiseMaker, float Loudness, APawn* NoiseInstigator, const FVector& NoiseLocation, float MaxRange, FName Tag)
+{
+	if (!NoiseMaker)
+	{
+		return;
+	}
+
+	UShooterNoiseBus* NoiseBus = NoiseMaker->GetWorld()->GetSubsystem<UShooterNoiseBus>();
+
+	if (NoiseBus && NoiseBus->TickFunction.IsTickFunctionRegistered() && CVarNoiseBus.GetValueOnGameThread())
+	{
+		// listeners perceive the instigator, same as the hearing sense
+		AActor* Instigator = NoiseInstigator ? static_cast<AActor*>(NoiseInstigator) : NoiseMaker;
+
+		NoiseBus->QueueNoise(Instigator, Loudness, NoiseLocation, MaxRange, Tag);
+		return;
+	}
+
+	// report right away
+	NoiseMaker->MakeNoise(Loudness, NoiseInstigator, NoiseLocation, MaxRange, Tag);
+}
+
+void UShooterNoiseBus::RegisterListener(UAIPerceptionComponent* Perception)
+{
+	if (!Perception)
+	{
+		return;
+	}
+
+	// listeners that can't hear would never receive a hearing stimulus from the sense either
+	const UAISenseConfig_Hearing* HearingConfig = Cast<UAISenseConfig_Hearing>(Perception->GetSenseConfig(UAISense::GetSenseID<UAISense_Hearing>()));
+
+	if (!HearingConfig)
+	{
+		return;
+	}
+
+	FShooterNoiseListener* Listener = Listeners.FindByPredicate([Perception](const FShooterNoiseListener& Entry) { return Entry.Perception == Perception; });
+
+	if (!Listener)
+	{
+		Listener = &Listeners.AddDefaulted_GetRef();
+		Listener->Perception = Perception;
+	}
+
+	Listener->HearingRange = HearingConfig->HearingRange;
+	Listener->AffiliationFlags = HearingConfig->DetectionByAffiliation.GetAsFlags();
+	MaxHearingRange = FMath::Max(MaxHearingRange, Listener->HearingRange);
+
+	SET_DWORD_STAT(STAT_ShooterNoiseListeners, Listeners.Num());
+}
+
+void UShooterNoiseBus::UnregisterListener(UAIPerceptionComponent* Perception)
+{
+	Listeners.RemoveAllSwap([Perception](const FShooterNoiseListener& Entry) { return Entry.Perception == Perception; }, EAllowShrinking::No);
+
+	SET_DWORD_STAT(STAT_ShooterNoiseListeners, Listeners.Num());
+}
+
+void UShooterNoiseBus::CountPerceptionCallback()
+{
+	++PerceptionCallbacks;
+	INC_DWORD_STAT(STAT_ShooterPerceptionCallbacks);
+}
+
+void UShooterNoiseBus::QueueNoise(AActor* Instigator, float Loudness, const FVector& Location, float MaxRange, FName Tag)
+{
+	INC_DWORD_STAT(STAT_ShooterNoisesReported);
+
+	const double MergeRadiusSquared = FMath::Square(CVarNoiseMergeRadius.GetValueOnGameThread());
+
+	for (FShooterNoiseCluster& Cluster : Clusters)
+	{
+		if (Cluster.Instigator != Instigator || FVector::DistSquared(Cluster.Location, Location) > MergeRadiusSquared)
+		{
+			continue;
+		}
+
+		// the loudest noise wins
+		if (Loudness > Cluster.Loudness)
+		{
+			Cluster.Location = Location;
+			Cluster.Loudness = Loudness;
+			Cluster.Tag = Tag;
+		}
+
+		// a zero range means unlimited, so keep it if any merged noise had it
+		Cluster.MaxRange = (MaxRange <= 0.0f || Cluster.MaxRange <= 0.0f) ? 0.0f : FMath::Max(Cluster.MaxRange, MaxRange);
+
+		return;
+	}
+
+	FShooterNoiseCluster& Cluster = Clusters.AddDefaulted_GetRef();
+	Cluster.Instigator = Instigator;
+	Cluster.Location = Location;
+	Cluster.Loudness = Loudness;
+	Cluster.MaxRange = MaxRange;
+	Cluster.Tag = Tag;
+	Cluster.StartTime = GetWorld()->GetTimeSeconds();
+}
+
+void UShooterNoiseBus::RefreshListeners()
+{
+	ListenerHash.Reset();
+
+	for (int32 Index = Listeners.Num() - 1; Index >= 0; --Index)
+	{
+		const UAIPerceptionComponent* Perception = Listeners[Index].Perception.Get();
+		const AActor* Body = Perception ? Perception->GetBodyActor() : nullptr;
+
+		if (!IsValid(Body))
+		{
+			Listeners.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+
+	// listeners may have unregistered since the last pass, so the largest range can shrink
+	MaxHearingRange = 0.0f;
+
+	for (int32 Index = 0; Index < Listeners.Num(); ++Index)
+	{
+		ListenerHash.Add(Index, Listeners[Index].Perception->GetBodyActor()->GetActorLocation());
+		MaxHearingRange = FMath::Max(MaxHearingRange, Listeners[Index].HearingRange);
+	}
+
+	SET_DWORD_STAT(STAT_ShooterNoiseListeners, Listeners.Num());
+}
+
+void UShooterNoiseBus::DeliverCluster(const FShooterNoiseCluster& Cluster)
+{
+	AActor* Instigator = Cluster.Instigator.Get();
+
+	if (!IsValid(Instigator))
+	{
+		return;
+	}
+
+	// same range rules as the hearing sense: the listener's range scaled by loudness, capped by the noise range
+	float LookupRadius = MaxHearingRange * Cluster.Loudness;
+
+	if (Cluster.MaxRange > 0.0f)
+	{
+		LookupRadius = FMath::Min(LookupRadius, Cluster.MaxRange);
+	}
+
+	const UAISense_Hearing& HearingSense = *GetDefault<UAISense_Hearing>();
+
+	ListenerHash.ForEachInRadius(Cluster.Location, LookupRadius, [&](int32 Index, const FVector& ListenerLocation)
+	{
+		const FShooterNoiseListener& Listener = Listeners[Index];
+		UAIPerceptionComponent* Perception = Listener.Perception.Get();
+
+		// don't let pawns hear themselves
+		if (Perception->GetBodyActor() == Instigator)
+		{
+			return;
+		}
+
+		if (FVector::DistSquared(ListenerLocation, Cluster.Location) > FMath::Square(Listener.HearingRange * Cluster.Loudness))
+		{
+			return;
+		}
+
+		// same affiliation filtering as the hearing sense, judged by the listener's controller
+		if (!FAISenseAffiliationFilter::ShouldSenseTeam(Listener.AffiliationFlags, FGenericTeamId::GetAttitude(Perception->GetOwner(), Instigator)))
+		{
+			return;
+		}
+
+		Perception->RegisterStimulus(Instigator, FAIStimulus(HearingSense, Cluster.Loudness, Cluster.Location, ListenerLocation, FAIStimulus::SensingSucceeded, Cluster.Tag));
+
+		INC_DWORD_STAT(STAT_ShooterNoiseStimuliDelivered);
+	});
+}
+
+void UShooterNoiseBus::Tick(float DeltaTime)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// roll the perception callback rate over once a second
+	if (Now - PerceptionCallbacksWindowStart >= 1.0)
+	{
+		PerceptionCallbacksPerSecond = PerceptionCallbacks;
+		PerceptionCallbacks = 0;
+		PerceptionCallbacksWindowStart = Now;
+
+		SET_DWORD_STAT(STAT_ShooterPerceptionCallbacksPerSecond, PerceptionCallbacksPerSecond);
+	}
+
+	if (Clusters.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterNoiseBusDeliver);
+
+	const double Window = CVarNoiseWindow.GetValueOnGameThread();
+	bool bRefreshedListeners = false;
+
+	for (int32 Index = 0; Index < Clusters.Num();)
+	{
+		if (Now - Clusters[Index].StartTime < Window)
+		{
+			++Index;
+			continue;
+		}
+
+		// bring the listener hash up to date once per pass, and only if something is due
+		if (!bRefreshedListeners)
+		{
+			RefreshListeners();
+			bRefreshedListeners = true;
+		}
+
+		DeliverCluster(Clusters[Index]);
+
+		// keep the clusters in report order so older noises are always delivered first
+		Clusters.RemoveAt(Index, 1, EAllowShrinking::No);
+	}
+}
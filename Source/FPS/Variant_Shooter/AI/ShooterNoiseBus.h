@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSpatialHash.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterNoiseBus.generated.h"
+
+class UAIPerceptionComponent;
+
+/**
+ *  Noises from one instigator merged over a short window
+ */
+struct FShooterNoiseCluster
+{
+	/** Who made the noises. Listeners perceive this actor */
+	TWeakObjectPtr<AActor> Instigator;
+
+	/** Location, range and tag of the loudest noise */
+	FVector Location = FVector::ZeroVector;
+	float Loudness = 0.0f;
+	float MaxRange = 0.0f;
+	FName Tag;
+
+	/** Time the first noise was reported. The cluster is delivered once the window has passed */
+	double StartTime = 0.0;
+};
+
+/**
+ *  AI listener registered with the noise bus
+ */
+struct FShooterNoiseListener
+{
+	TWeakObjectPtr<UAIPerceptionComponent> Perception;
+
+	/** Hearing range from the listener's hearing sense config */
+	float HearingRange = 0.0f;
+
+	/** Affiliations the listener can hear, as FAISenseAffiliationFilter flags from its hearing sense config */
+	uint8 AffiliationFlags = 0;
+};
+
+/**
+ *  Aggregates the noises made by shooter weapons and projectiles before they reach AI perception.
+ *  Noises from the same instigator that land close together within a short window are merged into one,
+ *  culled against a spatial hash of the listeners, and delivered as a single hearing stimulus per listener,
+ *  instead of every shot and impact being broadcast to every listener
+ */
+UCLASS()
+class FPS_API UShooterNoiseBus : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Noises waiting for their window to close */
+	TArray<FShooterNoiseCluster> Clusters;
+
+	/** Registered listeners */
+	TArray<FShooterNoiseListener> Listeners;
+
+	/** Listener indices bucketed by the location of their pawn. Rebuilt before each delivery pass */
+	TFPSSpatialHash<int32> ListenerHash;
+
+	/** Largest hearing range among the listeners as of the last refresh, used to bound the hash lookups */
+	float MaxHearingRange = 0.0f;
+
+	/** Delivers the clusters whose window has closed */
+	FFPSSubsystemTickFunction TickFunction;
+
+	/** Perception callbacks counted during the current second, and the rate over the last full second */
+	int32 PerceptionCallbacks = 0;
+	int32 PerceptionCallbacksPerSecond = 0;
+	double PerceptionCallbacksWindowStart = 0.0;
+
+public:
+
+	/**
+	 *  Reports a noise to the bus, or makes it right away if aggregation is disabled
+	 *  Takes the same parameters as AActor::MakeNoise
+	 */
+	static void MakeNoise(AActor* NoiseMaker, float Loudness, APawn* NoiseInstigator, const FVector& NoiseLocation, float MaxRange, FName Tag);
+
+	/** Starts delivering noises to a perception component. Listeners without a hearing sense are ignored */
+	void RegisterListener(UAIPerceptionComponent* Perception);
+
+	/** Stops delivering noises to a perception component */
+	void UnregisterListener(UAIPerceptionComponent* Perception);
+
+	/** Counts a perception callback towards the per second stat */
+	void CountPerceptionCallback();
+
+	/** Returns the number of perception callbacks over the last full second */
+	int32 GetPerceptionCallbacksPerSecond() const { return PerceptionCallbacksPerSecond; }
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Merges a noise into a pending cluster from the same instigator, or starts a new one */
+	void QueueNoise(AActor* Instigator, float Loudness, const FVector& Location, float MaxRange, FName Tag);
+
+	/** Drops the destroyed listeners, rebuilds the hash from their current locations and recomputes the largest hearing range */
+	void RefreshListeners();
+
+	/** Delivers a cluster to every listener that can hear it */
+	void DeliverCluster(const FShooterNoiseCluster& Cluster);
+
+	/** Delivers the clusters whose window has closed */
+	void Tick(float DeltaTime);
+};
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterPerceptionPipeline.h"
+#include "ShooterPotentialVisibility.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarPerceptionPipeline(
+	TEXT("fps.Perception.Pipeline"),
+	true,
+	TEXT("If true, sensed enemy stimuli are queued, cone tested on a worker, traced with async scene queries and committed at a sync point.\n")
+	TEXT("If false, every stimulus is processed on the game thread as it arrives, with a synchronous trace."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Perception Sync Point"), STAT_ShooterPerceptionSync, STATGROUP_FPS);
+DECLARE_CYCLE_STAT(TEXT("Perception Cone Tests"), STAT_ShooterPerceptionCones, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception Stimuli Queued/Frame"), STAT_ShooterPerceptionQueued, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception Traces/Frame"), STAT_ShooterPerceptionTraces, STATGROUP_FPS);
+
+void UShooterPerceptionPipeline::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Register(&InWorld, TG_PrePhysics, TEXT("ShooterPerceptionPipeline"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterPerceptionPipeline::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	// the worker may still be reading the batch
+	ConeTask.Wait();
+
+	QueuedJobs.Reset();
+	ConeJobs.Reset();
+	TraceJobs.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterPerceptionPipeline::IsEnabled() const
+{
+	return CVarPerceptionPipeline.GetValueOnGameThread() && TickFunction.IsTickFunctionRegistered();
+}
+
+void UShooterPerceptionPipeline::QueueStimulus(AActor* Observer, AActor* SensedActor, const FVector& StimulusLocation, float ConeAngle, TFunction<void(bool)>&& Commit)
+{
+	if (!Observer || !SensedActor)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_ShooterPerceptionQueued);
+
+	FShooterPerceptionJob& Job = QueuedJobs.AddDefaulted_GetRef();
+	Job.Observer = Observer;
+	Job.SensedActor = SensedActor;
+	Job.ObserverLocation = Observer->GetActorLocation();
+	Job.ObserverForward = Observer->GetActorForwardVector();
+	Job.SensedLocation = SensedActor->GetActorLocation();
+	Job.StimulusLocation = StimulusLocation;
+	Job.MaxDot = FMath::Cos(FMath::DegreesToRadians(ConeAngle));
+	Job.Commit = MoveTemp(Commit);
+}
+
+void UShooterPerceptionPipeline::TestCones(TArray<FShooterPerceptionJob>& Jobs)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterPerceptionCones);
+
+	for (FShooterPerceptionJob& Job : Jobs)
+	{
+		// infer the angle from the dot product between the character facing and the stimulus direction
+		const FVector StimulusDir = (Job.StimulusLocation - Job.ObserverLocation).GetSafeNormal();
+
+		Job.bNeedsTrace = FVector::DotProduct(StimulusDir, Job.ObserverForward) >= Job.MaxDot;
+	}
+}
+
+void UShooterPerceptionPipeline::CommitTraces()
+{
+	UWorld* World = GetWorld();
+
+	for (FShooterPerceptionJob& Job : TraceJobs)
+	{
+		if (!Job.Observer.IsValid() || !Job.SensedActor.IsValid())
+		{
+			continue;
+		}
+
+		// we have direct line of sight if the trace is unobstructed. A lost result counts as no line of sight
+		FTraceDatum Datum;
+		const bool bDirectLOS = World->QueryTraceData(Job.Trace, Datum) && (Datum.OutHits.Num() == 0 || !Datum.OutHits[0].bBlockingHit);
+
+		Job.Commit(bDirectLOS);
+	}
+
+	TraceJobs.Reset();
+}
+
+void UShooterPerceptionPipeline::IssueTraces()
+{
+	UWorld* World = GetWorld();
+	const UShooterPotentialVisibility* PotentialVisibility = World->GetSubsystem<UShooterPotentialVisibility>();
+
+	for (FShooterPerceptionJob& Job : ConeJobs)
+	{
+		AActor* Observer = Job.Observer.Get();
+		AActor* SensedActor = Job.SensedActor.Get();
+
+		if (!Observer || !SensedActor)
+		{
+			continue;
+		}
+
+		// trace between where the actors are now, rather than where they were when the stimulus arrived
+		const FVector Start = Observer->GetActorLocation();
+		const FVector End = SensedActor->GetActorLocation();
+
+		if (!Job.bNeedsTrace || (PotentialVisibility && !PotentialVisibility->IsPotentiallyVisible(Start, End)))
+		{
+			Job.Commit(false);
+			continue;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterPerception), false);
+		QueryParams.AddIgnoredActor(Observer);
+		QueryParams.AddIgnoredActor(SensedActor);
+
+		Job.Trace = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, ECC_Visibility, QueryParams);
+
+		TraceJobs.Add(MoveTemp(Job));
+
+		INC_DWORD_STAT(STAT_ShooterPerceptionTraces);
+	}
+
+	ConeJobs.Reset();
+}
+
+void UShooterPerceptionPipeline::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterPerceptionSync);
+
+	// traces issued last frame have landed
+	CommitTraces();
+
+	// the cone tests had a whole frame to run, so this shouldn't block
+	ConeTask.Wait();
+	IssueTraces();
+
+	if (QueuedJobs.Num() > 0)
+	{
+		Swap(QueuedJobs, ConeJobs);
+
+		ConeTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() { TestCones(ConeJobs); });
+	}
+}
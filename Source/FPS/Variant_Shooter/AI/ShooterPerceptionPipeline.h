@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "WorldCollision.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterPerceptionPipeline.generated.h"
+
+/**
+ *  Perception stimulus on its way through the pipeline
+ */
+struct FShooterPerceptionJob
+{
+	/** Sensing character and sensed actor */
+	TWeakObjectPtr<AActor> Observer;
+	TWeakObjectPtr<AActor> SensedActor;
+
+	/** Snapshot taken on the game thread when the stimulus was queued, so workers never touch the actors */
+	FVector ObserverLocation = FVector::ZeroVector;
+	FVector ObserverForward = FVector::ForwardVector;
+	FVector SensedLocation = FVector::ZeroVector;
+	FVector StimulusLocation = FVector::ZeroVector;
+
+	/** Cosine of the direct line of sight cone half angle */
+	float MaxDot = 0.0f;
+
+	/** Set by the worker if the stimulus is inside the cone */
+	bool bNeedsTrace = false;
+
+	/** Line of sight trace in flight */
+	FTraceHandle Trace;
+
+	/** Called on the game thread at the sync point with the line of sight result */
+	TFunction<void(bool)> Commit;
+};
+
+/**
+ *  Processes AI perception stimuli off the game thread
+ *  Stimuli are queued on the game thread as they arrive. Once per frame, at the sync point:
+ *  the line of sight results of the previous batch are committed, the cone tests of the batch queued last frame are
+ *  collected and the stimuli inside the cone that the baked potential visibility doesn't rule out get their traces issued
+ *  as async scene queries, then the cone tests of the new batch are launched as a task.
+ *  Every commit runs on the game thread at the sync point, so StateTree instance data is never written from a worker
+ */
+UCLASS()
+class FPS_API UShooterPerceptionPipeline : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Stimuli queued since the last sync point */
+	TArray<FShooterPerceptionJob> QueuedJobs;
+
+	/** Stimuli being cone tested by the worker task */
+	TArray<FShooterPerceptionJob> ConeJobs;
+
+	/** Stimuli with a line of sight trace in flight */
+	TArray<FShooterPerceptionJob> TraceJobs;
+
+	/** Worker task running the cone tests of ConeJobs */
+	UE::Tasks::FTask ConeTask;
+
+	/** Runs the sync point */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/**
+	 *  Queues a stimulus for processing
+	 *  @param Observer			Sensing character. Looks from its location along its forward vector
+	 *  @param SensedActor		Actor that was sensed
+	 *  @param StimulusLocation	Where the stimulus came from
+	 *  @param ConeAngle		Direct line of sight cone half angle, in degrees
+	 *  @param Commit			Called on the game thread at a later sync point with true if there's direct line of sight
+	 */
+	void QueueStimulus(AActor* Observer, AActor* SensedActor, const FVector& StimulusLocation, float ConeAngle, TFunction<void(bool)>&& Commit);
+
+	/** Returns true if stimuli should be queued instead of processed right away */
+	bool IsEnabled() const;
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Commits the line of sight results of the traces issued last frame */
+	void CommitTraces();
+
+	/** Issues traces for the stimuli that passed their cone tests, and commits the ones that didn't */
+	void IssueTraces();
+
+	/** Runs the cone tests of a batch. Called on a worker thread */
+	static void TestCones(TArray<FShooterPerceptionJob>& Jobs);
+
+	/** Runs the sync point */
+	void Tick(float DeltaTime);
+};
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterPotentialVisibility.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarPotentialVisibility(
+	TEXT("fps.LOS.PVS"),
+	true,
+	TEXT("If true, AI line of sight checks are skipped for cells the baked potential visibility says can't see each other."),
+	ECVF_Default);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Checks/Frame"), STAT_ShooterPVSChecks, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PVS Culled/Frame"), STAT_ShooterPVSCulled, STATGROUP_FPS);
+
+FString UShooterPotentialVisibility::GetSidecarPath(const FString& MapPackageName)
+{
+	// mirror the map's content path under Content/Visibility, so maps with the same name don't collide
+	FString RelativePath;
+	if (!FPackageName::TryConvertLongPackageNameToFilename(MapPackageName, RelativePath))
+	{
+		return FString();
+	}
+
+	FPaths::MakePathRelativeTo(RelativePath, *FPaths::ProjectContentDir());
+
+	return FPaths::ProjectContentDir() / TEXT("Visibility") / RelativePath + TEXT(".fpspvs");
+}
+
+void UShooterPotentialVisibility::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LoadSidecar(InWorld);
+}
+
+void UShooterPotentialVisibility::Deinitialize()
+{
+	UnloadSidecar();
+
+	Super::Deinitialize();
+}
+
+void UShooterPotentialVisibility::LoadSidecar(UWorld& InWorld)
+{
+	const FString MapPackageName = UWorld::RemovePIEPrefix(InWorld.GetOutermost()->GetName());
+	const FString Path = GetSidecarPath(MapPackageName);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	if (Path.IsEmpty() || !PlatformFile.FileExists(*Path))
+	{
+		return;
+	}
+
+	FOpenMappedResult OpenResult = PlatformFile.OpenMappedEx(*Path);
+
+	if (OpenResult.HasError())
+	{
+		UE_LOG(LogFPS, Warning, TEXT("Couldn't map potential visibility sidecar '%s'"), *Path);
+		return;
+	}
+
+	MappedFile = OpenResult.StealValue();
+
+	const int64 FileSize = MappedFile->GetFileSize();
+
+	if (FileSize < int64(sizeof(FShooterPVSHeader)))
+	{
+		UE_LOG(LogFPS, Warning, TEXT("Potential visibility sidecar '%s' is truncated"), *Path);
+		UnloadSidecar();
+		return;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, FileSize));
+
+	if (!MappedRegion)
+	{
+		UE_LOG(LogFPS, Warning, TEXT("Couldn't map potential visibility sidecar '%s'"), *Path);
+		UnloadSidecar();
+		return;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	const FShooterPVSHeader* MappedHeader = reinterpret_cast<const FShooterPVSHeader*>(Data);
+
+	// reject stale or damaged bakes rather than culling with them
+	if (MappedHeader->Magic != FShooterPVSHeader::ExpectedMagic || MappedHeader->Version != FShooterPVSHeader::CurrentVersion || MappedHeader->GetNumCells() <= 0 || MappedHeader->GetFileSize() != FileSize)
+	{
+		UE_LOG(LogFPS, Warning, TEXT("Potential visibility sidecar '%s' is out of date, rebake it with the ShooterVisibilityBake commandlet"), *Path);
+		UnloadSidecar();
+		return;
+	}
+
+	const uint32* MappedRowIndices = reinterpret_cast<const uint32*>(Data + FShooterPVSHeader::GetRowIndicesOffset());
+
+	for (int32 Cell = 0; Cell < MappedHeader->GetNumCells(); ++Cell)
+	{
+		if (MappedRowIndices[Cell] >= MappedHeader->NumRows)
+		{
+			UE_LOG(LogFPS, Warning, TEXT("Potential visibility sidecar '%s' is corrupt, rebake it with the ShooterVisibilityBake commandlet"), *Path);
+			UnloadSidecar();
+			return;
+		}
+	}
+
+	Header = MappedHeader;
+	RowIndices = MappedRowIndices;
+	Rows = reinterpret_cast<const uint64*>(Data + Header->GetRowsOffset());
+
+	UE_LOG(LogFPS, Log, TEXT("Mapped potential visibility for %s: %d cells, %u unique rows"), *MapPackageName, Header->GetNumCells(), Header->NumRows);
+}
+
+void UShooterPotentialVisibility::UnloadSidecar()
+{
+	Header = nullptr;
+	RowIndices = nullptr;
+	Rows = nullptr;
+
+	// the region has to go before the file it maps
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+int32 UShooterPotentialVisibility::GetCellIndex(const FVector& Location) const
+{
+	const FVector3f Local = (FVector3f(Location) - Header->Origin) / Header->CellSize;
+
+	const int32 X = FMath::FloorToInt32(Local.X);
+	const int32 Y = FMath::FloorToInt32(Local.Y);
+	const int32 Z = FMath::FloorToInt32(Local.Z);
+
+	if (X < 0 || Y < 0 || Z < 0 || X >= Header->DimX || Y >= Header->DimY || Z >= Header->DimZ)
+	{
+		return INDEX_NONE;
+	}
+
+	return (Z * Header->DimY + Y) * Header->DimX + X;
+}
+
+bool UShooterPotentialVisibility::IsPotentiallyVisible(const FVector& From, const FVector& To) const
+{
+	if (!Header || !CVarPotentialVisibility.GetValueOnGameThread())
+	{
+		return true;
+	}
+
+	INC_DWORD_STAT(STAT_ShooterPVSChecks);
+
+	const int32 FromCell = GetCellIndex(From);
+	const int32 ToCell = GetCellIndex(To);
+
+	// nothing was baked out there
+	if (FromCell == INDEX_NONE || ToCell == INDEX_NONE)
+	{
+		return true;
+	}
+
+	const uint64* Row = Rows + int64(RowIndices[FromCell]) * Header->WordsPerRow;
+	const bool bVisible = ((Row[ToCell >> 6] >> (ToCell & 63)) & 1) != 0;
+
+	if (!bVisible)
+	{
+		INC_DWORD_STAT(STAT_ShooterPVSCulled);
+	}
+
+	return bVisible;
+}
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Async/MappedFileHandle.h"
+#include "ShooterPotentialVisibility.generated.h"
+
+/**
+ *  Header of a baked potential visibility sidecar file
+ *  The header is followed by one row index per cell, padded to 8 bytes, then the unique visibility rows.
+ *  Each row is a bitset with one bit per cell, set if the cell is potentially visible from the row's cell
+ */
+struct FShooterPVSHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x53565046;
+	/** Bumped whenever the layout or the meaning of the rows changes, so stale sidecars are ignored */
+	static constexpr uint32 CurrentVersion = 2;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+
+	/** Min corner of the grid, in world space */
+	FVector3f Origin = FVector3f::ZeroVector;
+
+	/** Edge length of a cell */
+	float CellSize = 0.0f;
+
+	/** Number of cells along each axis */
+	int32 DimX = 0;
+	int32 DimY = 0;
+	int32 DimZ = 0;
+
+	/** Number of unique rows stored in the file */
+	uint32 NumRows = 0;
+
+	/** Number of 64 bit words in each row */
+	uint32 WordsPerRow = 0;
+
+	uint32 Padding = 0;
+
+	/** Returns the number of cells in the grid */
+	int32 GetNumCells() const { return DimX * DimY * DimZ; }
+
+	/** Returns the byte offset of the row indices */
+	static int64 GetRowIndicesOffset() { return sizeof(FShooterPVSHeader); }
+
+	/** Returns the byte offset of the rows */
+	int64 GetRowsOffset() const { return Align(GetRowIndicesOffset() + int64(GetNumCells()) * sizeof(uint32), sizeof(uint64)); }
+
+	/** Returns the expected size of the file */
+	int64 GetFileSize() const { return GetRowsOffset() + int64(NumRows) * WordsPerRow * sizeof(uint64); }
+};
+
+static_assert(sizeof(FShooterPVSHeader) % sizeof(uint64) == 0, "PVS rows must stay 8 byte aligned");
+
+/**
+ *  Cell to cell potential visibility baked offline against the level's static geometry
+ *  The sidecar file is memory mapped rather than loaded, so lookups read straight from the page cache.
+ *  Line of sight checks ask it first and skip their traces for pairs static geometry always separates.
+ *  Worlds without a baked sidecar report everything as potentially visible
+ */
+UCLASS()
+class FPS_API UShooterPotentialVisibility : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Mapped sidecar file */
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** Views into the mapped file. Null if no sidecar is loaded */
+	const FShooterPVSHeader* Header = nullptr;
+	const uint32* RowIndices = nullptr;
+	const uint64* Rows = nullptr;
+
+public:
+
+	/**
+	 *  Returns false if static geometry blocks every line between the two locations' cells
+	 *  Locations outside the baked grid are always potentially visible
+	 */
+	bool IsPotentiallyVisible(const FVector& From, const FVector& To) const;
+
+	/** Returns true if a sidecar is loaded for this world */
+	bool HasData() const { return Header != nullptr; }
+
+	/** Returns the path of the sidecar file baked for a map package */
+	static FString GetSidecarPath(const FString& MapPackageName);
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Maps the sidecar file baked for the world, if there is one */
+	void LoadSidecar(UWorld& InWorld);
+
+	/** Unmaps the sidecar file */
+	void UnloadSidecar();
+
+	/** Returns the index of the cell containing a location, or INDEX_NONE if it's outside the grid */
+	int32 GetCellIndex(const FVector& Location) const;
+};
@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterStateTreeAIComponent.h"
+#include "ShooterStateTreeScheduler.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+#include "FPS.h"
+
+DECLARE_CYCLE_STAT(TEXT("StateTree AI Tick"), STAT_ShooterStateTreeTick, STATGROUP_FPS);
+
+void UShooterStateTreeAIComponent::BeginPlay()
+{
+	// remember the configured tick rate so we can go back to it when waking up
+	AwakeTickInterval = PrimaryComponentTick.TickInterval;
+
+	Super::BeginPlay();
+}
+
+void UShooterStateTreeAIComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// the tasks should have removed their waits when the logic stopped, but don't leave timers behind either way
+	UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>();
+
+	for (FShooterStateTreeWait& Wait : Waits)
+	{
+		if (TimerSubsystem)
+		{
+			TimerSubsystem->ClearTimer(Wait.Timer);
+		}
+	}
+
+	Waits.Reset();
+	UpdateSleep();
+}
+
+int32 UShooterStateTreeAIComponent::AddWait(EShooterStateTreeWake Conditions, float TimerDelay, const AActor* Target, float MoveThreshold)
+{
+	FShooterStateTreeWait& Wait = Waits.AddDefaulted_GetRef();
+	Wait.Handle = ++LastWaitHandle;
+	Wait.Conditions = Conditions;
+
+	if (EnumHasAnyFlags(Conditions, EShooterStateTreeWake::Timer))
+	{
+		// without the timer subsystem the safety tick picks up the delay
+		if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+		{
+			Wait.Timer = TimerSubsystem->SetTimer(FSimpleDelegate::CreateWeakLambda(this, [this]() { Wake(EShooterStateTreeWake::Timer); }), TimerDelay);
+		}
+	}
+
+	if (Target && EnumHasAnyFlags(Conditions, EShooterStateTreeWake::TargetMoved))
+	{
+		Wait.Target = Target;
+		Wait.TargetLocation = Target->GetActorLocation();
+		Wait.MoveThresholdSquared = FMath::Square(MoveThreshold);
+	}
+
+	const int32 Handle = Wait.Handle;
+
+	UpdateSleep();
+
+	return Handle;
+}
+
+void UShooterStateTreeAIComponent::RemoveWait(int32& Handle)
+{
+	const int32 Index = Waits.IndexOfByPredicate([Handle](const FShooterStateTreeWait& Wait) { return Wait.Handle == Handle; });
+
+	Handle = INDEX_NONE;
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(Waits[Index].Timer);
+	}
+
+	Waits.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	UpdateSleep();
+}
+
+void UShooterStateTreeAIComponent::Wake(EShooterStateTreeWake Reason)
+{
+	// only events one of the tasks is waiting on end the sleep
+	if (!bSleeping || !EnumHasAnyFlags(GetWaitConditions(), Reason))
+	{
+		return;
+	}
+
+	bWakePending = true;
+
+	if (UShooterStateTreeScheduler* Scheduler = GetWorld()->GetSubsystem<UShooterStateTreeScheduler>())
+	{
+		Scheduler->CountWake();
+	}
+
+	UpdateSleep();
+}
+
+void UShooterStateTreeAIComponent::PollWatchedTargets()
+{
+	for (const FShooterStateTreeWait& Wait : Waits)
+	{
+		if (!EnumHasAnyFlags(Wait.Conditions, EShooterStateTreeWake::TargetMoved))
+		{
+			continue;
+		}
+
+		// a destroyed target counts as having moved away
+		const AActor* Target = Wait.Target.Get();
+
+		if (Wait.Target.IsStale() || (Target && FVector::DistSquared(Target->GetActorLocation(), Wait.TargetLocation) > Wait.MoveThresholdSquared))
+		{
+			Wake(EShooterStateTreeWake::TargetMoved);
+			return;
+		}
+	}
+}
+
+void UShooterStateTreeAIComponent::SetAwakeTickInterval(float Interval)
+{
+	if (FMath::IsNearlyEqual(AwakeTickInterval, Interval))
+	{
+		return;
+	}
+
+	AwakeTickInterval = Interval;
+
+	// keep the current cooldown, the new interval applies from the next tick on
+	if (bSleeping)
+	{
+		UShooterStateTreeScheduler* Scheduler = GetWorld()->GetSubsystem<UShooterStateTreeScheduler>();
+
+		SetComponentTickInterval(FMath::Max(Scheduler ? Scheduler->GetSafetyTickInterval() : 0.0f, AwakeTickInterval));
+
+	} else {
+
+		SetComponentTickInterval(AwakeTickInterval);
+	}
+}
+
+void UShooterStateTreeAIComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterStateTreeTick);
+
+	// a tick while sleeping is a safety tick. Tasks exiting during the tick remove their waits and wake us, so decide up front
+	const bool bSafetyTick = bSleeping;
+	const double StartTime = FPlatformTime::Seconds();
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// only awake ticks tell the scheduler what a sleeping tree saves
+	if (UShooterStateTreeScheduler* Scheduler = GetWorld()->GetSubsystem<UShooterStateTreeScheduler>())
+	{
+		Scheduler->ReportTick(FPlatformTime::Seconds() - StartTime, bSafetyTick);
+	}
+
+	// the tree has seen the event. Go back to sleep if the active tasks are still waiting
+	bWakePending = false;
+	UpdateSleep();
+}
+
+void UShooterStateTreeAIComponent::UpdateSleep()
+{
+	UShooterStateTreeScheduler* Scheduler = GetWorld()->GetSubsystem<UShooterStateTreeScheduler>();
+
+	const bool bShouldSleep = Waits.Num() > 0 && !bWakePending && HasBegunPlay() && Scheduler && Scheduler->IsEnabled();
+
+	if (bShouldSleep == bSleeping)
+	{
+		return;
+	}
+
+	bSleeping = bShouldSleep;
+
+	if (bSleeping)
+	{
+		// watch the targets from where they are now
+		for (FShooterStateTreeWait& Wait : Waits)
+		{
+			if (const AActor* Target = Wait.Target.Get())
+			{
+				Wait.TargetLocation = Target->GetActorLocation();
+			}
+		}
+
+		SetComponentTickIntervalAndCooldown(FMath::Max(Scheduler->GetSafetyTickInterval(), AwakeTickInterval));
+
+		Scheduler->RegisterSleeper(this);
+
+	} else {
+
+		// tick again as soon as possible, then carry on at the awake rate
+		SetComponentTickIntervalAndCooldown(0.0f);
+		SetComponentTickInterval(AwakeTickInterval);
+
+		if (Scheduler)
+		{
+			Scheduler->UnregisterSleeper(this);
+		}
+	}
+}
+
+EShooterStateTreeWake UShooterStateTreeAIComponent::GetWaitConditions() const
+{
+	EShooterStateTreeWake Conditions = EShooterStateTreeWake::None;
+
+	for (const FShooterStateTreeWait& Wait : Waits)
+	{
+		Conditions |= Wait.Conditions;
+	}
+
+	return Conditions;
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/StateTreeAIComponent.h"
+#include "FPSTimerSubsystem.h"
+#include "ShooterStateTreeAIComponent.generated.h"
+
+/**
+ *  Events that can wake up a sleeping StateTree
+ */
+enum class EShooterStateTreeWake : uint8
+{
+	None			= 0,
+	Perception		= 1 << 0,	// the sensed target or investigate location changed
+	Timer			= 1 << 1,	// a delay ran out
+	MoveCompleted	= 1 << 2,	// the current move request finished
+	TargetMoved		= 1 << 3,	// a watched actor moved further than its threshold
+};
+ENUM_CLASS_FLAGS(EShooterStateTreeWake);
+
+/**
+ *  Something an active StateTree task is waiting on
+ */
+struct FShooterStateTreeWait
+{
+	/** Handle returned to the task that declared the wait */
+	int32 Handle = INDEX_NONE;
+
+	/** Events that end the wait */
+	EShooterStateTreeWake Conditions = EShooterStateTreeWake::None;
+
+	/** Timer waking the tree once the delay runs out */
+	FFPSTimerHandle Timer;
+
+	/** Actor watched for the TargetMoved condition, and where it was when the tree fell asleep */
+	TWeakObjectPtr<const AActor> Target;
+	FVector TargetLocation = FVector::ZeroVector;
+	float MoveThresholdSquared = 0.0f;
+};
+
+/**
+ *  StateTree AI component that sleeps between events
+ *  Active tasks declare what they are waiting on with AddWait. While any wait is declared the tree only runs a safety tick
+ *  every now and then, until an event one of the waits is interested in wakes it up for a full tick.
+ *  Tick costs are reported to UShooterStateTreeScheduler, which counts the sleeping trees and estimates the time saved
+ */
+UCLASS(ClassGroup = AI, meta = (BlueprintSpawnableComponent))
+class FPS_API UShooterStateTreeAIComponent : public UStateTreeAIComponent
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Waits declared by the active tasks */
+	TArray<FShooterStateTreeWait, TInlineAllocator<2>> Waits;
+
+	/** Handle given to the last declared wait */
+	int32 LastWaitHandle = 0;
+
+	/** Tick interval to run at while awake */
+	float AwakeTickInterval = 0.0f;
+
+	/** True while the tree only runs safety ticks */
+	bool bSleeping = false;
+
+	/** True if an event woke the tree and it hasn't ticked since */
+	bool bWakePending = false;
+
+public:
+
+	/**
+	 *  Declares a wait for the active task. The tree sleeps while any wait is declared
+	 *  @param Conditions		Events that wake the tree up
+	 *  @param TimerDelay		Delay in seconds for the Timer condition
+	 *  @param Target			Actor to watch for the TargetMoved condition
+	 *  @param MoveThreshold	Distance in cm the target has to move to wake the tree up
+	 *  @return Handle to pass to RemoveWait once the task exits
+	 */
+	int32 AddWait(EShooterStateTreeWake Conditions, float TimerDelay = 0.0f, const AActor* Target = nullptr, float MoveThreshold = 0.0f);
+
+	/** Removes a wait and invalidates its handle */
+	void RemoveWait(int32& Handle);
+
+	/** Wakes the tree up for a tick if any of the waits is interested in the event */
+	void Wake(EShooterStateTreeWake Reason);
+
+	/** Wakes the tree up if a watched target moved too far. Called by the scheduler while sleeping */
+	void PollWatchedTargets();
+
+	/** Returns true if the tree is only running safety ticks */
+	bool IsSleeping() const { return bSleeping; }
+
+	/** Sets the tick interval to run at while awake. Sleeping trees never tick faster than this either */
+	void SetAwakeTickInterval(float Interval);
+
+	/** Returns the tick interval the tree runs at while awake */
+	float GetAwakeTickInterval() const { return AwakeTickInterval; }
+
+	//~Begin UActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	//~End UActorComponent interface
+
+protected:
+
+	/** Puts the tree to sleep or wakes it up to match the declared waits */
+	void UpdateSleep();
+
+	/** Returns the events any of the waits is interested in */
+	EShooterStateTreeWake GetWaitConditions() const;
+};
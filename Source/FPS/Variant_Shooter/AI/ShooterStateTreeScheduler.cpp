@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterStateTreeScheduler.h"
+#include "ShooterStateTreeAIComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarStateTreeSleep(
+	TEXT("fps.StateTree.Sleep"),
+	true,
+	TEXT("If true, shooter StateTrees whose active tasks are waiting on an event only run safety ticks until the event happens.\n")
+	TEXT("If false, they tick every frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarStateTreeSafetyTickInterval(
+	TEXT("fps.StateTree.SafetyTickInterval"),
+	0.5f,
+	TEXT("Time in seconds between ticks of a sleeping shooter StateTree."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("StateTree Scheduler"), STAT_ShooterStateTreeScheduler, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("StateTree Sleeping NPCs"), STAT_ShooterStateTreeSleeping, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("StateTree Wake-ups/Frame"), STAT_ShooterStateTreeWakes, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("StateTree Safety Ticks/Frame"), STAT_ShooterStateTreeSafetyTicks, STATGROUP_FPS);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("StateTree ms Saved/Frame"), STAT_ShooterStateTreeSavedMs, STATGROUP_FPS);
+
+void UShooterStateTreeScheduler::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Register(&InWorld, TG_PrePhysics, TEXT("ShooterStateTreeScheduler"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterStateTreeScheduler::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Sleepers.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterStateTreeScheduler::IsEnabled() const
+{
+	return CVarStateTreeSleep.GetValueOnGameThread() && TickFunction.IsTickFunctionRegistered();
+}
+
+float UShooterStateTreeScheduler::GetSafetyTickInterval() const
+{
+	return FMath::Max(CVarStateTreeSafetyTickInterval.GetValueOnGameThread(), 0.0f);
+}
+
+void UShooterStateTreeScheduler::RegisterSleeper(UShooterStateTreeAIComponent* Sleeper)
+{
+	Sleepers.AddUnique(Sleeper);
+}
+
+void UShooterStateTreeScheduler::UnregisterSleeper(UShooterStateTreeAIComponent* Sleeper)
+{
+	Sleepers.RemoveSingleSwap(Sleeper, EAllowShrinking::No);
+}
+
+void UShooterStateTreeScheduler::ReportTick(double Seconds, bool bSafetyTick)
+{
+	if (bSafetyTick)
+	{
+		++NumSafetyTicks;
+		INC_DWORD_STAT(STAT_ShooterStateTreeSafetyTicks);
+
+	} else {
+
+		AwakeTickSeconds += Seconds;
+		++NumAwakeTicks;
+	}
+}
+
+void UShooterStateTreeScheduler::CountWake()
+{
+	INC_DWORD_STAT(STAT_ShooterStateTreeWakes);
+}
+
+void UShooterStateTreeScheduler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterStateTreeScheduler);
+
+	// fold last frame's awake ticks into the running average
+	if (NumAwakeTicks > 0)
+	{
+		const double FrameAverage = AwakeTickSeconds / NumAwakeTicks;
+
+		AverageTickSeconds = AverageTickSeconds > 0.0 ? FMath::Lerp(AverageTickSeconds, FrameAverage, 0.1) : FrameAverage;
+	}
+
+	// awake, a tree ticks once per frame or once per awake interval, whichever is slower. The safety ticks it ran anyway don't count
+	float ExpectedTicks = 0.0f;
+
+	if (DeltaTime > 0.0f)
+	{
+		for (const TWeakObjectPtr<UShooterStateTreeAIComponent>& Sleeper : Sleepers)
+		{
+			if (const UShooterStateTreeAIComponent* SleeperComponent = Sleeper.Get())
+			{
+				ExpectedTicks += DeltaTime / FMath::Max(SleeperComponent->GetAwakeTickInterval(), DeltaTime);
+			}
+		}
+	}
+
+	const float SkippedTicks = FMath::Max(ExpectedTicks - NumSafetyTicks, 0.0f);
+	SavedMs = float(SkippedTicks * AverageTickSeconds * 1000.0);
+
+	SET_DWORD_STAT(STAT_ShooterStateTreeSleeping, Sleepers.Num());
+	SET_FLOAT_STAT(STAT_ShooterStateTreeSavedMs, SavedMs);
+
+	AwakeTickSeconds = 0.0;
+	NumAwakeTicks = 0;
+	NumSafetyTicks = 0;
+
+	// waking a tree unregisters it, so walk backwards
+	for (int32 Index = Sleepers.Num() - 1; Index >= 0; --Index)
+	{
+		if (UShooterStateTreeAIComponent* Sleeper = Sleepers[Index].Get())
+		{
+			Sleeper->PollWatchedTargets();
+
+		} else {
+
+			Sleepers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+}
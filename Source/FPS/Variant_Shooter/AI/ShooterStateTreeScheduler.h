@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterStateTreeScheduler.generated.h"
+
+class UShooterStateTreeAIComponent;
+
+/**
+ *  Keeps track of the sleeping shooter StateTrees
+ *  Polls the actors the sleeping trees are watching, so only the scheduler runs every frame, and measures the average cost
+ *  of an awake StateTree tick to estimate the time saved by the trees that skipped their tick
+ */
+UCLASS()
+class FPS_API UShooterStateTreeScheduler : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Trees currently sleeping */
+	TArray<TWeakObjectPtr<UShooterStateTreeAIComponent>> Sleepers;
+
+	/** Ticks reported since the last update */
+	double AwakeTickSeconds = 0.0;
+	int32 NumAwakeTicks = 0;
+	int32 NumSafetyTicks = 0;
+
+	/** Running average cost of an awake StateTree tick, in seconds */
+	double AverageTickSeconds = 0.0;
+
+	/** Estimated time saved by the sleeping trees last frame, in milliseconds */
+	float SavedMs = 0.0f;
+
+	/** Polls the watched targets and updates the stats */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/** Returns true if StateTrees may sleep */
+	bool IsEnabled() const;
+
+	/** Returns the time between ticks of a sleeping tree */
+	float GetSafetyTickInterval() const;
+
+	/** Starts polling a tree that fell asleep */
+	void RegisterSleeper(UShooterStateTreeAIComponent* Sleeper);
+
+	/** Stops polling a tree that woke up */
+	void UnregisterSleeper(UShooterStateTreeAIComponent* Sleeper);
+
+	/** Records the cost of a StateTree tick */
+	void ReportTick(double Seconds, bool bSafetyTick);
+
+	/** Counts a tree woken up by an event */
+	void CountWake();
+
+	/** Returns the number of sleeping trees */
+	int32 GetNumSleeping() const { return Sleepers.Num(); }
+
+	/** Returns the estimated time saved by the sleeping trees last frame, in milliseconds */
+	float GetSavedMs() const { return SavedMs; }
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Polls the watched targets and updates the stats */
+	void Tick(float DeltaTime);
+};
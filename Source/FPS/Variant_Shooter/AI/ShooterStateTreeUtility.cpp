@@ -8,8 +8,20 @@
 #include "AIController.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "ShooterAIController.h"
+#include "ShooterVisibilityService.h"
+#include "ShooterPotentialVisibility.h"
+#include "ShooterPerceptionPipeline.h"
+#include "ShooterStateTreeAIComponent.h"
 #include "StateTreeAsyncExecutionContext.h"
 
+/** Returns the sleep capable StateTree component running the tree, if any */
+static UShooterStateTreeAIComponent* GetShooterStateTreeAI(FStateTreeExecutionContext& Context)
+{
+	const AShooterAIController* Controller = Cast<AShooterAIController>(Context.GetOwner());
+
+	return Controller ? Controller->GetStateTreeAI() : nullptr;
+}
+
 bool FStateTreeLineOfSightToTargetCondition::TestCondition(FStateTreeExecutionContext& Context) const
 {
 	const FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
@@ -32,6 +44,15 @@ bool FStateTreeLineOfSightToTargetCondition::TestCondition(FStateTreeExecutionCo
 		return !InstanceData.bMustHaveLineOfSight;
 	}
 
+	// answer from the visibility service cache if we can. It refreshes the pair within its ray budget
+	UShooterVisibilityService* Visibility = InstanceData.Character->GetWorld()->GetSubsystem<UShooterVisibilityService>();
+
+	if (Visibility && Visibility->IsEnabled())
+	{
+		const bool bHasLineOfSight = Visibility->HasLineOfSight(InstanceData.Character, InstanceData.Target, InstanceData.NumberOfVerticalLineOfSightChecks);
+		return bHasLineOfSight == InstanceData.bMustHaveLineOfSight;
+	}
+
 	// get the target's bounding box
 	FVector CenterOfMass, Extent;
 	InstanceData.Target->GetActorBounds(true, CenterOfMass, Extent, false);
@@ -42,6 +63,14 @@ bool FStateTreeLineOfSightToTargetCondition::TestCondition(FStateTreeExecutionCo
 	// get the character's camera location as the source for the line checks
 	const FVector Start = InstanceData.Character->GetFirstPersonCameraComponent()->GetComponentLocation();
 
+	// skip the traces if static geometry always separates us from the target
+	const UShooterPotentialVisibility* PotentialVisibility = InstanceData.Character->GetWorld()->GetSubsystem<UShooterPotentialVisibility>();
+
+	if (PotentialVisibility && !PotentialVisibility->IsPotentiallyVisible(Start, InstanceData.Target->GetActorLocation()))
+	{
+		return !InstanceData.bMustHaveLineOfSight;
+	}
+
 	// ignore the character and target. We want to ensure there's an unobstructed trace not counting them
 	FCollisionQueryParams QueryParams;
 	QueryParams.AddIgnoredActor(InstanceData.Character);
@@ -162,11 +191,36 @@ EStateTreeRunStatus FStateTreeSetRandomFloatTask::EnterState(FStateTreeExecution
 
 		// calculate the output value
 		InstanceData.OutValue = FMath::RandRange(InstanceData.MinValue, InstanceData.MaxValue);
+
+		// sleep until the delay runs out, unless something else happens first
+		if (InstanceData.bSleepUntilElapsed)
+		{
+			if (UShooterStateTreeAIComponent* StateTreeAI = GetShooterStateTreeAI(Context))
+			{
+				InstanceData.WaitHandle = StateTreeAI->AddWait(EShooterStateTreeWake::Timer | EShooterStateTreeWake::Perception | EShooterStateTreeWake::MoveCompleted, InstanceData.OutValue);
+			}
+		}
 	}
 
 	return EStateTreeRunStatus::Running;
 }
 
+void FStateTreeSetRandomFloatTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	// have we transitioned to another state?
+	if (Transition.ChangeType == EStateTreeStateChangeType::Changed)
+	{
+		// get the instance data
+		FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+		// stop waiting on the delay
+		if (UShooterStateTreeAIComponent* StateTreeAI = GetShooterStateTreeAI(Context))
+		{
+			StateTreeAI->RemoveWait(InstanceData.WaitHandle);
+		}
+	}
+}
+
 #if WITH_EDITOR
 FText FStateTreeSetRandomFloatTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
 {
@@ -176,6 +230,61 @@ FText FStateTreeSetRandomFloatTask::GetDescription(const FGuid& ID, FStateTreeDa
 
 ////////////////////////////////////////////////////////////////////
 
+EStateTreeRunStatus FStateTreeShooterDelayTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	// get the instance data
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// roll the delay
+	const float Duration = FMath::RandRange(InstanceData.MinDuration, FMath::Max(InstanceData.MinDuration, InstanceData.MaxDuration));
+	InstanceData.EndTime = Context.GetWorld()->GetTimeSeconds() + Duration;
+
+	// nothing to do until the delay runs out, so sleep until then
+	if (UShooterStateTreeAIComponent* StateTreeAI = GetShooterStateTreeAI(Context))
+	{
+		EShooterStateTreeWake Conditions = EShooterStateTreeWake::Timer;
+
+		if (InstanceData.bWakeOnPerception)
+		{
+			Conditions |= EShooterStateTreeWake::Perception;
+		}
+
+		InstanceData.WaitHandle = StateTreeAI->AddWait(Conditions, Duration);
+	}
+
+	return EStateTreeRunStatus::Running;
+}
+
+EStateTreeRunStatus FStateTreeShooterDelayTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+	// get the instance data
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// compare against the clock rather than summing delta times, so the tick the timer wakes us for always finishes the delay
+	return Context.GetWorld()->GetTimeSeconds() >= InstanceData.EndTime ? EStateTreeRunStatus::Succeeded : EStateTreeRunStatus::Running;
+}
+
+void FStateTreeShooterDelayTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+	// get the instance data
+	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
+
+	// stop waiting on the delay
+	if (UShooterStateTreeAIComponent* StateTreeAI = GetShooterStateTreeAI(Context))
+	{
+		StateTreeAI->RemoveWait(InstanceData.WaitHandle);
+	}
+}
+
+#if WITH_EDITOR
+FText FStateTreeShooterDelayTask::GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting /*= EStateTreeNodeFormatting::Text*/) const
+{
+	return FText::FromString("<b>Shooter Delay</b>");
+}
+#endif // WITH_EDITOR
+
+////////////////////////////////////////////////////////////////////
+
 EStateTreeRunStatus FStateTreeShootAtTargetTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned from another state?
@@ -186,6 +295,15 @@ EStateTreeRunStatus FStateTreeShootAtTargetTask::EnterState(FStateTreeExecutionC
 
 		// tell the character to shoot the target
 		InstanceData.Character->StartShooting(InstanceData.Target);
+
+		// the character keeps shooting on its own, so sleep until the target gets away or we lose track of it
+		if (InstanceData.bSleepWhileShooting)
+		{
+			if (UShooterStateTreeAIComponent* StateTreeAI = GetShooterStateTreeAI(Context))
+			{
+				InstanceData.WaitHandle = StateTreeAI->AddWait(EShooterStateTreeWake::TargetMoved | EShooterStateTreeWake::Perception, 0.0f, InstanceData.Target, InstanceData.TargetMoveThreshold);
+			}
+		}
 	}
 
 	return EStateTreeRunStatus::Running;
@@ -201,6 +319,12 @@ void FStateTreeShootAtTargetTask::ExitState(FStateTreeExecutionContext& Context,
 
 		// tell the character to stop shooting
 		InstanceData.Character->StopShooting();
+
+		// stop watching the target
+		if (UShooterStateTreeAIComponent* StateTreeAI = GetShooterStateTreeAI(Context))
+		{
+			StateTreeAI->RemoveWait(InstanceData.WaitHandle);
+		}
 	}
 }
 
@@ -230,6 +354,27 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 				{
 					if (SensedActor->ActorHasTag(LambdaInstanceData->SenseTag))
 					{
+						// hand the stimulus to the perception pipeline. It commits the result at its next sync point
+						UShooterPerceptionPipeline* Pipeline = LambdaInstanceData->Character->GetWorld()->GetSubsystem<UShooterPerceptionPipeline>();
+
+						if (Pipeline && Pipeline->IsEnabled())
+						{
+							Pipeline->QueueStimulus(LambdaInstanceData->Character, SensedActor, Stimulus.StimulusLocation, LambdaInstanceData->DirectLineOfSightCone,
+								[WeakContext, WeakSensedActor = TWeakObjectPtr<AActor>(SensedActor), Strength = Stimulus.Strength, StimulusLocation = Stimulus.StimulusLocation](bool bDirectLOS)
+								{
+									// the task may have exited while the stimulus was in flight
+									const FStateTreeStrongExecutionContext CommitContext = WeakContext.MakeStrongExecutionContext();
+									FInstanceDataType* CommitInstanceData = CommitContext.GetInstanceDataPtr<FInstanceDataType>();
+
+									if (CommitInstanceData && WeakSensedActor.IsValid())
+									{
+										CommitSensedActor(*CommitInstanceData, WeakSensedActor.Get(), Strength, StimulusLocation, bDirectLOS);
+									}
+								});
+
+							return;
+						}
+
 						bool bDirectLOS = false;
 
 						// calculate the direction of the stimulus
@@ -239,8 +384,12 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 						const float DirDot = FVector::DotProduct(StimulusDir, LambdaInstanceData->Character->GetActorForwardVector());
 						const float MaxDot = FMath::Cos(FMath::DegreesToRadians(LambdaInstanceData->DirectLineOfSightCone));
 
+						// skip the trace if static geometry always separates us from the sensed actor
+						const UShooterPotentialVisibility* PotentialVisibility = LambdaInstanceData->Character->GetWorld()->GetSubsystem<UShooterPotentialVisibility>();
+						const bool bPotentiallyVisible = !PotentialVisibility || PotentialVisibility->IsPotentiallyVisible(LambdaInstanceData->Character->GetActorLocation(), SensedActor->GetActorLocation());
+
 						// is the direction within our perception cone?
-						if (DirDot >= MaxDot)
+						if (DirDot >= MaxDot && bPotentiallyVisible)
 						{
 							// run a line trace between the character and the sensed actor
 							FCollisionQueryParams QueryParams;
@@ -254,39 +403,7 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 
 						}
 
-						// check if we have a direct line of sight to the stimulus
-						if (bDirectLOS)
-						{
-							// set the controller's target
-							LambdaInstanceData->Controller->SetCurrentTarget(SensedActor);
-
-							// set the task output
-							LambdaInstanceData->TargetActor = SensedActor;
-
-							// set the flags
-							LambdaInstanceData->bHasTarget = true;
-							LambdaInstanceData->bHasInvestigateLocation = false;
-
-						// no direct line of sight to target
-						} else {
-
-							// if we already have a target, ignore the partial sense and keep on them
-							if (!IsValid(LambdaInstanceData->TargetActor))
-							{
-								// is this stimulus stronger than the last one we had?
-								if (Stimulus.Strength > LambdaInstanceData->LastStimulusStrength)
-								{
-									// update the stimulus strength
-									LambdaInstanceData->LastStimulusStrength = Stimulus.Strength;
-
-									// set the investigate location
-									LambdaInstanceData->InvestigateLocation = Stimulus.StimulusLocation;
-
-									// set the investigate flag
-									LambdaInstanceData->bHasInvestigateLocation = true;
-								}
-							}
-						}
+						CommitSensedActor(*LambdaInstanceData, SensedActor, Stimulus.Strength, Stimulus.StimulusLocation, bDirectLOS);
 					}
 				}
 			}
@@ -335,6 +452,9 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 					// clear the target on the controller
 					LambdaInstanceData->Controller->ClearCurrentTarget();
 					LambdaInstanceData->Controller->ClearFocus(EAIFocusPriority::Gameplay);
+
+					// let the tree react to the lost target
+					LambdaInstanceData->Controller->WakeStateTree(EShooterStateTreeWake::Perception);
 				}
 
 			}
@@ -344,6 +464,49 @@ EStateTreeRunStatus FStateTreeSenseEnemiesTask::EnterState(FStateTreeExecutionCo
 	return EStateTreeRunStatus::Running;
 }
 
+void FStateTreeSenseEnemiesTask::CommitSensedActor(FInstanceDataType& InstanceData, AActor* SensedActor, float StimulusStrength, const FVector& StimulusLocation, bool bDirectLOS)
+{
+	// check if we have a direct line of sight to the stimulus
+	if (bDirectLOS)
+	{
+		// set the controller's target
+		InstanceData.Controller->SetCurrentTarget(SensedActor);
+
+		// set the task output
+		InstanceData.TargetActor = SensedActor;
+
+		// set the flags
+		InstanceData.bHasTarget = true;
+		InstanceData.bHasInvestigateLocation = false;
+
+		// let the tree react to the new target
+		InstanceData.Controller->WakeStateTree(EShooterStateTreeWake::Perception);
+
+	// no direct line of sight to target
+	} else {
+
+		// if we already have a target, ignore the partial sense and keep on them
+		if (!IsValid(InstanceData.TargetActor))
+		{
+			// is this stimulus stronger than the last one we had?
+			if (StimulusStrength > InstanceData.LastStimulusStrength)
+			{
+				// update the stimulus strength
+				InstanceData.LastStimulusStrength = StimulusStrength;
+
+				// set the investigate location
+				InstanceData.InvestigateLocation = StimulusLocation;
+
+				// set the investigate flag
+				InstanceData.bHasInvestigateLocation = true;
+
+				// let the tree react to the new location
+				InstanceData.Controller->WakeStateTree(EShooterStateTreeWake::Perception);
+			}
+		}
+	}
+}
+
 void FStateTreeSenseEnemiesTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
 {
 	// have we transitioned to another state?
@@ -172,6 +172,17 @@ struct FStateTreeSetRandomFloatData
 	/** Output calculated value */
 	UPROPERTY(EditAnywhere, Category = Output)
 	float OutValue = 0.0f;
+
+	/**
+	 *  If true, the value is a delay and the StateTree sleeps until it runs out, a perception event or a move completion.
+	 *  Only enable it when the value feeds a delay that ends the state, otherwise the tree sleeps through work it should be doing.
+	 *  Prefer the Shooter Delay task, which declares its own wait
+	 */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	bool bSleepUntilElapsed = false;
+
+	/** Wait declared on the StateTree component while sleeping */
+	int32 WaitHandle = INDEX_NONE;
 };
 
 /**
@@ -189,6 +200,65 @@ struct FStateTreeSetRandomFloatTask : public FStateTreeTaskCommonBase
 	/** Runs when the owning state is entered */
 	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
+	/** Runs when the owning state is ended */
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+#if WITH_EDITOR
+	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
+#endif // WITH_EDITOR
+};
+
+////////////////////////////////////////////////////////////////////
+
+/**
+ *  Instance data struct for the Shooter Delay StateTree task
+ */
+USTRUCT()
+struct FStateTreeShooterDelayInstanceData
+{
+	GENERATED_BODY()
+
+	/** Minimum delay */
+	UPROPERTY(EditAnywhere, Category = Parameter, meta = (ClampMin = 0, Units = "s"))
+	float MinDuration = 1.0f;
+
+	/** Maximum delay */
+	UPROPERTY(EditAnywhere, Category = Parameter, meta = (ClampMin = 0, Units = "s"))
+	float MaxDuration = 1.0f;
+
+	/** If true, a perception event wakes the StateTree before the delay runs out, so its transitions can react */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	bool bWakeOnPerception = true;
+
+	/** Game time the delay runs out at */
+	double EndTime = 0.0;
+
+	/** Wait declared on the StateTree component while sleeping */
+	int32 WaitHandle = INDEX_NONE;
+};
+
+/**
+ *  StateTree task that waits for a random delay and then succeeds
+ *  The StateTree sleeps while waiting, and is woken up by a timer when the delay runs out
+ */
+USTRUCT(meta=(DisplayName="Shooter Delay", Category="Shooter"))
+struct FStateTreeShooterDelayTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	/* Ensure we're using the correct instance data struct */
+	using FInstanceDataType = FStateTreeShooterDelayInstanceData;
+	virtual const UStruct* GetInstanceDataType() const override { return FInstanceDataType::StaticStruct(); }
+
+	/** Runs when the owning state is entered */
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	/** Runs while the owning state is active */
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+	/** Runs when the owning state is ended */
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
 #if WITH_EDITOR
 	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
 #endif // WITH_EDITOR
@@ -211,6 +281,17 @@ struct FStateTreeShootAtTargetInstanceData
 	/** Target to shoot at */
 	UPROPERTY(EditAnywhere, Category = Input)
 	TObjectPtr<AActor> Target;
+
+	/** If true, the StateTree sleeps while shooting until the target moves or a perception event */
+	UPROPERTY(EditAnywhere, Category = Parameter)
+	bool bSleepWhileShooting = true;
+
+	/** Distance the target has to move to wake the StateTree up */
+	UPROPERTY(EditAnywhere, Category = Parameter, meta = (ClampMin = 0, Units = "cm"))
+	float TargetMoveThreshold = 100.0f;
+
+	/** Wait declared on the StateTree component while sleeping */
+	int32 WaitHandle = INDEX_NONE;
 };
 
 /**
@@ -301,6 +382,9 @@ struct FStateTreeSenseEnemiesTask : public FStateTreeTaskCommonBase
 	/** Runs when the owning state is ended */
 	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
 
+	/** Writes the outcome of a processed stimulus to the instance data and the controller */
+	static void CommitSensedActor(FInstanceDataType& InstanceData, AActor* SensedActor, float StimulusStrength, const FVector& StimulusLocation, bool bDirectLOS);
+
 #if WITH_EDITOR
 	virtual FText GetDescription(const FGuid& ID, FStateTreeDataView InstanceDataView, const IStateTreeBindingLookup& BindingLookup, EStateTreeNodeFormatting Formatting = EStateTreeNodeFormatting::Text) const override;
 #endif // WITH_EDITOR
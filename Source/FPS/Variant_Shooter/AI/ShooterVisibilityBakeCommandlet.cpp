@@ -0,0 +1,413 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterVisibilityBakeCommandlet.h"
+#include "ShooterPotentialVisibility.h"
+#include "Async/ParallelFor.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "FPS.h"
+
+UShooterVisibilityBakeCommandlet::UShooterVisibilityBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UShooterVisibilityBakeCommandlet::Main(const FString& Params)
+{
+	FString MapList;
+	float CellSize = 500.0f;
+	int32 MaxCells = 4096;
+
+	FParse::Value(*Params, TEXT("Map="), MapList);
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+	FParse::Value(*Params, TEXT("MaxCells="), MaxCells);
+
+	TArray<FString> Maps;
+	MapList.ParseIntoArray(Maps, TEXT(","));
+
+	if (Maps.Num() == 0)
+	{
+		Maps = GetDefaultMaps();
+	}
+
+	int32 NumFailed = 0;
+
+	for (const FString& Map : Maps)
+	{
+		if (!BakeMap(Map, FMath::Max(CellSize, 50.0f), FMath::Max(MaxCells, 1)))
+		{
+			++NumFailed;
+		}
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+TArray<FString> UShooterVisibilityBakeCommandlet::GetDefaultMaps()
+{
+	TArray<FString> Files;
+	IFileManager::Get().FindFilesRecursive(Files, *(FPaths::ProjectContentDir() / TEXT("Maps")), *(TEXT("*") + FPackageName::GetMapPackageExtension()), true, false);
+
+	TArray<FString> Maps;
+
+	for (const FString& File : Files)
+	{
+		FString PackageName;
+		if (FPackageName::TryConvertFilenameToLongPackageName(File, PackageName))
+		{
+			Maps.Add(PackageName);
+		}
+	}
+
+	// the shooter variant keeps its level next to its content
+	Maps.AddUnique(TEXT("/Game/Variant_Shooter/Lvl_Shooter"));
+
+	return Maps;
+}
+
+void UShooterVisibilityBakeCommandlet::DilateRows(TArray<uint64>& Bits, const FShooterPVSHeader& Header)
+{
+	const int32 WordsPerRow = Header.WordsPerRow;
+	const int32 NumCells = Header.GetNumCells();
+
+	TArray<uint64> Dilated;
+	Dilated.SetNumZeroed(Bits.Num());
+
+	// each task only writes its own row
+	ParallelFor(NumCells, [&](int32 Cell)
+	{
+		const int32 X = Cell % Header.DimX;
+		const int32 Y = (Cell / Header.DimX) % Header.DimY;
+		const int32 Z = Cell / (Header.DimX * Header.DimY);
+
+		uint64* Row = &Dilated[int64(Cell) * WordsPerRow];
+
+		for (int32 NZ = FMath::Max(Z - 1, 0); NZ <= FMath::Min(Z + 1, Header.DimZ - 1); ++NZ)
+		{
+			for (int32 NY = FMath::Max(Y - 1, 0); NY <= FMath::Min(Y + 1, Header.DimY - 1); ++NY)
+			{
+				for (int32 NX = FMath::Max(X - 1, 0); NX <= FMath::Min(X + 1, Header.DimX - 1); ++NX)
+				{
+					const uint64* NeighbourRow = &Bits[(int64(NZ) * Header.DimY * Header.DimX + int64(NY) * Header.DimX + NX) * WordsPerRow];
+
+					for (int32 Word = 0; Word < WordsPerRow; ++Word)
+					{
+						Row[Word] |= NeighbourRow[Word];
+					}
+				}
+			}
+		}
+	});
+
+	Bits = MoveTemp(Dilated);
+}
+
+void UShooterVisibilityBakeCommandlet::TransposeRows(TArray<uint64>& Bits, int32 NumCells, int32 WordsPerRow)
+{
+	TArray<uint64> Transposed;
+	Transposed.SetNumZeroed(Bits.Num());
+
+	// each task only writes its own row of the transpose
+	ParallelFor(NumCells, [&](int32 Column)
+	{
+		uint64* Row = &Transposed[int64(Column) * WordsPerRow];
+
+		for (int32 Cell = 0; Cell < NumCells; ++Cell)
+		{
+			if ((Bits[int64(Cell) * WordsPerRow + (Column >> 6)] >> (Column & 63)) & 1)
+			{
+				Row[Cell >> 6] |= uint64(1) << (Cell & 63);
+			}
+		}
+	});
+
+	Bits = MoveTemp(Transposed);
+}
+
+bool UShooterVisibilityBakeCommandlet::BakeMap(const FString& MapPackageName, float CellSize, int32 MaxCells)
+{
+	UPackage* Package = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+	if (!World)
+	{
+		UE_LOG(LogFPS, Error, TEXT("Couldn't load map %s"), *MapPackageName);
+		return false;
+	}
+
+	// bring up collision for the persistent level only. Streamed sublevels aren't baked
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+
+	const bool bInitializedWorld = !World->bIsWorldInitialized;
+
+	if (bInitializedWorld)
+	{
+		UWorld::InitializationValues IVS;
+		IVS.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+
+		World->InitWorld(IVS);
+	}
+
+	World->UpdateWorldComponents(true, false);
+
+	auto ReleaseWorld = [World, bInitializedWorld]()
+	{
+		if (bInitializedWorld)
+		{
+			World->DestroyWorld(false);
+		}
+
+		World->RemoveFromRoot();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	};
+
+	// size the grid to the static geometry that can block sight
+	FBox Bounds(ForceInit);
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		It->ForEachComponent<UPrimitiveComponent>(false, [&Bounds](UPrimitiveComponent* Component)
+		{
+			if (Component->Mobility == EComponentMobility::Static && Component->IsCollisionEnabled() && Component->GetCollisionResponseToChannel(ECC_Visibility) == ECR_Block)
+			{
+				Bounds += Component->Bounds.GetBox();
+			}
+		});
+	}
+
+	if (!Bounds.IsValid)
+	{
+		UE_LOG(LogFPS, Warning, TEXT("%s has no static geometry to bake against"), *MapPackageName);
+
+		ReleaseWorld();
+		return true;
+	}
+
+	const FVector Size = Bounds.GetSize();
+
+	auto GetDim = [&Size](double Extent, float InCellSize) { return FMath::Max(1, FMath::CeilToInt32(Extent / InCellSize)); };
+	auto GetNumCells = [&](float InCellSize) { return int64(GetDim(Size.X, InCellSize)) * GetDim(Size.Y, InCellSize) * GetDim(Size.Z, InCellSize); };
+
+	while (GetNumCells(CellSize) > MaxCells)
+	{
+		CellSize *= 1.25f;
+	}
+
+	FShooterPVSHeader Header;
+	Header.Origin = FVector3f(Bounds.Min);
+	Header.CellSize = CellSize;
+	Header.DimX = GetDim(Size.X, CellSize);
+	Header.DimY = GetDim(Size.Y, CellSize);
+	Header.DimZ = GetDim(Size.Z, CellSize);
+
+	const int32 NumCells = Header.GetNumCells();
+	const int32 WordsPerRow = FMath::DivideAndRoundUp(NumCells, 64);
+	Header.WordsPerRow = WordsPerRow;
+
+	// only static geometry is baked, since anything that moves can't be trusted to stay in the way
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterVisibilityBake), false);
+	QueryParams.MobilityType = EQueryMobilityType::Static;
+
+	// sample each cell at its center and at four spread out points, keeping the ones outside geometry
+	const float SampleOffset = CellSize * 0.3f;
+	const FVector SampleOffsets[] = {
+		FVector::ZeroVector,
+		FVector(SampleOffset, SampleOffset, SampleOffset),
+		FVector(SampleOffset, -SampleOffset, -SampleOffset),
+		FVector(-SampleOffset, SampleOffset, -SampleOffset),
+		FVector(-SampleOffset, -SampleOffset, SampleOffset)
+	};
+
+	TArray<TArray<FVector, TInlineAllocator<5>>> CellSamples;
+	CellSamples.SetNum(NumCells);
+
+	ParallelFor(NumCells, [&](int32 Cell)
+	{
+		const int32 X = Cell % Header.DimX;
+		const int32 Y = (Cell / Header.DimX) % Header.DimY;
+		const int32 Z = Cell / (Header.DimX * Header.DimY);
+
+		const FVector Center = Bounds.Min + (FVector(X, Y, Z) + 0.5) * CellSize;
+
+		for (const FVector& Offset : SampleOffsets)
+		{
+			const FVector Sample = Center + Offset;
+
+			if (!World->OverlapBlockingTestByChannel(Sample, FQuat::Identity, ECC_Visibility, FCollisionShape::MakeSphere(1.0f), QueryParams))
+			{
+				CellSamples[Cell].Add(Sample);
+			}
+		}
+	});
+
+	// cells buried in geometry have nowhere to sample from, so they see and are seen by everything
+	TArray<uint64> Bits;
+	Bits.SetNumZeroed(int64(NumCells) * WordsPerRow);
+
+	auto SetBit = [&Bits, WordsPerRow](int32 Row, int32 Column) { Bits[int64(Row) * WordsPerRow + (Column >> 6)] |= uint64(1) << (Column & 63); };
+	auto GetBit = [&Bits, WordsPerRow](int32 Row, int32 Column) { return (Bits[int64(Row) * WordsPerRow + (Column >> 6)] >> (Column & 63)) & 1; };
+
+	// fill the upper triangle. Each task only writes its own row
+	ParallelFor(NumCells, [&](int32 CellA)
+	{
+		SetBit(CellA, CellA);
+
+		if (CellSamples[CellA].Num() == 0)
+		{
+			return;
+		}
+
+		for (int32 CellB = CellA + 1; CellB < NumCells; ++CellB)
+		{
+			if (CellSamples[CellB].Num() == 0)
+			{
+				continue;
+			}
+
+			bool bVisible = false;
+
+			for (const FVector& From : CellSamples[CellA])
+			{
+				for (const FVector& To : CellSamples[CellB])
+				{
+					if (!World->LineTraceTestByChannel(From, To, ECC_Visibility, QueryParams))
+					{
+						bVisible = true;
+						break;
+					}
+				}
+
+				if (bVisible)
+				{
+					break;
+				}
+			}
+
+			if (bVisible)
+			{
+				SetBit(CellA, CellB);
+			}
+		}
+	});
+
+	// mirror into the lower triangle, and open up the buried cells
+	int32 NumOpenCells = 0;
+
+	for (int32 CellA = 0; CellA < NumCells; ++CellA)
+	{
+		const bool bBuriedA = CellSamples[CellA].Num() == 0;
+		NumOpenCells += bBuriedA ? 0 : 1;
+
+		for (int32 CellB = CellA + 1; CellB < NumCells; ++CellB)
+		{
+			const bool bBuriedB = CellSamples[CellB].Num() == 0;
+
+			if (bBuriedA || bBuriedB || GetBit(CellA, CellB))
+			{
+				SetBit(CellA, CellB);
+				SetBit(CellB, CellA);
+			}
+		}
+	}
+
+	// a handful of samples can miss a gap that points elsewhere in the cells see through, and runtime takes a culled pair
+	// as a definite no. Stay conservative by letting each cell see whatever its neighbours see, on both ends of the pair:
+	// dilating the rows covers the observer's neighbours, and dilating the rows of the transpose covers the target's
+	DilateRows(Bits, Header);
+	TransposeRows(Bits, NumCells, WordsPerRow);
+	DilateRows(Bits, Header);
+
+	int64 NumVisiblePairs = 0;
+
+	for (int32 CellA = 0; CellA < NumCells; ++CellA)
+	{
+		for (int32 CellB = CellA + 1; CellB < NumCells; ++CellB)
+		{
+			if (CellSamples[CellA].Num() > 0 && CellSamples[CellB].Num() > 0 && GetBit(CellA, CellB))
+			{
+				++NumVisiblePairs;
+			}
+		}
+	}
+
+	// deduplicate the rows
+	TArray<uint32> RowIndices;
+	RowIndices.SetNumUninitialized(NumCells);
+
+	TArray<uint64> UniqueRows;
+	TMultiMap<uint32, uint32> RowsByHash;
+
+	for (int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		const uint64* Row = &Bits[int64(Cell) * WordsPerRow];
+		const uint32 Hash = FCrc::MemCrc32(Row, WordsPerRow * sizeof(uint64));
+
+		int32 RowIndex = INDEX_NONE;
+
+		for (TMultiMap<uint32, uint32>::TConstKeyIterator It(RowsByHash, Hash); It; ++It)
+		{
+			if (FMemory::Memcmp(&UniqueRows[int64(It.Value()) * WordsPerRow], Row, WordsPerRow * sizeof(uint64)) == 0)
+			{
+				RowIndex = It.Value();
+				break;
+			}
+		}
+
+		if (RowIndex == INDEX_NONE)
+		{
+			RowIndex = Header.NumRows++;
+			RowsByHash.Add(Hash, RowIndex);
+			UniqueRows.Append(Row, WordsPerRow);
+		}
+
+		RowIndices[Cell] = RowIndex;
+	}
+
+	// header, row indices padded to 8 bytes, then the rows
+	TArray<uint8> FileData;
+	FileData.SetNumZeroed(Header.GetFileSize());
+
+	FMemory::Memcpy(FileData.GetData(), &Header, sizeof(Header));
+	FMemory::Memcpy(FileData.GetData() + FShooterPVSHeader::GetRowIndicesOffset(), RowIndices.GetData(), RowIndices.Num() * sizeof(uint32));
+	FMemory::Memcpy(FileData.GetData() + Header.GetRowsOffset(), UniqueRows.GetData(), UniqueRows.Num() * sizeof(uint64));
+
+	const FString Path = UShooterPotentialVisibility::GetSidecarPath(MapPackageName);
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+
+	const bool bSaved = FFileHelper::SaveArrayToFile(FileData, *Path);
+
+	// this is a share of cell pairs, not of traces. How many traces it saves depends on where the AI and its targets stand,
+	// which only the PVS Culled/Frame stat can tell at runtime
+	const int64 NumOpenPairs = int64(NumOpenCells) * (NumOpenCells - 1) / 2;
+	const double CulledPercent = NumOpenPairs > 0 ? 100.0 * double(NumOpenPairs - NumVisiblePairs) / NumOpenPairs : 0.0;
+
+	if (bSaved)
+	{
+		UE_LOG(LogFPS, Display, TEXT("%s: %d cells of %.0fcm, %d open. %lld of %lld open cell pairs potentially visible, %.1f%% of open cell pairs culled. %u unique rows, %d bytes written to %s"),
+			*FPackageName::GetShortName(MapPackageName), NumCells, CellSize, NumOpenCells, NumVisiblePairs, NumOpenPairs, CulledPercent, Header.NumRows, FileData.Num(), *Path);
+	}
+	else
+	{
+		UE_LOG(LogFPS, Error, TEXT("Couldn't save the potential visibility of %s to %s"), *MapPackageName, *Path);
+	}
+
+	ReleaseWorld();
+
+	return bSaved;
+}
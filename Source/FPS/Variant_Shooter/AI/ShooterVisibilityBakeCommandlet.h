@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ShooterPotentialVisibility.h"
+#include "ShooterVisibilityBakeCommandlet.generated.h"
+
+/**
+ *  Bakes the potential visibility sidecar read by UShooterPotentialVisibility
+ *  Each map is split into coarse cells over its static geometry, and every pair of cells is tested with a handful of
+ *  sample rays against static collision. Cells are potentially visible if any sample ray gets through.
+ *  The matrix is then dilated so each cell also sees what its neighbours see, which keeps the culling conservative
+ *  where the samples missed a gap. Rows of the resulting visibility matrix are deduplicated before saving,
+ *  since neighbouring cells tend to see the same cells.
+ *
+ *  Usage: -run=ShooterVisibilityBake [-Map=/Game/Maps/Shooting_01,...] [-CellSize=500] [-MaxCells=4096]
+ *  Bakes every map under Content/Maps and the shooter level if no map is passed
+ */
+UCLASS()
+class FPS_API UShooterVisibilityBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Constructor */
+	UShooterVisibilityBakeCommandlet();
+
+	//~Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~End UCommandlet interface
+
+protected:
+
+	/**
+	 *  Bakes and saves the sidecar of one map, and logs the share of open cell pairs it culls
+	 *  @param MapPackageName	Long package name of the map
+	 *  @param CellSize			Requested cell edge length. Grown if the map needs more than MaxCells cells
+	 *  @param MaxCells			Max number of cells in the grid
+	 *  @return false if the map couldn't be loaded or the sidecar couldn't be saved
+	 */
+	bool BakeMap(const FString& MapPackageName, float CellSize, int32 MaxCells);
+
+	/** Returns the maps to bake when none are passed on the command line */
+	static TArray<FString> GetDefaultMaps();
+
+	/** ORs every row of the visibility matrix with the rows of the cells around it */
+	static void DilateRows(TArray<uint64>& Bits, const FShooterPVSHeader& Header);
+
+	/** Transposes the visibility matrix */
+	static void TransposeRows(TArray<uint64>& Bits, int32 NumCells, int32 WordsPerRow);
+};
@@ -0,0 +1,313 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterVisibilityService.h"
+#include "ShooterPotentialVisibility.h"
+#include "FPSCharacter.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarVisibilityService(
+	TEXT("fps.LOS.Cached"),
+	true,
+	TEXT("If true, AI line of sight checks are answered from the visibility service cache and refreshed with budgeted async traces.\n")
+	TEXT("If false, every check runs its own synchronous traces."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarVisibilityTTL(
+	TEXT("fps.LOS.TTL"),
+	0.25f,
+	TEXT("Time in seconds a cached line of sight result stays valid."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarVisibilityMoveThreshold(
+	TEXT("fps.LOS.MoveThreshold"),
+	50.0f,
+	TEXT("Distance in cm either side of a pair can move before its cached line of sight result expires."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarVisibilityRayBudget(
+	TEXT("fps.LOS.RayBudget"),
+	32,
+	TEXT("Max number of line of sight rays cast per frame."),
+	ECVF_Default);
+
+/** Time a pair can go without being queried before it's dropped */
+static constexpr double VisibilityPairEvictTime = 1.0;
+
+DECLARE_CYCLE_STAT(TEXT("LOS Service"), STAT_ShooterVisibilityService, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LOS Pairs"), STAT_ShooterVisibilityPairs, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOS Queries/Frame"), STAT_ShooterVisibilityQueries, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOS Cache Hits/Frame"), STAT_ShooterVisibilityCacheHits, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOS Rays/Frame"), STAT_ShooterVisibilityRays, STATGROUP_FPS);
+
+void UShooterVisibilityService::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Register(&InWorld, TG_PrePhysics, TEXT("ShooterVisibilityService"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterVisibilityService::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Pairs.Reset();
+	PairIndices.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterVisibilityService::IsEnabled() const
+{
+	return CVarVisibilityService.GetValueOnGameThread() && TickFunction.IsTickFunctionRegistered();
+}
+
+bool UShooterVisibilityService::HasLineOfSight(AActor* Observer, AActor* Target, int32 NumChecks)
+{
+	if (!Observer || !Target)
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_ShooterVisibilityQueries);
+
+	const TPair<const AActor*, const AActor*> Key(Observer, Target);
+	FShooterVisibilityPair* Pair = nullptr;
+
+	if (const int32* Index = PairIndices.Find(Key))
+	{
+		Pair = &Pairs[*Index];
+
+		// a new actor may have been allocated where a destroyed one used to be
+		if (Pair->Observer.Get() != Observer || Pair->Target.Get() != Target)
+		{
+			*Pair = FShooterVisibilityPair();
+			Pair->ObserverKey = Observer;
+			Pair->TargetKey = Target;
+		}
+	}
+	else
+	{
+		PairIndices.Add(Key, Pairs.Num());
+
+		Pair = &Pairs.AddDefaulted_GetRef();
+		Pair->ObserverKey = Observer;
+		Pair->TargetKey = Target;
+	}
+
+	Pair->Observer = Observer;
+	Pair->Target = Target;
+	Pair->NumChecks = FMath::Max(NumChecks, 1);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	Pair->QueryTime = Now;
+
+	if (Pair->bHasResult && !IsStale(*Pair, Now))
+	{
+		INC_DWORD_STAT(STAT_ShooterVisibilityCacheHits);
+	}
+
+	// expired results are still the best we have until the refresh lands
+	return Pair->bVisible;
+}
+
+FVector UShooterVisibilityService::GetEyeLocation(const AActor* Observer)
+{
+	// characters look from their camera, same as the synchronous check
+	if (const AFPSCharacter* Character = Cast<AFPSCharacter>(Observer))
+	{
+		return Character->GetFirstPersonCameraComponent()->GetComponentLocation();
+	}
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	Observer->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+	return EyeLocation;
+}
+
+bool UShooterVisibilityService::IsStale(const FShooterVisibilityPair& Pair, double Now)
+{
+	if (Pair.RefreshTime < 0.0 || Now - Pair.RefreshTime > CVarVisibilityTTL.GetValueOnGameThread())
+	{
+		return true;
+	}
+
+	const AActor* Observer = Pair.Observer.Get();
+	const AActor* Target = Pair.Target.Get();
+
+	if (!Observer || !Target)
+	{
+		return true;
+	}
+
+	const double MoveThresholdSquared = FMath::Square(CVarVisibilityMoveThreshold.GetValueOnGameThread());
+
+	return FVector::DistSquared(Observer->GetActorLocation(), Pair.ObserverLocation) > MoveThresholdSquared
+		|| FVector::DistSquared(Target->GetActorLocation(), Pair.TargetLocation) > MoveThresholdSquared;
+}
+
+void UShooterVisibilityService::CollectResults()
+{
+	UWorld* World = GetWorld();
+
+	for (FShooterVisibilityPair& Pair : Pairs)
+	{
+		if (Pair.PendingTraces.Num() == 0)
+		{
+			continue;
+		}
+
+		// we only need one unobstructed ray
+		bool bAnyClear = false;
+		bool bComplete = true;
+
+		for (const FTraceHandle& Handle : Pair.PendingTraces)
+		{
+			FTraceDatum Datum;
+
+			if (!World->QueryTraceData(Handle, Datum))
+			{
+				bComplete = false;
+				continue;
+			}
+
+			if (Datum.OutHits.Num() == 0 || !Datum.OutHits[0].bBlockingHit)
+			{
+				bAnyClear = true;
+			}
+		}
+
+		// the handles are only good for one frame, so clear them either way
+		Pair.PendingTraces.Reset();
+
+		if (!bComplete && !bAnyClear)
+		{
+			// some rays were lost, so we can't tell. Refresh the pair again first thing
+			Pair.RefreshTime = -1.0;
+			continue;
+		}
+
+		Pair.bVisible = bAnyClear;
+		Pair.bHasResult = true;
+	}
+}
+
+void UShooterVisibilityService::EvictPairs(double Now)
+{
+	for (int32 Index = Pairs.Num() - 1; Index >= 0; --Index)
+	{
+		const FShooterVisibilityPair& Pair = Pairs[Index];
+
+		if (!Pair.Observer.IsValid() || !Pair.Target.IsValid() || Now - Pair.QueryTime > VisibilityPairEvictTime)
+		{
+			RemovePair(Index);
+		}
+	}
+}
+
+void UShooterVisibilityService::IssueRefreshes(double Now)
+{
+	const int32 RayBudget = FMath::Max(CVarVisibilityRayBudget.GetValueOnGameThread(), 1);
+
+	RefreshCandidates.Reset();
+
+	for (int32 Index = 0; Index < Pairs.Num(); ++Index)
+	{
+		if (Pairs[Index].PendingTraces.Num() == 0 && IsStale(Pairs[Index], Now))
+		{
+			RefreshCandidates.Add(Index);
+		}
+	}
+
+	// stalest first. Pairs that were never refreshed sort ahead of everything else
+	RefreshCandidates.Sort([this](int32 A, int32 B) { return Pairs[A].RefreshTime < Pairs[B].RefreshTime; });
+
+	int32 RaysLeft = RayBudget;
+
+	for (int32 Index : RefreshCandidates)
+	{
+		// don't let fresher pairs with fewer rays jump the queue
+		if (FMath::Min(Pairs[Index].NumChecks, RayBudget) > RaysLeft)
+		{
+			break;
+		}
+
+		RaysLeft -= RefreshPair(Pairs[Index], Now);
+	}
+
+	INC_DWORD_STAT_BY(STAT_ShooterVisibilityRays, RayBudget - RaysLeft);
+}
+
+int32 UShooterVisibilityService::RefreshPair(FShooterVisibilityPair& Pair, double Now)
+{
+	AActor* Observer = Pair.Observer.Get();
+	AActor* Target = Pair.Target.Get();
+
+	Pair.ObserverLocation = Observer->GetActorLocation();
+	Pair.TargetLocation = Target->GetActorLocation();
+	Pair.RefreshTime = Now;
+
+	const FVector Start = GetEyeLocation(Observer);
+
+	// static geometry always separates these cells, so we already know the answer
+	const UShooterPotentialVisibility* PotentialVisibility = GetWorld()->GetSubsystem<UShooterPotentialVisibility>();
+
+	if (PotentialVisibility && !PotentialVisibility->IsPotentiallyVisible(Start, Pair.TargetLocation))
+	{
+		Pair.bVisible = false;
+		Pair.bHasResult = true;
+		return 0;
+	}
+
+	// get the target's bounding box
+	FVector CenterOfMass, Extent;
+	Target->GetActorBounds(true, CenterOfMass, Extent, false);
+
+	// spread the rays over the target's height to try and get around low obstacles
+	const int32 NumRays = FMath::Min(Pair.NumChecks, FMath::Max(CVarVisibilityRayBudget.GetValueOnGameThread(), 1));
+	const float ExtentZOffset = Extent.Z * 2.0f / NumRays;
+
+	// ignore the observer and target. We want to ensure there's an unobstructed trace not counting them
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterLineOfSight), false);
+	QueryParams.AddIgnoredActor(Observer);
+	QueryParams.AddIgnoredActor(Target);
+
+	for (int32 Ray = 0; Ray < NumRays; ++Ray)
+	{
+		const FVector End = CenterOfMass + FVector(0.0f, 0.0f, Extent.Z - ExtentZOffset * Ray);
+
+		Pair.PendingTraces.Add(GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, ECC_Visibility, QueryParams));
+	}
+
+	return NumRays;
+}
+
+void UShooterVisibilityService::RemovePair(int32 Index)
+{
+	PairIndices.Remove(TPair<const AActor*, const AActor*>(Pairs[Index].ObserverKey, Pairs[Index].TargetKey));
+
+	Pairs.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	// point the pair that filled the gap at its new index
+	if (Pairs.IsValidIndex(Index))
+	{
+		PairIndices.Add(TPair<const AActor*, const AActor*>(Pairs[Index].ObserverKey, Pairs[Index].TargetKey), Index);
+	}
+}
+
+void UShooterVisibilityService::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterVisibilityService);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// results of last frame's traces first, so they count before we pick what to refresh
+	CollectResults();
+	EvictPairs(Now);
+	IssueRefreshes(Now);
+
+	SET_DWORD_STAT(STAT_ShooterVisibilityPairs, Pairs.Num());
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterVisibilityService.generated.h"
+
+/**
+ *  Cached line of sight between an observer and a target
+ */
+struct FShooterVisibilityPair
+{
+	TWeakObjectPtr<AActor> Observer;
+	TWeakObjectPtr<AActor> Target;
+
+	/** Raw pointers the pair is keyed by. Only compared, never dereferenced */
+	const AActor* ObserverKey = nullptr;
+	const AActor* TargetKey = nullptr;
+
+	/** Observer and target locations at the last refresh, used to invalidate the result when either side moves */
+	FVector ObserverLocation = FVector::ZeroVector;
+	FVector TargetLocation = FVector::ZeroVector;
+
+	/** Time of the last refresh. Negative if the pair was never refreshed */
+	double RefreshTime = -1.0;
+
+	/** Time the pair was last queried. Pairs nobody asks about are dropped */
+	double QueryTime = 0.0;
+
+	/** Number of vertically offset rays to cast at the target on refresh */
+	int32 NumChecks = 1;
+
+	/** Async traces of the refresh in flight */
+	TArray<FTraceHandle, TInlineAllocator<8>> PendingTraces;
+
+	/** Last known result */
+	bool bVisible = false;
+
+	/** True once the pair has a result */
+	bool bHasResult = false;
+};
+
+/**
+ *  Answers line of sight queries between actors from a per pair cache, so AI can ask every frame without tracing.
+ *  Cached results expire after a short time, or as soon as either side moves far enough.
+ *  Expired pairs are refreshed with async traces under a fixed ray budget per frame, stalest first,
+ *  so the trace cost stays flat no matter how many observers are asking
+ */
+UCLASS()
+class FPS_API UShooterVisibilityService : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Cached pairs */
+	TArray<FShooterVisibilityPair> Pairs;
+
+	/** Index of each pair, keyed by observer and target. The keys are only compared, never dereferenced */
+	TMap<TPair<const AActor*, const AActor*>, int32> PairIndices;
+
+	/** Pairs picked for a refresh this frame. Kept around to avoid reallocating every frame */
+	TArray<int32> RefreshCandidates;
+
+	/** Collects the trace results and issues the refreshes */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/**
+	 *  Returns the last known line of sight from the observer to the target, and schedules a refresh if it expired.
+	 *  Pairs queried for the first time report no line of sight until their first refresh lands
+	 *  @param Observer		Actor looking. Characters look from their first person camera
+	 *  @param Target		Actor being looked at. Rays are cast at its bounds
+	 *  @param NumChecks	Number of vertically offset rays, any of which can see the target
+	 */
+	bool HasLineOfSight(AActor* Observer, AActor* Target, int32 NumChecks);
+
+	/** Returns true if line of sight queries should go through the service */
+	bool IsEnabled() const;
+
+	/** Returns the number of cached pairs */
+	int32 GetNumPairs() const { return Pairs.Num(); }
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Returns the location the observer looks from */
+	static FVector GetEyeLocation(const AActor* Observer);
+
+	/** Reads the results of the traces issued last frame */
+	void CollectResults();
+
+	/** Drops the pairs that lost an actor or weren't queried recently */
+	void EvictPairs(double Now);
+
+	/** Issues async traces for the stalest expired pairs, up to the ray budget */
+	void IssueRefreshes(double Now);
+
+	/** Issues the traces refreshing a pair. Returns the number of rays cast */
+	int32 RefreshPair(FShooterVisibilityPair& Pair, double Now);
+
+	/** Returns true if the pair's result expired or either side moved too far since its refresh */
+	static bool IsStale(const FShooterVisibilityPair& Pair, double Now);
+
+	/** Removes a pair, filling the gap with the last one */
+	void RemovePair(int32 Index);
+
+	/** Refreshes the cache */
+	void Tick(float DeltaTime);
+};
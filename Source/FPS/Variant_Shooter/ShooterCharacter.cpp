@@ -3,6 +3,7 @@
 
 #include "ShooterCharacter.h"
 #include "ShooterWeapon.h"
+#include "FPSInventoryComponent.h"
 #include "EnhancedInputComponent.h"
 #include "Components/InputComponent.h"
 #include "Components/PawnNoiseEmitterComponent.h"
@@ -10,8 +11,21 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Engine/World.h"
 #include "Camera/CameraComponent.h"
-#include "TimerManager.h"
 #include "ShooterGameMode.h"
+#include "Animation/AnimInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarLinkedAnimLayers(
+	TEXT("fps.Weapons.LinkedAnimLayers"),
+	true,
+	TEXT("If true, weapon switches link the weapon's anim layers into the character's AnimInstance.\n")
+	TEXT("If false, every switch replaces the character's AnimInstances with the weapon's AnimInstance classes."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Anim Switch"), STAT_ShooterWeaponAnimSwitch, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AnimInstance Rebuilds/Frame"), STAT_ShooterAnimInstanceRebuilds, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Layer Links/Frame"), STAT_ShooterAnimLayerLinks, STATGROUP_FPS);
 
 AShooterCharacter::AShooterCharacter()
 {
@@ -29,6 +43,10 @@ void AShooterCharacter::BeginPlay()
 	// reset HP to max
 	CurrentHP = MaxHP;
 
+	// remember the AnimInstances weapon anim layers get linked into
+	FirstPersonHostAnimClass = GetFirstPersonMesh()->GetAnimClass();
+	ThirdPersonHostAnimClass = GetMesh()->GetAnimClass();
+
 	// update the HUD
 	OnDamaged.Broadcast(1.0f);
 }
@@ -38,7 +56,10 @@ void AShooterCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
 	Super::EndPlay(EndPlayReason);
 
 	// clear the respawn timer
-	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(RespawnTimer);
+	}
 }
 
 void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -102,31 +123,12 @@ void AShooterCharacter::DoStopFiring()
 
 void AShooterCharacter::DoSwitchWeapon()
 {
-	// ensure we have at least two weapons two switch between
-	if (OwnedWeapons.Num() > 1)
-	{
-		// deactivate the old weapon
-		CurrentWeapon->DeactivateWeapon();
+	// ensure we have another weapon to switch to
+	const int32 NextSlot = GetInventory()->GetNextSlot();
 
-		// find the index of the current weapon in the owned list
-		int32 WeaponIndex = OwnedWeapons.Find(CurrentWeapon);
-
-		// is this the last weapon?
-		if (WeaponIndex == OwnedWeapons.Num() - 1)
-		{
-			// loop back to the beginning of the array
-			WeaponIndex = 0;
-		}
-		else {
-			// select the next weapon index
-			++WeaponIndex;
-		}
-
-		// set the new weapon as current
-		CurrentWeapon = OwnedWeapons[WeaponIndex];
-
-		// activate the new weapon
-		CurrentWeapon->ActivateWeapon();
+	if (NextSlot != INDEX_NONE)
+	{
+		EquipSlot(NextSlot);
 	}
 }
 
@@ -161,6 +163,12 @@ void AShooterCharacter::UpdateWeaponHUD(int32 CurrentAmmo, int32 MagazineSize)
 
 FVector AShooterCharacter::GetWeaponTargetLocation()
 {
+	// the camera doesn't move within a frame, so shots caught up by the fire scheduler can share one trace
+	if (CachedAimTargetFrame == GFrameCounter)
+	{
+		return CachedAimTarget;
+	}
+
 	// trace ahead from the camera viewpoint
 	FHitResult OutHit;
 
@@ -173,51 +181,117 @@ FVector AShooterCharacter::GetWeaponTargetLocation()
 	GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
 
 	// return either the impact point or the trace end
-	return OutHit.bBlockingHit ? OutHit.ImpactPoint : OutHit.TraceEnd;
+	CachedAimTarget = OutHit.bBlockingHit ? OutHit.ImpactPoint : OutHit.TraceEnd;
+	CachedAimTargetFrame = GFrameCounter;
+
+	return CachedAimTarget;
 }
 
-void AShooterCharacter::AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass)
+bool AShooterCharacter::AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass)
 {
-	// do we already own this weapon?
-	AShooterWeapon* OwnedWeapon = FindWeaponOfType(WeaponClass);
+	UFPSInventoryComponent* WeaponInventory = GetInventory();
 
-	if (!OwnedWeapon)
+	// do we already own this weapon, or have no room for it?
+	if (FindWeaponOfType(WeaponClass) || WeaponInventory->IsFull())
 	{
-		// spawn the new weapon
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.Owner = this;
-		SpawnParams.Instigator = this;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::MultiplyWithRoot;
+		return false;
+	}
 
-		AShooterWeapon* AddedWeapon = GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+	// spawn the new weapon
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.Instigator = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::MultiplyWithRoot;
 
-		if (AddedWeapon)
-		{
-			// add the weapon to the owned list
-			OwnedWeapons.Add(AddedWeapon);
-
-			// if we have an existing weapon, deactivate it
-			if (CurrentWeapon)
-			{
-				CurrentWeapon->DeactivateWeapon();
-			}
-
-			// switch to the new weapon
-			CurrentWeapon = AddedWeapon;
-			CurrentWeapon->ActivateWeapon();
-		}
+	AShooterWeapon* AddedWeapon = GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+
+	if (!AddedWeapon)
+	{
+		return false;
+	}
+
+	// add the weapon to the inventory
+	const int32 SlotIndex = WeaponInventory->AddItem(AddedWeapon);
+
+	if (SlotIndex == INDEX_NONE)
+	{
+		AddedWeapon->Destroy();
+		return false;
 	}
+
+	// resolve the anim classes and HUD data once, so switching to the slot doesn't query the weapon
+	FFPSInventorySlot* Slot = WeaponInventory->GetSlot(SlotIndex);
+	Slot->FirstPersonAnimClass = AddedWeapon->GetFirstPersonAnimInstanceClass();
+	Slot->ThirdPersonAnimClass = AddedWeapon->GetThirdPersonAnimInstanceClass();
+	Slot->FirstPersonAnimLayers = AddedWeapon->GetFirstPersonAnimLayersClass();
+	Slot->ThirdPersonAnimLayers = AddedWeapon->GetThirdPersonAnimLayersClass();
+	Slot->MagazineSize = AddedWeapon->GetMagazineSize();
+
+	// switch to the new weapon
+	EquipSlot(SlotIndex);
+
+	return true;
 }
 
 void AShooterCharacter::OnWeaponActivated(AShooterWeapon* Weapon)
 {
+	const UFPSInventoryComponent* WeaponInventory = GetInventory();
+	const FFPSInventorySlot* Slot = WeaponInventory->GetSlot(WeaponInventory->FindSlotByClass(Weapon->GetClass()));
+
+	if (!Slot)
+	{
+		return;
+	}
+
 	// update the bullet counter
-	OnBulletCountUpdated.Broadcast(Weapon->GetMagazineSize(), Weapon->GetBulletCount());
+	OnBulletCountUpdated.Broadcast(Slot->MagazineSize, Weapon->GetBulletCount());
+
+	// switch the character mesh animations
+	SCOPE_CYCLE_COUNTER(STAT_ShooterWeaponAnimSwitch);
 
-	// set the character mesh AnimInstances
-	GetFirstPersonMesh()->SetAnimInstanceClass(Weapon->GetFirstPersonAnimInstanceClass());
-	GetMesh()->SetAnimInstanceClass(Weapon->GetThirdPersonAnimInstanceClass());
+	// weapons without anim layers, which is every weapon until layer assets are authored, fall back to swapping the AnimInstance
+	SwitchMeshAnimation(GetFirstPersonMesh(), FirstPersonHostAnimClass, Slot->FirstPersonAnimClass, Slot->FirstPersonAnimLayers, FirstPersonLinkedLayers);
+	SwitchMeshAnimation(GetMesh(), ThirdPersonHostAnimClass, Slot->ThirdPersonAnimClass, Slot->ThirdPersonAnimLayers, ThirdPersonLinkedLayers);
+}
+
+void AShooterCharacter::SwitchMeshAnimation(USkeletalMeshComponent* Mesh, TSubclassOf<UAnimInstance> HostClass, TSubclassOf<UAnimInstance> AnimClass, TSubclassOf<UAnimInstance> LayersClass, TSubclassOf<UAnimInstance>& LinkedLayers)
+{
+	const bool bUseLayers = LayersClass && HostClass && CVarLinkedAnimLayers.GetValueOnGameThread();
+
+	// the AnimInstance the mesh should be running after the switch
+	const TSubclassOf<UAnimInstance> TargetClass = bUseLayers ? HostClass : AnimClass;
+
+	const UAnimInstance* AnimInstance = Mesh->GetAnimInstance();
+
+	if (TargetClass && (!AnimInstance || AnimInstance->GetClass() != TargetClass))
+	{
+		// replacing the AnimInstance tears down the old one along with its linked layers
+		INC_DWORD_STAT(STAT_ShooterAnimInstanceRebuilds);
+
+		Mesh->SetAnimInstanceClass(TargetClass);
+		LinkedLayers = nullptr;
+	}
+
+	if (!bUseLayers)
+	{
+		if (LinkedLayers)
+		{
+			Mesh->UnlinkAnimClassLayers(LinkedLayers);
+			LinkedLayers = nullptr;
+		}
+
+		return;
+	}
+
+	if (LinkedLayers != LayersClass)
+	{
+		// the host blends between layers through its layer nodes, so the switch doesn't restart the pose
+		INC_DWORD_STAT(STAT_ShooterAnimLayerLinks);
+
+		Mesh->LinkAnimClassLayers(LayersClass);
+		LinkedLayers = LayersClass;
+	}
 }
 
 void AShooterCharacter::OnWeaponDeactivated(AShooterWeapon* Weapon)
@@ -232,18 +306,29 @@ void AShooterCharacter::OnSemiWeaponRefire()
 
 AShooterWeapon* AShooterCharacter::FindWeaponOfType(TSubclassOf<AShooterWeapon> WeaponClass) const
 {
-	// check each owned weapon
-	for (AShooterWeapon* Weapon : OwnedWeapons)
+	// weapons are granted by exact class, so the inventory's class index is enough
+	return Cast<AShooterWeapon>(GetInventory()->FindItemByClass(WeaponClass));
+}
+
+void AShooterCharacter::EquipSlot(int32 SlotIndex)
+{
+	AShooterWeapon* NewWeapon = Cast<AShooterWeapon>(GetInventory()->GetItem(SlotIndex));
+
+	if (!NewWeapon || NewWeapon == CurrentWeapon)
 	{
-		if (Weapon->IsA(WeaponClass))
-		{
-			return Weapon;
-		}
+		return;
 	}
 
-	// weapon not found
-	return nullptr;
+	// deactivate the old weapon
+	if (CurrentWeapon)
+	{
+		CurrentWeapon->DeactivateWeapon();
+	}
 
+	// set the new weapon as current and activate it
+	GetInventory()->SetCurrentSlot(SlotIndex);
+	CurrentWeapon = NewWeapon;
+	CurrentWeapon->ActivateWeapon();
 }
 
 void AShooterCharacter::Die()
@@ -273,7 +358,10 @@ void AShooterCharacter::Die()
 	BP_OnDeath();
 
 	// schedule character respawn
-	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, this, &AShooterCharacter::OnRespawn, RespawnTime, false);
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		RespawnTimer = TimerSubsystem->SetTimer(this, &AShooterCharacter::OnRespawn, RespawnTime);
+	}
 }
 
 void AShooterCharacter::OnRespawn()
@@ -5,12 +5,15 @@
 #include "CoreMinimal.h"
 #include "FPSCharacter.h"
 #include "ShooterWeaponHolder.h"
+#include "FPSTimerSubsystem.h"
 #include "ShooterCharacter.generated.h"
 
 class AShooterWeapon;
 class UInputAction;
 class UInputComponent;
 class UPawnNoiseEmitterComponent;
+class USkeletalMeshComponent;
+class UAnimInstance;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FBulletCountUpdatedDelegate, int32, MagazineSize, int32, Bullets);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDamagedDelegate, float, LifePercent);
@@ -51,6 +54,12 @@ protected:
 	UPROPERTY(EditAnywhere, Category ="Aim", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
 	float MaxAimDistance = 10000.0f;
 
+	/** Aim trace result, reused by every shot fired during the same frame */
+	FVector CachedAimTarget = FVector::ZeroVector;
+
+	/** Frame the aim trace was cached on */
+	uint64 CachedAimTargetFrame = 0;
+
 	/** Max HP this character can have */
 	UPROPERTY(EditAnywhere, Category="Health")
 	float MaxHP = 500.0f;
@@ -62,16 +71,27 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Team")
 	uint8 TeamByte = 0;
 
-	/** List of weapons picked up by the character */
-	TArray<AShooterWeapon*> OwnedWeapons;
-
-	/** Weapon currently equipped and ready to shoot with */
+	/** Weapon currently equipped and ready to shoot with. Mirrors the inventory's current slot */
 	TObjectPtr<AShooterWeapon> CurrentWeapon;
 
+	/** AnimInstance classes the character meshes start with. Weapon anim layers are linked into these */
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> FirstPersonHostAnimClass;
+
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> ThirdPersonHostAnimClass;
+
+	/** Anim layers currently linked into the character meshes */
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> FirstPersonLinkedLayers;
+
+	UPROPERTY()
+	TSubclassOf<UAnimInstance> ThirdPersonLinkedLayers;
+
 	UPROPERTY(EditAnywhere, Category ="Destruction", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
 	float RespawnTime = 5.0f;
 
-	FTimerHandle RespawnTimer;
+	FFPSTimerHandle RespawnTimer;
 
 public:
 
@@ -136,7 +156,7 @@ public:
 	virtual FVector GetWeaponTargetLocation() override;
 
 	/** Gives a weapon of this class to the owner */
-	virtual void AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
+	virtual bool AddWeaponClass(const TSubclassOf<AShooterWeapon>& WeaponClass) override;
 
 	/** Activates the passed weapon */
 	virtual void OnWeaponActivated(AShooterWeapon* Weapon) override;
@@ -151,9 +171,23 @@ public:
 
 protected:
 
-	/** Returns true if the character already owns a weapon of the given class */
+	/** Returns the owned weapon of the given class, or nullptr */
 	AShooterWeapon* FindWeaponOfType(TSubclassOf<AShooterWeapon> WeaponClass) const;
 
+	/** Deactivates the current weapon and activates the one in the given inventory slot */
+	void EquipSlot(int32 SlotIndex);
+
+	/**
+	 *  Switches a character mesh to a weapon's animation
+	 *  Links the weapon's anim layers into the host AnimInstance if it has any, otherwise replaces the AnimInstance
+	 *  @param Mesh			Character mesh to switch
+	 *  @param HostClass		AnimInstance class the layers are linked into
+	 *  @param AnimClass		AnimInstance class to fall back to if the weapon has no layers
+	 *  @param LayersClass		Anim layers of the weapon
+	 *  @param LinkedLayers		Anim layers currently linked into the mesh, updated to the new layers
+	 */
+	static void SwitchMeshAnimation(USkeletalMeshComponent* Mesh, TSubclassOf<UAnimInstance> HostClass, TSubclassOf<UAnimInstance> AnimClass, TSubclassOf<UAnimInstance> LayersClass, TSubclassOf<UAnimInstance>& LinkedLayers);
+
 	/** Called when this character's HP is depleted */
 	void Die();
 
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterDamageQueue.h"
+#include "ShooterProjectileManager.h"
+#include "ShooterExplosionResolver.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/DamageType.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarDamageQueue(
+	TEXT("fps.Damage.Coalesce"),
+	true,
+	TEXT("If true, damage dealt during the frame is summed per victim and applied once at the end of the frame.\n")
+	TEXT("If false, every hit applies its damage right away."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Damage Queue Resolve"), STAT_ShooterDamageQueueResolve, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events Received/Frame"), STAT_ShooterDamageEventsReceived, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events Dispatched/Frame"), STAT_ShooterDamageEventsDispatched, STATGROUP_FPS);
+
+void UShooterDamageQueue::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// apply the damage once everything that can deal it this frame has run
+	TickFunction.Register(&InWorld, TG_PostUpdateWork, TEXT("ShooterDamageQueue"), [this](float DeltaTime) { Tick(DeltaTime); });
+
+	if (UShooterProjectileManager* ProjectileManager = InWorld.GetSubsystem<UShooterProjectileManager>())
+	{
+		TickFunction.AddPrerequisite(ProjectileManager, ProjectileManager->GetTickFunction());
+	}
+
+	if (UShooterExplosionResolver* ExplosionResolver = InWorld.GetSubsystem<UShooterExplosionResolver>())
+	{
+		TickFunction.AddPrerequisite(ExplosionResolver, ExplosionResolver->GetTickFunction());
+	}
+}
+
+void UShooterDamageQueue::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Pending.Reset();
+	PendingIndices.Reset();
+
+	Super::Deinitialize();
+}
+
+void UShooterDamageQueue::ApplyDamage(AActor* Victim, float Damage, AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType)
+{
+	if (!Victim || Damage == 0.0f)
+	{
+		return;
+	}
+
+	UShooterDamageQueue* DamageQueue = Victim->GetWorld()->GetSubsystem<UShooterDamageQueue>();
+
+	if (DamageQueue && DamageQueue->TickFunction.IsTickFunctionRegistered() && CVarDamageQueue.GetValueOnGameThread())
+	{
+		DamageQueue->QueueDamage(Victim, Damage, EventInstigator, DamageCauser, DamageType);
+		return;
+	}
+
+	// apply right away
+	UGameplayStatics::ApplyDamage(Victim, Damage, EventInstigator, DamageCauser, DamageType);
+}
+
+void UShooterDamageQueue::QueueDamage(AActor* Victim, float Damage, AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType)
+{
+	++EventsReceived;
+	INC_DWORD_STAT(STAT_ShooterDamageEventsReceived);
+
+	FShooterPendingDamage* Entry;
+
+	if (const int32* Found = PendingIndices.Find(Victim))
+	{
+		Entry = &Pending[*Found];
+
+	} else {
+
+		PendingIndices.Add(Victim, Pending.Num());
+
+		Entry = &Pending.AddDefaulted_GetRef();
+		Entry->Victim = Victim;
+	}
+
+	Entry->Damage += Damage;
+
+	// credit the whole amount to whoever dealt the largest hit
+	if (Damage >= Entry->LargestHit)
+	{
+		Entry->LargestHit = Damage;
+		Entry->EventInstigator = EventInstigator;
+		Entry->DamageCauser = DamageCauser;
+		Entry->DamageType = DamageType;
+	}
+}
+
+void UShooterDamageQueue::Tick(float DeltaTime)
+{
+	if (Pending.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterDamageQueueResolve);
+
+	Swap(Pending, Resolving);
+	PendingIndices.Reset();
+
+	for (const FShooterPendingDamage& Entry : Resolving)
+	{
+		AActor* Victim = Entry.Victim.Get();
+
+		if (!IsValid(Victim) || Entry.Damage == 0.0f)
+		{
+			continue;
+		}
+
+		// one TakeDamage call per victim, so one death check and one HUD update
+		UGameplayStatics::ApplyDamage(Victim, Entry.Damage, Entry.EventInstigator.Get(), Entry.DamageCauser.Get(), Entry.DamageType);
+
+		++EventsDispatched;
+		INC_DWORD_STAT(STAT_ShooterDamageEventsDispatched);
+	}
+
+	Resolving.Reset();
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterDamageQueue.generated.h"
+
+class UDamageType;
+class AController;
+
+/**
+ *  Damage dealt to a single victim during the frame
+ */
+struct FShooterPendingDamage
+{
+	TWeakObjectPtr<AActor> Victim;
+
+	/** Sum of the damage events */
+	float Damage = 0.0f;
+
+	/** Instigator, causer and damage type of the largest hit, credited with the whole amount */
+	TWeakObjectPtr<AController> EventInstigator;
+	TWeakObjectPtr<AActor> DamageCauser;
+	TSubclassOf<UDamageType> DamageType;
+	float LargestHit = 0.0f;
+};
+
+/**
+ *  Collects the damage dealt by shooter weapons during the frame and applies it once per victim,
+ *  so a burst of hits runs a single TakeDamage, death check and HUD update per victim instead of one per hit
+ */
+UCLASS()
+class FPS_API UShooterDamageQueue : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Damage collected this frame, one entry per victim */
+	TArray<FShooterPendingDamage> Pending;
+
+	/** Damage being applied. Damage dealt while applying waits for the next frame */
+	TArray<FShooterPendingDamage> Resolving;
+
+	/** Index of each victim in the pending damage. Keys are only compared, never dereferenced */
+	TMap<AActor*, int32> PendingIndices;
+
+	/** Applies the damage at the end of the frame */
+	FFPSSubsystemTickFunction TickFunction;
+
+	/** Damage events received and TakeDamage calls dispatched since play started */
+	uint64 EventsReceived = 0;
+	uint64 EventsDispatched = 0;
+
+public:
+
+	/**
+	 *  Queues damage for the end of the frame, or applies it right away if the queue is disabled
+	 *  Takes the same parameters as UGameplayStatics::ApplyDamage
+	 */
+	static void ApplyDamage(AActor* Victim, float Damage, AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType);
+
+	/** Returns the number of damage events received since play started */
+	uint64 GetEventsReceived() const { return EventsReceived; }
+
+	/** Returns the number of TakeDamage calls dispatched since play started */
+	uint64 GetEventsDispatched() const { return EventsDispatched; }
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Adds a damage event to its victim's pending damage */
+	void QueueDamage(AActor* Victim, float Damage, AController* EventInstigator, AActor* DamageCauser, TSubclassOf<UDamageType> DamageType);
+
+	/** Applies the pending damage of every victim */
+	void Tick(float DeltaTime);
+};
@@ -29,5 +29,5 @@ void AShooterGameMode::IncrementTeamScore(uint8 TeamByte)
 	TeamScores.Add(TeamByte, Score);
 
 	// update the UI
-	ShooterUI->BP_UpdateScore(TeamByte, Score);
+	ShooterUI->SetTeamScore(TeamByte, Score);
 }
@@ -102,7 +102,7 @@ void AShooterPlayerController::OnPossess(APawn* InPawn)
 void AShooterPlayerController::OnPawnDestroyed(AActor* DestroyedActor)
 {
 	// reset the bullet counter HUD
-	BulletCounterUI->BP_UpdateBulletCounter(0, 0);
+	BulletCounterUI->SetBulletCount(0, 0);
 
 	// find the player start
 	TArray<AActor*> ActorList;
@@ -129,7 +129,7 @@ void AShooterPlayerController::OnBulletCountUpdated(int32 MagazineSize, int32 Bu
 	// update the UI
 	if (BulletCounterUI)
 	{
-		BulletCounterUI->BP_UpdateBulletCounter(MagazineSize, Bullets);
+		BulletCounterUI->SetBulletCount(MagazineSize, Bullets);
 	}
 }
 
@@ -137,6 +137,6 @@ void AShooterPlayerController::OnPawnDamaged(float LifePercent)
 {
 	if (IsValid(BulletCounterUI))
 	{
-		BulletCounterUI->BP_Damaged(LifePercent);
+		BulletCounterUI->SetLifePercent(LifePercent);
 	}
 }
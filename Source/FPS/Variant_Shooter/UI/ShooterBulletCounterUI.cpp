@@ -2,4 +2,61 @@
 
 
 #include "ShooterBulletCounterUI.h"
+#include "Components/TextBlock.h"
+#include "Components/ProgressBar.h"
 
+void UShooterBulletCounterUI::SetBulletCount(int32 MagazineSize, int32 BulletCount)
+{
+	if (MagazineSize == DisplayedMagazineSize && BulletCount == DisplayedBulletCount)
+	{
+		return;
+	}
+
+	DisplayedMagazineSize = MagazineSize;
+	DisplayedBulletCount = BulletCount;
+
+	bBulletCountDirty = true;
+	MarkHUDDirty();
+}
+
+void UShooterBulletCounterUI::SetLifePercent(float LifePercent)
+{
+	if (LifePercent == DisplayedLifePercent)
+	{
+		return;
+	}
+
+	DisplayedLifePercent = LifePercent;
+
+	bLifeDirty = true;
+	MarkHUDDirty();
+}
+
+void UShooterBulletCounterUI::RepaintHUD()
+{
+	if (bBulletCountDirty)
+	{
+		bBulletCountDirty = false;
+
+		if (BulletCountText)
+		{
+			BulletCountText->SetText(FText::Format(INVTEXT("{0} / {1}"), FText::AsNumber(DisplayedBulletCount), FText::AsNumber(DisplayedMagazineSize)));
+		}
+
+		// call the BP handler
+		BP_UpdateBulletCounter(DisplayedMagazineSize, DisplayedBulletCount);
+	}
+
+	if (bLifeDirty)
+	{
+		bLifeDirty = false;
+
+		if (LifeBar)
+		{
+			LifeBar->SetPercent(DisplayedLifePercent);
+		}
+
+		// call the BP handler
+		BP_Damaged(DisplayedLifePercent);
+	}
+}
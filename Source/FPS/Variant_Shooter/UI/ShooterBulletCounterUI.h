@@ -3,19 +3,58 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Blueprint/UserWidget.h"
+#include "FPSHUDWidget.h"
 #include "ShooterBulletCounterUI.generated.h"
 
+class UTextBlock;
+class UProgressBar;
+
 /**
  *  Simple bullet counter UI widget for a first person shooter game
+ *  Bullet count and life are kept in a native model and repainted at most once per frame, only when they change
  */
 UCLASS(abstract)
-class FPS_API UShooterBulletCounterUI : public UUserWidget
+class FPS_API UShooterBulletCounterUI : public UFPSHUDWidget
 {
 	GENERATED_BODY()
-	
+
+protected:
+
+	/** Optional text showing the bullet count, updated natively */
+	UPROPERTY(meta = (BindWidgetOptional))
+	TObjectPtr<UTextBlock> BulletCountText;
+
+	/** Optional bar showing the life percent, updated natively */
+	UPROPERTY(meta = (BindWidgetOptional))
+	TObjectPtr<UProgressBar> LifeBar;
+
+	/** Displayed magazine size and bullet count. Negative until first set */
+	int32 DisplayedMagazineSize = -1;
+	int32 DisplayedBulletCount = -1;
+
+	/** Displayed life percent. Negative until first set */
+	float DisplayedLifePercent = -1.0f;
+
+	/** Set when the bullet count changed since the last repaint */
+	bool bBulletCountDirty = false;
+
+	/** Set when the life percent changed since the last repaint */
+	bool bLifeDirty = false;
+
 public:
 
+	/** Updates the bullet count model. Repaints on the next frame if the values changed */
+	void SetBulletCount(int32 MagazineSize, int32 BulletCount);
+
+	/** Updates the life model. Repaints on the next frame if the value changed */
+	void SetLifePercent(float LifePercent);
+
+protected:
+
+	//~Begin UFPSHUDWidget interface
+	virtual void RepaintHUD() override;
+	//~End UFPSHUDWidget interface
+
 	/** Allows Blueprint to update sub-widgets with the new bullet count */
 	UFUNCTION(BlueprintImplementableEvent, Category="Shooter", meta=(DisplayName = "UpdateBulletCounter"))
 	void BP_UpdateBulletCounter(int32 MagazineSize, int32 BulletCount);
@@ -3,3 +3,28 @@
 
 #include "ShooterUI.h"
 
+void UShooterUI::SetTeamScore(uint8 TeamByte, int32 Score)
+{
+	int32& DisplayedScore = TeamScores.FindOrAdd(TeamByte, INDEX_NONE);
+
+	if (DisplayedScore == Score)
+	{
+		return;
+	}
+
+	DisplayedScore = Score;
+
+	DirtyTeams.AddUnique(TeamByte);
+	MarkHUDDirty();
+}
+
+void UShooterUI::RepaintHUD()
+{
+	for (const uint8 TeamByte : DirtyTeams)
+	{
+		// call the BP handler
+		BP_UpdateScore(TeamByte, TeamScores.FindChecked(TeamByte));
+	}
+
+	DirtyTeams.Reset();
+}
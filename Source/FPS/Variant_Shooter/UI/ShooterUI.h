@@ -3,19 +3,37 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Blueprint/UserWidget.h"
+#include "FPSHUDWidget.h"
 #include "ShooterUI.generated.h"
 
 /**
  *  Simple scoreboard UI for a first person shooter game
+ *  Team scores are kept in a native model and repainted at most once per frame, only for the teams that scored
  */
 UCLASS(abstract)
-class FPS_API UShooterUI : public UUserWidget
+class FPS_API UShooterUI : public UFPSHUDWidget
 {
 	GENERATED_BODY()
-	
+
+protected:
+
+	/** Displayed score of each team */
+	TMap<uint8, int32> TeamScores;
+
+	/** Teams whose score changed since the last repaint */
+	TArray<uint8> DirtyTeams;
+
 public:
 
+	/** Updates a team's score in the model. Repaints on the next frame if the score changed */
+	void SetTeamScore(uint8 TeamByte, int32 Score);
+
+protected:
+
+	//~Begin UFPSHUDWidget interface
+	virtual void RepaintHUD() override;
+	//~End UFPSHUDWidget interface
+
 	/** Allows Blueprint to update score sub-widgets */
 	UFUNCTION(BlueprintImplementableEvent, Category="Shooter", meta = (DisplayName = "Update Score"))
 	void BP_UpdateScore(uint8 TeamByte, int32 Score);
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterAimProvider.h"
+#include "ShooterWeapon.h"
+#include "Engine/World.h"
+#include "FPS.h"
+
+DECLARE_CYCLE_STAT(TEXT("Aim Provider Update"), STAT_ShooterAimProviderUpdate, STATGROUP_FPS);
+
+void UShooterAimProvider::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// animation has finished by the end of the frame, so the sockets are final
+	TickFunction.Register(&InWorld, TG_PostUpdateWork, TEXT("ShooterAimProvider"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterAimProvider::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Weapons.Reset();
+
+	Super::Deinitialize();
+}
+
+void UShooterAimProvider::RegisterWeapon(AShooterWeapon* Weapon)
+{
+	if (Weapon)
+	{
+		Weapons.AddUnique(Weapon);
+
+		// cache right away so the first shot doesn't have to wait a frame
+		Weapon->UpdateMuzzleCache();
+	}
+}
+
+void UShooterAimProvider::UnregisterWeapon(AShooterWeapon* Weapon)
+{
+	Weapons.RemoveSwap(Weapon, EAllowShrinking::No);
+}
+
+void UShooterAimProvider::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterAimProviderUpdate);
+
+	for (int32 Index = Weapons.Num() - 1; Index >= 0; --Index)
+	{
+		AShooterWeapon* Weapon = Weapons[Index].Get();
+
+		if (!IsValid(Weapon))
+		{
+			Weapons.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+
+		Weapon->UpdateMuzzleCache();
+	}
+}
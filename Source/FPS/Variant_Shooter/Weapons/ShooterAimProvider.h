@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterAimProvider.generated.h"
+
+class AShooterWeapon;
+
+/**
+ *  Caches the muzzle socket of every active player weapon once per frame, after animation has run.
+ *  Shots then place their muzzle from the cached socket and the current mesh transform,
+ *  instead of querying the skeletal pose on every shot.
+ *  Weapons held by AI don't register, since they use an analytic muzzle offset on the third person mesh
+ */
+UCLASS()
+class FPS_API UShooterAimProvider : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Weapons whose muzzle socket is cached every frame */
+	TArray<TWeakObjectPtr<AShooterWeapon>> Weapons;
+
+	/** Refreshes the cached muzzles at the end of the frame */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/** Starts caching a weapon's muzzle socket every frame */
+	void RegisterWeapon(AShooterWeapon* Weapon);
+
+	/** Stops caching a weapon's muzzle socket */
+	void UnregisterWeapon(AShooterWeapon* Weapon);
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Refreshes the cached muzzle of every registered weapon */
+	void Tick(float DeltaTime);
+};
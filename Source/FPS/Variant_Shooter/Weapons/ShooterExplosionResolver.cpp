@@ -0,0 +1,318 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterExplosionResolver.h"
+#include "ShooterProjectileManager.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/MemStack.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarExplosionResolver(
+	TEXT("fps.Explosions.Batched"),
+	true,
+	TEXT("If true, projectile explosions are queued and resolved once per frame against a spatial hash.\n")
+	TEXT("If false, every explosion runs its own overlap query."),
+	ECVF_Default);
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorld CmdExplosionCheckRagdolls(
+	TEXT("fps.Explosions.CheckRagdolls"),
+	TEXT("Checks that every ragdoll in the world would receive the impulse of a batched explosion centered on it, and logs the ones that wouldn't."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UShooterExplosionResolver* Resolver = World ? World->GetSubsystem<UShooterExplosionResolver>() : nullptr)
+		{
+			Resolver->CheckRagdolls();
+		}
+	}));
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("Explosion Resolve"), STAT_ShooterExplosionResolve, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Explosion Damageables"), STAT_ShooterExplosionDamageables, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosions/Frame"), STAT_ShooterExplosions, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosion Candidates/Frame"), STAT_ShooterExplosionCandidates, STATGROUP_FPS);
+
+void UShooterExplosionResolver::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// pick up the actors already in the level, then everything spawned later
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		RegisterActor(*It);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UShooterExplosionResolver::RegisterActor));
+
+	TickFunction.Register(&InWorld, TG_PostPhysics, TEXT("ShooterExplosionResolver"), [this](float DeltaTime) { Tick(DeltaTime); });
+
+	// run after the projectile manager so explosions from this frame's impacts are resolved right away
+	if (UShooterProjectileManager* ProjectileManager = InWorld.GetSubsystem<UShooterProjectileManager>())
+	{
+		TickFunction.AddPrerequisite(ProjectileManager, ProjectileManager->GetTickFunction());
+	}
+}
+
+void UShooterExplosionResolver::Deinitialize()
+{
+	if (ActorSpawnedHandle.IsValid())
+	{
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+		ActorSpawnedHandle.Reset();
+	}
+
+	TickFunction.Unregister();
+
+	Damageables.Reset();
+	TrackedComponents.Reset();
+	TrackedKeys.Reset();
+	Explosions.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterExplosionResolver::QueueExplosion(const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, const FVector& Center)
+{
+	if (!CVarExplosionResolver.GetValueOnGameThread() || !TickFunction.IsTickFunctionRegistered())
+	{
+		return false;
+	}
+
+	FShooterQueuedExplosion& Explosion = Explosions.AddDefaulted_GetRef();
+	Explosion.Profile = Profile;
+	Explosion.Center = Center;
+	Explosion.Owner = Source.Owner;
+	Explosion.Instigator = Source.Instigator;
+	Explosion.DamageCauser = Source.DamageCauser;
+
+	return true;
+}
+
+void UShooterExplosionResolver::RegisterActor(AActor* Actor)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	// characters take damage through their capsule, and are pushed through their mesh once it ragdolls
+	if (ACharacter* Character = Cast<ACharacter>(Actor))
+	{
+		RegisterComponent(Cast<UPrimitiveComponent>(Character->GetRootComponent()));
+		RegisterComponent(Character->GetMesh());
+		return;
+	}
+
+	// everything else can only be pushed, so only physics bodies matter
+	Actor->ForEachComponent<UPrimitiveComponent>(false, [this](UPrimitiveComponent* Component)
+	{
+		if (Component->BodyInstance.bSimulatePhysics)
+		{
+			RegisterComponent(Component);
+		}
+	});
+}
+
+void UShooterExplosionResolver::RegisterComponent(UPrimitiveComponent* Component)
+{
+	if (!Component)
+	{
+		return;
+	}
+
+	if (Damageables.Contains(Component))
+	{
+		const int32 Index = TrackedKeys.IndexOfByKey(Component);
+
+		if (TrackedComponents[Index].Get() == Component)
+		{
+			return;
+		}
+
+		// a destroyed component we haven't refreshed away yet, and this one reused its address. Take over its entry
+		TrackedComponents[Index] = Component;
+		Damageables.Update(Component, Component->Bounds.Origin);
+
+	} else {
+
+		Damageables.Add(Component, Component->Bounds.Origin);
+		TrackedComponents.Add(Component);
+		TrackedKeys.Add(Component);
+	}
+
+	MaxBoundsRadius = FMath::Max(MaxBoundsRadius, float(Component->Bounds.SphereRadius));
+
+	SET_DWORD_STAT(STAT_ShooterExplosionDamageables, TrackedKeys.Num());
+}
+
+void UShooterExplosionResolver::RefreshDamageables()
+{
+	// bounds shrink when the largest components go away, and change as the rest rotate
+	MaxBoundsRadius = 0.0f;
+
+	for (int32 Index = TrackedComponents.Num() - 1; Index >= 0; --Index)
+	{
+		UPrimitiveComponent* Component = TrackedComponents[Index].Get();
+
+		if (!Component || !IsValid(Component->GetOwner()))
+		{
+			// the key is only compared, never dereferenced
+			Damageables.Remove(TrackedKeys[Index]);
+
+			TrackedComponents.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			TrackedKeys.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+
+		// use the bounds rather than the component location, since simulated bodies drift away from their component
+		Damageables.Update(Component, Component->Bounds.Origin);
+
+		MaxBoundsRadius = FMath::Max(MaxBoundsRadius, float(Component->Bounds.SphereRadius));
+	}
+
+	SET_DWORD_STAT(STAT_ShooterExplosionDamageables, TrackedKeys.Num());
+}
+
+void UShooterExplosionResolver::Tick(float DeltaTime)
+{
+	if (Explosions.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterExplosionResolve);
+
+	Swap(Explosions, ResolvingExplosions);
+
+	INC_DWORD_STAT_BY(STAT_ShooterExplosions, ResolvingExplosions.Num());
+
+	// bring the hash up to date once for the whole batch
+	RefreshDamageables();
+
+	// candidate lists only live for the duration of the pass, so keep them on the frame stack
+	FMemMark Mark(FMemStack::Get());
+
+	TArray<TPair<AActor*, UPrimitiveComponent*>, TMemStackAllocator<>> Victims;
+	TSet<AActor*, DefaultKeyFuncs<AActor*>, TMemStackSetAllocator<>> DamagedActors;
+
+	for (const FShooterQueuedExplosion& Explosion : ResolvingExplosions)
+	{
+		FShooterProjectileSource Source;
+		Source.Owner = Explosion.Owner.Get();
+		Source.Instigator = Explosion.Instigator.Get();
+		Source.DamageCauser = Explosion.DamageCauser.Get();
+
+		const AActor* IgnoredInstigator = Explosion.Profile.bDamageOwner ? nullptr : Source.Instigator;
+		const float Radius = Explosion.Profile.ExplosionRadius;
+
+		Victims.Reset();
+		DamagedActors.Reset();
+
+		ForEachAffectedComponent(Explosion.Center, Radius, Source.DamageCauser, IgnoredInstigator, [&](AActor* Actor, UPrimitiveComponent* Component)
+		{
+			// only damage each actor once, even if several of its components are in range
+			bool bAlreadyDamaged = false;
+			DamagedActors.Add(Actor, &bAlreadyDamaged);
+
+			if (!bAlreadyDamaged)
+			{
+				Victims.Emplace(Actor, Component);
+			}
+		});
+
+		// apply the damage after the lookup, since damage may destroy actors or move them in the hash
+		for (const TPair<AActor*, UPrimitiveComponent*>& Victim : Victims)
+		{
+			if (!IsValid(Victim.Key))
+			{
+				continue;
+			}
+
+			const FVector ExplosionDir = Victim.Key->GetActorLocation() - Explosion.Center;
+
+			AShooterProjectile::ApplyHit(Explosion.Profile, Source, Victim.Key, Victim.Value, Explosion.Center, ExplosionDir.GetSafeNormal(), AShooterProjectile::GetExplosionDamageScale(Explosion.Profile, ExplosionDir.Size()));
+		}
+	}
+
+	ResolvingExplosions.Reset();
+}
+
+void UShooterExplosionResolver::ForEachAffectedComponent(const FVector& Center, float Radius, const AActor* IgnoredCauser, const AActor* IgnoredInstigator, TFunctionRef<void(AActor*, UPrimitiveComponent*)> Func) const
+{
+	// widen the lookup by the largest bounds, then test each component's bounds sphere against the explosion
+	Damageables.ForEachInRadius(Center, Radius + MaxBoundsRadius, [&](UPrimitiveComponent* Component, const FVector& Location)
+	{
+		INC_DWORD_STAT(STAT_ShooterExplosionCandidates);
+
+		if (FVector::Dist(Location, Center) - Component->Bounds.SphereRadius > Radius)
+		{
+			return;
+		}
+
+		// match the overlap query, which skips components that don't collide. This drops a dead character's capsule in favor of its ragdoll
+		if (!Component->IsQueryCollisionEnabled())
+		{
+			return;
+		}
+
+		AActor* Actor = Component->GetOwner();
+
+		if (Actor == IgnoredCauser || Actor == IgnoredInstigator)
+		{
+			return;
+		}
+
+		Func(Actor, Component);
+	});
+}
+
+#if !UE_BUILD_SHIPPING
+void UShooterExplosionResolver::CheckRagdolls()
+{
+	RefreshDamageables();
+
+	// default explosion, centered on each ragdoll
+	const FShooterProjectileProfile Profile;
+
+	int32 NumRagdolls = 0;
+	int32 NumPushed = 0;
+
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		USkeletalMeshComponent* Mesh = It->GetMesh();
+
+		if (!Mesh || !Mesh->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		++NumRagdolls;
+
+		// the ragdoll gets the impulse if it's the component picked for its actor
+		UPrimitiveComponent* PushedComponent = nullptr;
+
+		ForEachAffectedComponent(Mesh->Bounds.Origin, Profile.ExplosionRadius, nullptr, nullptr, [&](AActor* Actor, UPrimitiveComponent* Component)
+		{
+			if (Actor == *It && !PushedComponent)
+			{
+				PushedComponent = Component;
+			}
+		});
+
+		if (PushedComponent == Mesh)
+		{
+			++NumPushed;
+
+		} else {
+
+			UE_LOG(LogFPS, Warning, TEXT("fps.Explosions.CheckRagdolls: batched explosions miss the ragdoll of %s (picked %s)"), *It->GetName(), PushedComponent ? *PushedComponent->GetName() : TEXT("nothing"));
+		}
+	}
+
+	UE_LOG(LogFPS, Log, TEXT("fps.Explosions.CheckRagdolls: %d of %d ragdolls receive the impulse of a batched explosion"), NumPushed, NumRagdolls);
+}
+#endif
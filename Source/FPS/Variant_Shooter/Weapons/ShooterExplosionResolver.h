@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSpatialHash.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterProjectile.h"
+#include "ShooterExplosionResolver.generated.h"
+
+class UPrimitiveComponent;
+
+/**
+ *  Explosion waiting for the batched resolve pass
+ */
+struct FShooterQueuedExplosion
+{
+	/** Damage and falloff settings */
+	FShooterProjectileProfile Profile;
+
+	FVector Center = FVector::ZeroVector;
+
+	/** Who caused the explosion */
+	TWeakObjectPtr<AActor> Owner;
+	TWeakObjectPtr<APawn> Instigator;
+	TWeakObjectPtr<AActor> DamageCauser;
+};
+
+/**
+ *  Resolves projectile explosions against a spatial hash of everything an explosion can affect,
+ *  instead of running an overlap query per explosion.
+ *  Characters (capsule and mesh) and physics simulating components are tracked as they spawn. Their hash locations are only
+ *  refreshed on frames that have explosions, and every explosion raised during the frame is resolved in one pass
+ */
+UCLASS()
+class FPS_API UShooterExplosionResolver : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Components explosions can damage or push */
+	TFPSSpatialHash<UPrimitiveComponent*> Damageables;
+
+	/** Tracked components, used to refresh the hash and to drop destroyed components */
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> TrackedComponents;
+
+	/** Raw pointers of the tracked components, matching TrackedComponents. Used to remove destroyed components from the hash */
+	TArray<UPrimitiveComponent*> TrackedKeys;
+
+	/** Largest bounds radius among the tracked components as of the last refresh, used to widen the hash lookups */
+	float MaxBoundsRadius = 0.0f;
+
+	/** Explosions raised since the last resolve pass */
+	TArray<FShooterQueuedExplosion> Explosions;
+
+	/** Explosions being resolved. Explosions raised while resolving wait for the next pass */
+	TArray<FShooterQueuedExplosion> ResolvingExplosions;
+
+	/** Runs the resolve pass after the projectile manager */
+	FFPSSubsystemTickFunction TickFunction;
+
+	/** Handle to the actor spawned delegate */
+	FDelegateHandle ActorSpawnedHandle;
+
+public:
+
+	/**
+	 *  Queues an explosion for this frame's resolve pass
+	 *  @return false if the resolver is disabled, in which case the caller should resolve the explosion itself
+	 */
+	bool QueueExplosion(const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, const FVector& Center);
+
+	/**
+	 *  Starts tracking a component that explosions can affect. Characters and components simulating physics at spawn
+	 *  are tracked automatically; call this for components that start simulating later
+	 */
+	void RegisterComponent(UPrimitiveComponent* Component);
+
+#if !UE_BUILD_SHIPPING
+	/** Checks that every ragdoll in the world is reached by a batched explosion centered on it, and logs the result */
+	void CheckRagdolls();
+#endif
+
+	/** Returns the tick function running the resolve pass, so other batched systems can depend on it */
+	FTickFunction& GetTickFunction() { return TickFunction; }
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Starts tracking the components of an actor that explosions can affect */
+	void RegisterActor(AActor* Actor);
+
+	/** Moves the tracked components to their current location in the hash and drops the destroyed ones */
+	void RefreshDamageables();
+
+	/** Calls Func for each tracked component an explosion reaches, skipping components that don't collide and the ignored actors */
+	void ForEachAffectedComponent(const FVector& Center, float Radius, const AActor* IgnoredCauser, const AActor* IgnoredInstigator, TFunctionRef<void(AActor*, UPrimitiveComponent*)> Func) const;
+
+	/** Resolves every queued explosion */
+	void Tick(float DeltaTime);
+};
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterFireScheduler.h"
+#include "ShooterWeapon.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<float> CVarFireSchedulerMaxCatchUp(
+	TEXT("fps.FireScheduler.MaxCatchUp"),
+	0.25f,
+	TEXT("Max time in seconds a weapon may fall behind its refire rate and still catch up by firing several shots in one frame."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Fire Scheduler Tick"), STAT_ShooterFireSchedulerTick, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduled Weapon Events"), STAT_ShooterFireSchedulerPending, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scheduled Shots/Frame"), STAT_ShooterFireSchedulerShots, STATGROUP_FPS);
+
+void UShooterFireScheduler::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Register(&InWorld, TG_PrePhysics, TEXT("ShooterFireScheduler"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterFireScheduler::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	Heap.Reset();
+
+	Super::Deinitialize();
+}
+
+uint32 UShooterFireScheduler::Schedule(AShooterWeapon* Weapon, double Time, EShooterFireEvent Event)
+{
+	// skip zero, weapons use it to mean nothing is scheduled
+	if (++LastHandle == 0)
+	{
+		++LastHandle;
+	}
+
+	// don't let a hitch turn into a burst of catch up shots
+	const double EarliestTime = GetWorld()->GetTimeSeconds() - CVarFireSchedulerMaxCatchUp.GetValueOnGameThread();
+
+	FShooterScheduledFire Entry;
+	Entry.Time = FMath::Max(Time, EarliestTime);
+	Entry.Weapon = Weapon;
+	Entry.Handle = LastHandle;
+	Entry.Event = Event;
+
+	Heap.HeapPush(Entry);
+
+	SET_DWORD_STAT(STAT_ShooterFireSchedulerPending, Heap.Num());
+
+	return LastHandle;
+}
+
+void UShooterFireScheduler::Tick(float DeltaTime)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	if (Heap.Num() == 0 || Heap.HeapTop().Time > Now)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterFireSchedulerTick);
+
+	// full auto weapons schedule their next shot while firing, so keep popping until nothing else is due this frame
+	while (Heap.Num() > 0 && Heap.HeapTop().Time <= Now)
+	{
+		FShooterScheduledFire Entry;
+		Heap.HeapPop(Entry, EAllowShrinking::No);
+
+		// skip events the weapon cancelled or replaced
+		AShooterWeapon* Weapon = Entry.Weapon.Get();
+
+		if (!Weapon || !Weapon->ConsumeScheduledFire(Entry.Handle))
+		{
+			continue;
+		}
+
+		switch (Entry.Event)
+		{
+		case EShooterFireEvent::Shot:
+			Weapon->Fire(Entry.Time);
+			INC_DWORD_STAT(STAT_ShooterFireSchedulerShots);
+			break;
+
+		case EShooterFireEvent::Cooldown:
+			Weapon->FireCooldownExpired();
+			break;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ShooterFireSchedulerPending, Heap.Num());
+}
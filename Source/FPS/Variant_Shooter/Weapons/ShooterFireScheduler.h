@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterFireScheduler.generated.h"
+
+class AShooterWeapon;
+
+/**
+ *  What a scheduled weapon event does when it's due
+ */
+enum class EShooterFireEvent : uint8
+{
+	/** Fire the next full auto shot */
+	Shot,
+
+	/** Notify the owner that a semi auto weapon can fire again */
+	Cooldown
+};
+
+/**
+ *  Weapon event waiting in the fire scheduler
+ */
+struct FShooterScheduledFire
+{
+	/** Game time the event is due */
+	double Time = 0.0;
+
+	/** Weapon the event belongs to */
+	TWeakObjectPtr<AShooterWeapon> Weapon;
+
+	/** Handle the weapon must still hold for the event to run. Lets weapons cancel events without touching the heap */
+	uint32 Handle = 0;
+
+	EShooterFireEvent Event = EShooterFireEvent::Shot;
+
+	/** Orders the heap by due time */
+	bool operator<(const FShooterScheduledFire& Other) const { return Time < Other.Time; }
+};
+
+/**
+ *  Keeps the next refire time of every firing weapon in a single min-heap
+ *  Events are timestamped instead of rounded to the frame they're noticed in, so when a frame is longer than
+ *  a weapon's refire interval the weapon fires several shots in that frame, each at its own sub-frame time
+ */
+UCLASS()
+class FPS_API UShooterFireScheduler : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Pending events, ordered by due time */
+	TArray<FShooterScheduledFire> Heap;
+
+	/** Last handle given out */
+	uint32 LastHandle = 0;
+
+	/** Runs the due events before physics, so the shots are resolved this frame */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/**
+	 *  Schedules a weapon event
+	 *  Events that are already overdue are clamped to how far back weapons are allowed to catch up
+	 *  @param Weapon	Weapon the event belongs to
+	 *  @param Time		Game time the event is due
+	 *  @param Event	What to do when it's due
+	 *  @return Handle the weapon must hold for the event to run
+	 */
+	uint32 Schedule(AShooterWeapon* Weapon, double Time, EShooterFireEvent Event);
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Runs every event due this frame, including the ones scheduled by earlier events in the same frame */
+	void Tick(float DeltaTime);
+};
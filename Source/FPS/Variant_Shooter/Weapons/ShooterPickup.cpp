@@ -7,12 +7,14 @@
 #include "Components/StaticMeshComponent.h"
 #include "ShooterWeaponHolder.h"
 #include "ShooterWeapon.h"
+#include "ShooterPickupStreamer.h"
+#include "Engine/AssetManager.h"
 #include "Engine/World.h"
-#include "TimerManager.h"
 
 AShooterPickup::AShooterPickup()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+	// no native tick work. Blueprints that implement Tick get it turned back on when compiled
+	PrimaryActorTick.bCanEverTick = false;
 
 	// create the root
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -42,6 +44,14 @@ void AShooterPickup::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
 
+	// in game the mesh is streamed in at BeginPlay. Only load it here for the editor preview
+	UWorld* World = GetWorld();
+
+	if (World && World->IsGameWorld())
+	{
+		return;
+	}
+
 	if (FWeaponTableRow* WeaponData = WeaponType.GetRow<FWeaponTableRow>(FString()))
 	{
 		// set the mesh
@@ -57,6 +67,27 @@ void AShooterPickup::BeginPlay()
 	{
 		// copy the weapon class
 		WeaponClass = WeaponData->WeaponToSpawn;
+
+		// stream in the mesh without blocking
+		if (!WeaponData->StaticMesh.IsNull())
+		{
+			TSoftObjectPtr<UStaticMesh> StaticMesh = WeaponData->StaticMesh;
+
+			MeshHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(StaticMesh.ToSoftObjectPath(), FStreamableDelegate::CreateWeakLambda(this, [this, StaticMesh]()
+			{
+				Mesh->SetStaticMesh(StaticMesh.Get());
+			}));
+		}
+	}
+
+	// prefetch the weapon once a player gets close
+	if (UShooterPickupStreamer* Streamer = GetWorld()->GetSubsystem<UShooterPickupStreamer>())
+	{
+		Streamer->RegisterPickup(this);
+
+	} else {
+
+		PrefetchWeapon();
 	}
 }
 
@@ -65,27 +96,69 @@ void AShooterPickup::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	Super::EndPlay(EndPlayReason);
 
 	// clear the respawn timer
-	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(RespawnTimer);
+	}
+
+	// stop waiting for a prefetch
+	if (UShooterPickupStreamer* Streamer = GetWorld()->GetSubsystem<UShooterPickupStreamer>())
+	{
+		Streamer->UnregisterPickup(this);
+	}
+
+	// release the streamed assets. Loads still in flight are released once they complete
+	MeshHandle.Reset();
+	WeaponHandle.Reset();
 }
 
 void AShooterPickup::OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
 	// have we collided against a weapon holder?
-	if (IShooterWeaponHolder* WeaponHolder = Cast<IShooterWeaponHolder>(OtherActor))
+	if (Cast<IShooterWeaponHolder>(OtherActor))
 	{
-		WeaponHolder->AddWeaponClass(WeaponClass);
+		// make sure the weapon is loading. This is a no-op if it was prefetched
+		PrefetchWeapon();
+
+		if (WeaponClass.IsNull() || WeaponClass.Get())
+		{
+			// leave the pickup in the world if the holder couldn't take the weapon
+			if (GrantWeapon(OtherActor))
+			{
+				ConsumePickup();
+			}
+
+		} else {
+
+			// the weapon is still streaming in. Grant it once it's loaded instead of blocking on it
+			PendingGrantHolder = OtherActor;
+
+			// don't let anyone else grab the pickup while it's reserved
+			SetActorEnableCollision(false);
+
+			if (UShooterPickupStreamer* Streamer = GetWorld()->GetSubsystem<UShooterPickupStreamer>())
+			{
+				Streamer->RecordLoadStall(this);
+			}
+		}
+	}
+}
 
-		// hide this mesh
-		SetActorHiddenInGame(true);
+void AShooterPickup::ConsumePickup()
+{
+	// hide this mesh
+	SetActorHiddenInGame(true);
 
-		// disable collision
-		SetActorEnableCollision(false);
+	// disable collision
+	SetActorEnableCollision(false);
 
-		// disable ticking
-		SetActorTickEnabled(false);
+	// disable ticking
+	SetActorTickEnabled(false);
 
-		// schedule the respawn
-		GetWorld()->GetTimerManager().SetTimer(RespawnTimer, this, &AShooterPickup::RespawnPickup, RespawnTime, false);
+	// schedule the respawn
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		RespawnTimer = TimerSubsystem->SetTimer(this, &AShooterPickup::RespawnPickup, RespawnTime);
 	}
 }
 
@@ -106,3 +179,56 @@ void AShooterPickup::FinishRespawn()
 	// enable tick
 	SetActorTickEnabled(true);
 }
+
+void AShooterPickup::PrefetchWeapon()
+{
+	// the pickup no longer needs to wait for players
+	if (UShooterPickupStreamer* Streamer = GetWorld()->GetSubsystem<UShooterPickupStreamer>())
+	{
+		Streamer->UnregisterPickup(this);
+	}
+
+	if (WeaponHandle.IsValid() || WeaponClass.IsNull())
+	{
+		return;
+	}
+
+	// loading the class pulls in everything it references: meshes, anim classes, montages and projectiles
+	WeaponHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(WeaponClass.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &AShooterPickup::OnWeaponLoaded));
+}
+
+void AShooterPickup::OnWeaponLoaded()
+{
+	// was a holder waiting on this weapon? Check even if it has died since, so the pickup gets re-enabled
+	if (!PendingGrantHolder.IsExplicitlyNull())
+	{
+		AActor* Holder = PendingGrantHolder.Get();
+		PendingGrantHolder.Reset();
+
+		if (GrantWeapon(Holder))
+		{
+			ConsumePickup();
+
+		} else {
+
+			// nothing was added, so put the pickup back up for grabs
+			SetActorEnableCollision(true);
+		}
+	}
+}
+
+bool AShooterPickup::GrantWeapon(AActor* Holder)
+{
+	// the holder may have died while the weapon was loading
+	if (!IsValid(Holder))
+	{
+		return false;
+	}
+
+	if (IShooterWeaponHolder* WeaponHolder = Cast<IShooterWeaponHolder>(Holder))
+	{
+		return WeaponHolder->AddWeaponClass(WeaponClass.Get());
+	}
+
+	return false;
+}
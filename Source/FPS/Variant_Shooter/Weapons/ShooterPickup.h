@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "Engine/DataTable.h"
 #include "Engine/StaticMesh.h"
+#include "Engine/StreamableManager.h"
+#include "FPSTimerSubsystem.h"
 #include "ShooterPickup.generated.h"
 
 class USphereComponent;
@@ -24,9 +26,9 @@ struct FWeaponTableRow : public FTableRowBase
 	UPROPERTY(EditAnywhere)
 	TSoftObjectPtr<UStaticMesh> StaticMesh;
 
-	/** Weapon class to grant on pickup */
+	/** Weapon class to grant on pickup. Streamed in along with its meshes and animation before players reach the pickup */
 	UPROPERTY(EditAnywhere)
-	TSubclassOf<AShooterWeapon> WeaponToSpawn;
+	TSoftClassPtr<AShooterWeapon> WeaponToSpawn;
 };
 
 /**
@@ -52,14 +54,27 @@ protected:
 	FDataTableRowHandle WeaponType;
 
 	/** Type to weapon to grant on pickup. Set from the weapon data table. */
-	TSubclassOf<AShooterWeapon> WeaponClass;
+	TSoftClassPtr<AShooterWeapon> WeaponClass;
+
+	/** Players within this distance start streaming in the weapon, so it's loaded by the time they reach the pickup */
+	UPROPERTY(EditAnywhere, Category="Pickup", meta = (ClampMin = 0, ClampMax = 10000, Units = "cm"))
+	float PrefetchRadius = 2000.0f;
+
+	/** Keeps the pickup mesh loaded */
+	TSharedPtr<FStreamableHandle> MeshHandle;
+
+	/** Keeps the weapon class and its dependencies loaded */
+	TSharedPtr<FStreamableHandle> WeaponHandle;
+
+	/** Weapon holder waiting for the weapon to finish loading, if it reached the pickup early */
+	TWeakObjectPtr<AActor> PendingGrantHolder;
 	
 	/** Time to wait before respawning this pickup */
 	UPROPERTY(EditAnywhere, Category="Pickup", meta = (ClampMin = 0, ClampMax = 120, Units = "s"))
 	float RespawnTime = 4.0f;
 
 	/** Timer to respawn the pickup */
-	FTimerHandle RespawnTimer;
+	FFPSTimerHandle RespawnTimer;
 
 public:	
 	
@@ -93,4 +108,21 @@ protected:
 	/** Enables this pickup after respawning */
 	UFUNCTION(BlueprintCallable, Category="Pickup")
 	void FinishRespawn();
+
+	/** Hides the pickup and schedules its respawn after its weapon was taken */
+	void ConsumePickup();
+
+	/** Gives the loaded weapon to a weapon holder. Returns false if the holder didn't take it */
+	bool GrantWeapon(AActor* Holder);
+
+	/** Called when the weapon class has finished loading */
+	void OnWeaponLoaded();
+
+public:
+
+	/** Starts streaming in the weapon class and its dependencies, if not already loading */
+	void PrefetchWeapon();
+
+	/** Returns the distance players start prefetching the weapon from */
+	float GetPrefetchRadius() const { return PrefetchRadius; }
 };
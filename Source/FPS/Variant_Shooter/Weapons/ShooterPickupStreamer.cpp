@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterPickupStreamer.h"
+#include "ShooterPickup.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "FPS.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pickup Prefetch"), STAT_ShooterPickupPrefetch, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pickups Waiting For Prefetch"), STAT_ShooterPickupsWaiting, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pickup Load Stalls"), STAT_ShooterPickupLoadStalls, STATGROUP_FPS);
+
+void UShooterPickupStreamer::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	WaitingPickups.SetCellSize(1000.0f);
+
+	// players don't cover much ground between checks, so a few times a second is plenty
+	TickFunction.TickInterval = 0.2f;
+	TickFunction.Register(&InWorld, TG_PrePhysics, TEXT("ShooterPickupStreamer"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterPickupStreamer::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	WaitingPickups.Reset();
+	TrackedPickups.Reset();
+	TrackedKeys.Reset();
+
+	Super::Deinitialize();
+}
+
+void UShooterPickupStreamer::RegisterPickup(AShooterPickup* Pickup)
+{
+	if (!Pickup || WaitingPickups.Contains(Pickup))
+	{
+		return;
+	}
+
+	// pickups don't move, so their hash location never needs refreshing
+	WaitingPickups.Add(Pickup, Pickup->GetActorLocation());
+	TrackedPickups.Add(Pickup);
+	TrackedKeys.Add(Pickup);
+
+	MaxPrefetchRadius = FMath::Max(MaxPrefetchRadius, Pickup->GetPrefetchRadius());
+
+	SET_DWORD_STAT(STAT_ShooterPickupsWaiting, TrackedKeys.Num());
+}
+
+void UShooterPickupStreamer::UnregisterPickup(AShooterPickup* Pickup)
+{
+	const int32 Index = TrackedKeys.Find(Pickup);
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	WaitingPickups.Remove(Pickup);
+	TrackedPickups.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	TrackedKeys.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	SET_DWORD_STAT(STAT_ShooterPickupsWaiting, TrackedKeys.Num());
+}
+
+void UShooterPickupStreamer::RecordLoadStall(const AShooterPickup* Pickup)
+{
+	++LoadStalls;
+	SET_DWORD_STAT(STAT_ShooterPickupLoadStalls, LoadStalls);
+
+	UE_LOG(LogFPS, Warning, TEXT("Pickup %s was reached before its weapon had loaded (%d stalls so far)"), *GetNameSafe(Pickup), LoadStalls);
+}
+
+void UShooterPickupStreamer::Tick(float DeltaTime)
+{
+	if (TrackedKeys.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterPickupPrefetch);
+
+	// drop the pickups destroyed since the last check
+	for (int32 Index = TrackedPickups.Num() - 1; Index >= 0; --Index)
+	{
+		if (!TrackedPickups[Index].IsValid())
+		{
+			WaitingPickups.Remove(TrackedKeys[Index]);
+			TrackedPickups.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			TrackedKeys.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+
+	// collect first, since prefetching unregisters the pickup from the hash
+	TArray<AShooterPickup*, TInlineAllocator<8>> InRange;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+
+		if (!Pawn)
+		{
+			continue;
+		}
+
+		const FVector PawnLocation = Pawn->GetActorLocation();
+
+		WaitingPickups.ForEachInRadius(PawnLocation, MaxPrefetchRadius, [&](AShooterPickup* Pickup, const FVector& Location)
+		{
+			if (FVector::DistSquared(PawnLocation, Location) <= FMath::Square(Pickup->GetPrefetchRadius()))
+			{
+				InRange.AddUnique(Pickup);
+			}
+		});
+	}
+
+	for (AShooterPickup* Pickup : InRange)
+	{
+		Pickup->PrefetchWeapon();
+	}
+
+	SET_DWORD_STAT(STAT_ShooterPickupsWaiting, TrackedKeys.Num());
+}
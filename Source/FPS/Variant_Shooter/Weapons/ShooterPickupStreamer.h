@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSpatialHash.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterPickupStreamer.generated.h"
+
+class AShooterPickup;
+
+/**
+ *  Starts streaming the weapon granted by a pickup before anyone can reach it.
+ *  Pickups waiting for a prefetch are kept in a spatial hash, and a few times a second every player pawn
+ *  prefetches the weapons of the pickups within their prefetch radius.
+ *  Also counts the pickups that were reached before their weapon had finished loading
+ */
+UCLASS()
+class FPS_API UShooterPickupStreamer : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Pickups that haven't prefetched their weapon yet. Destroyed pickups are dropped before every lookup */
+	TFPSSpatialHash<AShooterPickup*> WaitingPickups;
+
+	/** Pickups in the hash, used to drop destroyed ones */
+	TArray<TWeakObjectPtr<AShooterPickup>> TrackedPickups;
+
+	/** Raw pointers of the tracked pickups, matching TrackedPickups */
+	TArray<AShooterPickup*> TrackedKeys;
+
+	/** Largest prefetch radius among the waiting pickups, used to bound the hash lookups */
+	float MaxPrefetchRadius = 0.0f;
+
+	/** Number of pickups reached before their weapon had loaded */
+	int32 LoadStalls = 0;
+
+	/** Checks the players against the waiting pickups */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/** Starts watching a pickup for players coming within its prefetch radius */
+	void RegisterPickup(AShooterPickup* Pickup);
+
+	/** Stops watching a pickup */
+	void UnregisterPickup(AShooterPickup* Pickup);
+
+	/** Counts a pickup reached before its weapon had loaded */
+	void RecordLoadStall(const AShooterPickup* Pickup);
+
+	/** Returns the number of pickups reached before their weapon had loaded */
+	int32 GetLoadStalls() const { return LoadStalls; }
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Prefetches the weapons of the pickups near any player */
+	void Tick(float DeltaTime);
+};
@@ -5,17 +5,19 @@
 #include "Components/SphereComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "GameFramework/Character.h"
-#include "Kismet/GameplayStatics.h"
 #include "GameFramework/DamageType.h"
 #include "GameFramework/Pawn.h"
 #include "GameFramework/Controller.h"
 #include "Engine/OverlapResult.h"
+#include "ShooterExplosionResolver.h"
+#include "ShooterDamageQueue.h"
+#include "ShooterNoiseBus.h"
 #include "Engine/World.h"
-#include "TimerManager.h"
 
 AShooterProjectile::AShooterProjectile()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// the projectile movement component ticks on its own, the actor has no tick work
+	PrimaryActorTick.bCanEverTick = false;
 
 	// create the collision component and assign it as the root
 	RootComponent = CollisionComponent = CreateDefaultSubobject<USphereComponent>(TEXT("Collision Component"));
@@ -44,18 +46,60 @@ void AShooterProjectile::BeginPlay()
 	CollisionComponent->IgnoreActorWhenMoving(GetInstigator(), true);
 }
 
+void AShooterProjectile::GetProfile(FShooterProjectileProfile& OutProfile) const
+{
+	OutProfile.CollisionRadius = CollisionComponent->GetUnscaledSphereRadius();
+	OutProfile.InitialSpeed = ProjectileMovement->InitialSpeed;
+	OutProfile.MaxSpeed = ProjectileMovement->MaxSpeed;
+	OutProfile.GravityScale = ProjectileMovement->ProjectileGravityScale;
+	OutProfile.bShouldBounce = ProjectileMovement->bShouldBounce;
+	OutProfile.Bounciness = ProjectileMovement->Bounciness;
+	OutProfile.Friction = ProjectileMovement->Friction;
+	OutProfile.NoiseLoudness = NoiseLoudness;
+	OutProfile.NoiseRange = NoiseRange;
+	OutProfile.NoiseTag = NoiseTag;
+	OutProfile.PhysicsForce = PhysicsForce;
+	OutProfile.HitDamage = HitDamage;
+	OutProfile.HitDamageType = HitDamageType;
+	OutProfile.bDamageOwner = bDamageOwner;
+	OutProfile.bExplodeOnHit = bExplodeOnHit;
+	OutProfile.ExplosionRadius = ExplosionRadius;
+	OutProfile.ExplosionInnerRadius = ExplosionInnerRadius;
+	OutProfile.ExplosionFalloffExponent = ExplosionFalloffExponent;
+	OutProfile.ExplosionMinDamage = ExplosionMinDamage;
+	OutProfile.DeferredDestructionTime = DeferredDestructionTime;
+	OutProfile.MaxLifetime = MaxLifetime;
+}
+
+void AShooterProjectile::InitializeAsVisualProxy()
+{
+	bVisualProxy = true;
+
+	// the projectile manager moves and collides the projectile, this actor only renders it
+	SetActorEnableCollision(false);
+	ProjectileMovement->bAutoActivate = false;
+}
+
+void AShooterProjectile::PlayProxyHitEffects(const FHitResult& Hit)
+{
+	BP_OnProjectileHit(Hit);
+}
+
 void AShooterProjectile::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
 	// clear the destruction timer
-	GetWorld()->GetTimerManager().ClearTimer(DestructionTimer);
+	if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+	{
+		TimerSubsystem->ClearTimer(DestructionTimer);
+	}
 }
 
 void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
 {
-	// ignore if we've already hit something else
-	if (bHit)
+	// ignore if we've already hit something else, or if the projectile manager handles our hits
+	if (bHit || bVisualProxy)
 	{
 		return;
 	}
@@ -65,21 +109,11 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 	// disable collision on the projectile
 	CollisionComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	// make AI perception noise
-	MakeNoise(NoiseLoudness, GetInstigator(), GetActorLocation(), NoiseRange, NoiseTag);
+	// make noise and apply the hit damage
+	FShooterProjectileProfile Profile;
+	GetProfile(Profile);
 
-	if (bExplodeOnHit)
-	{
-		
-		// apply explosion damage centered on the projectile
-		ExplosionCheck(GetActorLocation());
-
-	} else {
-
-		// single hit projectile. Process the collided actor
-		ProcessHit(Other, OtherComp, Hit.ImpactPoint, -Hit.ImpactNormal);
-
-	}
+	ResolveImpact(GetWorld(), Profile, GetSource(), Hit);
 
 	// pass control to BP for any extra effects
 	BP_OnProjectileHit(Hit);
@@ -87,7 +121,10 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 	// check if we should schedule deferred destruction of the projectile
 	if (DeferredDestructionTime > 0.0f)
 	{
-		GetWorld()->GetTimerManager().SetTimer(DestructionTimer, this, &AShooterProjectile::OnDeferredDestruction, DeferredDestructionTime, false);
+		if (UFPSTimerSubsystem* TimerSubsystem = GetWorld()->GetSubsystem<UFPSTimerSubsystem>())
+		{
+			DestructionTimer = TimerSubsystem->SetTimer(this, &AShooterProjectile::OnDeferredDestruction, DeferredDestructionTime);
+		}
 
 	} else {
 
@@ -98,11 +135,68 @@ void AShooterProjectile::NotifyHit(class UPrimitiveComponent* MyComp, AActor* Ot
 
 void AShooterProjectile::ExplosionCheck(const FVector& ExplosionCenter)
 {
+	FShooterProjectileProfile Profile;
+	GetProfile(Profile);
+
+	Explode(GetWorld(), Profile, GetSource(), ExplosionCenter);
+}
+
+void AShooterProjectile::ProcessHit(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection)
+{
+	FShooterProjectileProfile Profile;
+	GetProfile(Profile);
+
+	ApplyHit(Profile, GetSource(), HitActor, HitComp, HitLocation, HitDirection);
+}
+
+FShooterProjectileSource AShooterProjectile::GetSource()
+{
+	FShooterProjectileSource Source;
+	Source.Owner = GetOwner();
+	Source.Instigator = GetInstigator();
+	Source.DamageCauser = this;
+
+	return Source;
+}
+
+void AShooterProjectile::ResolveImpact(UWorld* World, const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, const FHitResult& Hit)
+{
+	// make AI perception noise
+	if (AActor* NoiseMaker = Source.DamageCauser ? Source.DamageCauser : Source.Instigator)
+	{
+		UShooterNoiseBus::MakeNoise(NoiseMaker, Profile.NoiseLoudness, Source.Instigator, Hit.Location, Profile.NoiseRange, Profile.NoiseTag);
+	}
+
+	if (Profile.bExplodeOnHit)
+	{
+		
+		// apply explosion damage centered on the projectile
+		Explode(World, Profile, Source, Hit.Location);
+
+	} else {
+
+		// single hit projectile. Process the collided actor
+		ApplyHit(Profile, Source, Hit.GetActor(), Hit.GetComponent(), Hit.ImpactPoint, -Hit.ImpactNormal);
+
+	}
+}
+
+void AShooterProjectile::Explode(UWorld* World, const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, const FVector& ExplosionCenter)
+{
+	// batch the explosion with every other explosion this frame
+	if (UShooterExplosionResolver* ExplosionResolver = World->GetSubsystem<UShooterExplosionResolver>())
+	{
+		if (ExplosionResolver->QueueExplosion(Profile, Source, ExplosionCenter))
+		{
+			return;
+		}
+	}
+
 	// do a sphere overlap check look for nearby actors to damage
 	TArray<FOverlapResult> Overlaps;
 
 	FCollisionShape OverlapShape;
-	OverlapShape.SetSphere(ExplosionRadius);
+	OverlapShape.SetSphere(Profile.ExplosionRadius);
 
 	FCollisionObjectQueryParams ObjectParams;
 	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
@@ -110,54 +204,72 @@ void AShooterProjectile::ExplosionCheck(const FVector& ExplosionCenter)
 	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
 
 	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
-	if (!bDamageOwner)
+	QueryParams.AddIgnoredActor(Source.DamageCauser);
+	if (!Profile.bDamageOwner)
 	{
-		QueryParams.AddIgnoredActor(GetInstigator());
+		QueryParams.AddIgnoredActor(Source.Instigator);
 	}
 
-	GetWorld()->OverlapMultiByObjectType(Overlaps, ExplosionCenter, FQuat::Identity, ObjectParams, OverlapShape, QueryParams);
+	World->OverlapMultiByObjectType(Overlaps, ExplosionCenter, FQuat::Identity, ObjectParams, OverlapShape, QueryParams);
 
-	TArray<AActor*> DamagedActors;
+	TSet<AActor*> DamagedActors;
+	DamagedActors.Reserve(Overlaps.Num());
 
 	// process the overlap results
 	for (const FOverlapResult& CurrentOverlap : Overlaps)
 	{
 		// overlaps may return the same actor multiple times per each component overlapped
-		// ensure we only damage each actor once by adding it to a damaged list
-		if (DamagedActors.Find(CurrentOverlap.GetActor()) == INDEX_NONE)
-		{
-			DamagedActors.Add(CurrentOverlap.GetActor());
+		// ensure we only damage each actor once by adding it to a damaged set
+		bool bAlreadyDamaged = false;
+		DamagedActors.Add(CurrentOverlap.GetActor(), &bAlreadyDamaged);
 
+		if (!bAlreadyDamaged)
+		{
 			// apply physics force away from the explosion
-			const FVector& ExplosionDir = CurrentOverlap.GetActor()->GetActorLocation() - GetActorLocation();
+			const FVector& ExplosionDir = CurrentOverlap.GetActor()->GetActorLocation() - ExplosionCenter;
 
 			// push and/or damage the overlapped actor
-			ProcessHit(CurrentOverlap.GetActor(), CurrentOverlap.GetComponent(), GetActorLocation(), ExplosionDir.GetSafeNormal());
+			ApplyHit(Profile, Source, CurrentOverlap.GetActor(), CurrentOverlap.GetComponent(), ExplosionCenter, ExplosionDir.GetSafeNormal(), GetExplosionDamageScale(Profile, ExplosionDir.Size()));
 		}
 			
 	}
 }
 
-void AShooterProjectile::ProcessHit(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection)
+void AShooterProjectile::ApplyHit(const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection, float DamageScale)
 {
 	// have we hit a character?
 	if (ACharacter* HitCharacter = Cast<ACharacter>(HitActor))
 	{
 		// ignore the owner of this projectile
-		if (HitCharacter != GetOwner() || bDamageOwner)
+		if (HitCharacter != Source.Owner || Profile.bDamageOwner)
 		{
 			// apply damage to the character
-			UGameplayStatics::ApplyDamage(HitCharacter, HitDamage, GetInstigator()->GetController(), this, HitDamageType);
+			AController* InstigatorController = Source.Instigator ? Source.Instigator->GetController() : nullptr;
+			const float Damage = FMath::Lerp(Profile.ExplosionMinDamage, Profile.HitDamage, DamageScale);
+			UShooterDamageQueue::ApplyDamage(HitCharacter, Damage, InstigatorController, Source.DamageCauser, Profile.HitDamageType);
 		}
 	}
 
 	// have we hit a physics object?
-	if (HitComp->IsSimulatingPhysics())
+	if (HitComp && HitComp->IsSimulatingPhysics())
 	{
 		// give some physics impulse to the object
-		HitComp->AddImpulseAtLocation(HitDirection * PhysicsForce, HitLocation);
+		HitComp->AddImpulseAtLocation(HitDirection * Profile.PhysicsForce * DamageScale, HitLocation);
+	}
+}
+
+float AShooterProjectile::GetExplosionDamageScale(const FShooterProjectileProfile& Profile, float Distance)
+{
+	// full damage inside the inner radius, or everywhere if there's no falloff
+	if (Distance <= Profile.ExplosionInnerRadius || Profile.ExplosionFalloffExponent <= 0.0f)
+	{
+		return 1.0f;
 	}
+
+	const float FalloffRange = FMath::Max(Profile.ExplosionRadius - Profile.ExplosionInnerRadius, UE_KINDA_SMALL_NUMBER);
+	const float Alpha = FMath::Clamp(1.0f - (Distance - Profile.ExplosionInnerRadius) / FalloffRange, 0.0f, 1.0f);
+
+	return FMath::Pow(Alpha, Profile.ExplosionFalloffExponent);
 }
 
 void AShooterProjectile::OnDeferredDestruction()
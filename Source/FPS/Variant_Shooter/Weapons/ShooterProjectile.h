@@ -4,13 +4,74 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "FPSTimerSubsystem.h"
 #include "ShooterProjectile.generated.h"
 
 class USphereComponent;
 class UProjectileMovementComponent;
 class ACharacter;
+class APawn;
 class UPrimitiveComponent;
 
+/**
+ *  Flight and damage settings of a projectile class
+ *  Read from the class defaults so pooled projectiles can be simulated and resolved without an actor
+ */
+struct FShooterProjectileProfile
+{
+	/** Radius of the collision sphere */
+	float CollisionRadius = 16.0f;
+
+	/** Launch speed */
+	float InitialSpeed = 3000.0f;
+
+	/** Max speed. Zero means no limit */
+	float MaxSpeed = 3000.0f;
+
+	/** Scale applied to the world gravity */
+	float GravityScale = 1.0f;
+
+	/** If true, the projectile bounces off the first surface it hits. Otherwise it stops there */
+	bool bShouldBounce = true;
+
+	/** Fraction of the normal speed kept after a bounce */
+	float Bounciness = 0.6f;
+
+	/** Fraction of the tangent speed lost on a bounce */
+	float Friction = 0.2f;
+
+	/** Copies of the matching AShooterProjectile properties */
+	float NoiseLoudness = 3.0f;
+	float NoiseRange = 3000.0f;
+	FName NoiseTag;
+	float PhysicsForce = 100.0f;
+	float HitDamage = 25.0f;
+	TSubclassOf<UDamageType> HitDamageType;
+	bool bDamageOwner = false;
+	bool bExplodeOnHit = false;
+	float ExplosionRadius = 500.0f;
+	float ExplosionInnerRadius = 0.0f;
+	float ExplosionFalloffExponent = 0.0f;
+	float ExplosionMinDamage = 0.0f;
+	float DeferredDestructionTime = 5.0f;
+	float MaxLifetime = 10.0f;
+};
+
+/**
+ *  Who fired a projectile. Used to attribute its hits
+ */
+struct FShooterProjectileSource
+{
+	/** Character that owns the weapon */
+	AActor* Owner = nullptr;
+
+	/** Pawn credited with the damage and noise */
+	APawn* Instigator = nullptr;
+
+	/** Actor passed as the damage causer */
+	AActor* DamageCauser = nullptr;
+};
+
 /**
  *  Simple projectile class for a first person shooter game
  */
@@ -65,21 +126,70 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 5000, Units = "cm"))
 	float ExplosionRadius = 500.0f;	
 
+	/** Actors within this distance of the explosion take the full damage and physics force */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 5000, Units = "cm"))
+	float ExplosionInnerRadius = 0.0f;
+
+	/** Shape of the damage falloff between the inner and outer explosion radius. Zero means no falloff, one is linear */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 10))
+	float ExplosionFalloffExponent = 0.0f;
+
+	/** Damage applied at the edge of the explosion */
+	UPROPERTY(EditAnywhere, Category="Projectile|Explosion", meta = (ClampMin = 0, ClampMax = 100))
+	float ExplosionMinDamage = 0.0f;
+
 	/** If true, this projectile has already hit another surface */
 	bool bHit = false;
 
+	/** Max flight time of a pooled projectile that hasn't hit anything */
+	UPROPERTY(EditAnywhere, Category="Projectile|Destruction", meta = (ClampMin = 0, Units = "s"))
+	float MaxLifetime = 10.0f;
+
+	/** If true, this actor is only a visual stand-in for a projectile simulated by UShooterProjectileManager */
+	bool bVisualProxy = false;
+
 	/** How long to wait after a hit before destroying this projectile */
 	UPROPERTY(EditAnywhere, Category="Projectile|Destruction", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
 	float DeferredDestructionTime = 5.0f;
 
 	/** Timer to handle deferred destruction of this projectile */
-	FTimerHandle DestructionTimer;
+	FFPSTimerHandle DestructionTimer;
 
 public:	
 
 	/** Constructor */
 	AShooterProjectile();
 
+	/** Fills out the flight and damage settings of this projectile */
+	void GetProfile(FShooterProjectileProfile& OutProfile) const;
+
+	/**
+	 *  Turns this projectile into a visual stand-in moved by the projectile manager
+	 *  Must be called before the actor finishes spawning
+	 */
+	void InitializeAsVisualProxy();
+
+	/** Runs the blueprint hit effects of a visual proxy */
+	void PlayProxyHitEffects(const FHitResult& Hit);
+
+	/** Makes noise and applies the damage of a projectile impact */
+	static void ResolveImpact(UWorld* World, const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, const FHitResult& Hit);
+
+	/**
+	 *  Damages the actors within the explosion radius of a profile
+	 *  Queued on the explosion resolver when it's enabled, otherwise resolved right away with an overlap query
+	 */
+	static void Explode(UWorld* World, const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, const FVector& ExplosionCenter);
+
+	/**
+	 *  Pushes and/or damages a single actor hit by a projectile
+	 *  @param DamageScale	Explosion falloff. Blends the damage from the explosion min damage to the hit damage, and scales the physics force
+	 */
+	static void ApplyHit(const FShooterProjectileProfile& Profile, const FShooterProjectileSource& Source, AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection, float DamageScale = 1.0f);
+
+	/** Returns the explosion falloff of a profile at the given distance from the explosion center */
+	static float GetExplosionDamageScale(const FShooterProjectileProfile& Profile, float Distance);
+
 protected:
 	
 	/** Gameplay initialization */
@@ -99,6 +209,9 @@ protected:
 	/** Processes a projectile hit for the given actor */
 	void ProcessHit(AActor* HitActor, UPrimitiveComponent* HitComp, const FVector& HitLocation, const FVector& HitDirection);
 
+	/** Returns who fired this projectile */
+	FShooterProjectileSource GetSource();
+
 	/** Passes control to Blueprint to implement any effects on hit. */
 	UFUNCTION(BlueprintImplementableEvent, Category="Projectile", meta = (DisplayName = "On Projectile Hit"))
 	void BP_OnProjectileHit(const FHitResult& Hit);
@@ -0,0 +1,603 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterProjectileManager.h"
+#include "ShooterWeapon.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "FPS.h"
+
+static TAutoConsoleVariable<bool> CVarPooledProjectiles(
+	TEXT("fps.Projectiles.Pooled"),
+	true,
+	TEXT("If true, shooter weapons launch projectiles simulated by the projectile manager.\n")
+	TEXT("If false, every shot spawns a projectile actor."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarProjectileVisualProxies(
+	TEXT("fps.Projectiles.VisualProxies"),
+	true,
+	TEXT("If true, pooled projectiles are rendered with a recycled projectile actor. Never used on dedicated servers."),
+	ECVF_Default);
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Manager Tick"), STAT_ShooterProjectileTick, STATGROUP_FPS);
+DECLARE_CYCLE_STAT(TEXT("Projectile Integrate"), STAT_ShooterProjectileIntegrate, STATGROUP_FPS);
+DECLARE_CYCLE_STAT(TEXT("Projectile Sweeps"), STAT_ShooterProjectileSweep, STATGROUP_FPS);
+DECLARE_CYCLE_STAT(TEXT("Projectile Impacts"), STAT_ShooterProjectileImpacts, STATGROUP_FPS);
+DECLARE_CYCLE_STAT(TEXT("Hitscan Resolve"), STAT_ShooterHitscanResolve, STATGROUP_FPS);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Projectiles"), STAT_ShooterLiveProjectiles, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Simulated/Frame"), STAT_ShooterProjectilesSimulated, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Sweeps/Frame"), STAT_ShooterProjectileSweeps, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Impacts/Frame"), STAT_ShooterProjectileImpactCount, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Shots/Frame"), STAT_ShooterHitscanShots, STATGROUP_FPS);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Proxies Spawned"), STAT_ShooterProjectileProxiesSpawned, STATGROUP_FPS);
+
+#if !UE_BUILD_SHIPPING
+static FAutoConsoleCommandWithWorldAndArgs CmdProjectileBenchmark(
+	TEXT("fps.Projectiles.Benchmark"),
+	TEXT("Simulates a burst of pooled projectiles from the player's view against the current world and logs the throughput.\n")
+	TEXT("Usage: fps.Projectiles.Benchmark [Count=10000] [Steps=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UShooterProjectileManager* Manager = World ? World->GetSubsystem<UShooterProjectileManager>() : nullptr;
+		APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+
+		if (!Manager || !PC)
+		{
+			UE_LOG(LogFPS, Warning, TEXT("fps.Projectiles.Benchmark needs a game world with a player"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		const int32 Steps = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 60;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		Manager->RunBenchmark(FMath::Max(Count, 1), FMath::Max(Steps, 1), ViewLocation, PC->GetPawn());
+	}));
+#endif
+
+int32 FShooterProjectileArrays::Add(const FVector& Location, const FVector& Velocity, double InGravityZ, uint16 ProfileIndex, AActor* Owner, APawn* Instigator, AShooterProjectile* Proxy)
+{
+	PosX.Add(Location.X);
+	PosY.Add(Location.Y);
+	PosZ.Add(Location.Z);
+	VelX.Add(Velocity.X);
+	VelY.Add(Velocity.Y);
+	VelZ.Add(Velocity.Z);
+	GravityZ.Add(InGravityZ);
+	StepStarts.Add(Location);
+	Ages.Add(0.0f);
+	Bounces.Add(0);
+	ProfileIndices.Add(ProfileIndex);
+	Owners.Add(Owner);
+	Instigators.Add(Instigator);
+
+	return Proxies.Add(Proxy);
+}
+
+void FShooterProjectileArrays::RemoveAtSwap(int32 Index)
+{
+	PosX.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	PosY.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	PosZ.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	VelX.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	VelY.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	VelZ.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	GravityZ.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	StepStarts.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Ages.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Bounces.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	ProfileIndices.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Owners.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Instigators.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Proxies.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+void FShooterProjectileArrays::Reset()
+{
+	PosX.Reset();
+	PosY.Reset();
+	PosZ.Reset();
+	VelX.Reset();
+	VelY.Reset();
+	VelZ.Reset();
+	GravityZ.Reset();
+	StepStarts.Reset();
+	Ages.Reset();
+	Bounces.Reset();
+	ProfileIndices.Reset();
+	Owners.Reset();
+	Instigators.Reset();
+	Proxies.Reset();
+}
+
+void FShooterProjectileArrays::SetLocation(int32 Index, const FVector& Location)
+{
+	PosX[Index] = Location.X;
+	PosY[Index] = Location.Y;
+	PosZ[Index] = Location.Z;
+}
+
+void FShooterProjectileArrays::SetVelocity(int32 Index, const FVector& Velocity)
+{
+	VelX[Index] = Velocity.X;
+	VelY[Index] = Velocity.Y;
+	VelZ[Index] = Velocity.Z;
+}
+
+void UShooterProjectileManager::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// step after physics so the sweeps see where everything ended up this frame
+	TickFunction.Register(&InWorld, TG_PostPhysics, TEXT("ShooterProjectileManager"), [this](float DeltaTime) { Tick(DeltaTime); });
+}
+
+void UShooterProjectileManager::Deinitialize()
+{
+	TickFunction.Unregister();
+
+	// the proxies belong to the level and are torn down with it
+	Projectiles.Reset();
+	HitscanShots.Reset();
+	ProxyPools.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UShooterProjectileManager::IsEnabled()
+{
+	return CVarPooledProjectiles.GetValueOnGameThread();
+}
+
+bool UShooterProjectileManager::LaunchProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	if (!IsEnabled() || !ProjectileClass)
+	{
+		return false;
+	}
+
+	const int32 ProfileIndex = FindOrAddProfile(ProjectileClass);
+	const FShooterProjectileProfile& Profile = Profiles[ProfileIndex];
+
+	// launch along the transform forward, like the projectile movement component
+	const FVector Velocity = Transform.GetRotation().GetForwardVector() * Profile.InitialSpeed;
+	const double ProjectileGravityZ = GetWorld()->GetGravityZ() * Profile.GravityScale;
+
+	// only grab a visual proxy when somebody can see it
+	AShooterProjectile* Proxy = nullptr;
+
+	if (CVarProjectileVisualProxies.GetValueOnGameThread() && GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		Proxy = AcquireProxy(ProfileIndex, Transform, Owner, Instigator);
+	}
+
+	Projectiles.Add(Transform.GetLocation(), Velocity, ProjectileGravityZ, uint16(ProfileIndex), Owner, Instigator, Proxy);
+
+	SET_DWORD_STAT(STAT_ShooterLiveProjectiles, Projectiles.Num());
+
+	return true;
+}
+
+void UShooterProjectileManager::QueueHitscan(TSubclassOf<AShooterProjectile> ProjectileClass, AShooterWeapon* Weapon, const FVector& Start, const FVector& End, AActor* Owner, APawn* Instigator)
+{
+	if (!ProjectileClass)
+	{
+		return;
+	}
+
+	FShooterHitscanShot& Shot = HitscanShots.AddDefaulted_GetRef();
+	Shot.Start = Start;
+	Shot.End = End;
+	Shot.ProfileIndex = uint16(FindOrAddProfile(ProjectileClass));
+	Shot.Weapon = Weapon;
+	Shot.Owner = Owner;
+	Shot.Instigator = Instigator;
+}
+
+int32 UShooterProjectileManager::FindOrAddProfile(TSubclassOf<AShooterProjectile> ProjectileClass)
+{
+	if (const int32* Found = ProfileIndices.Find(ProjectileClass))
+	{
+		return *Found;
+	}
+
+	// read the settings from the class defaults once
+	const int32 ProfileIndex = Profiles.AddDefaulted();
+	ProjectileClass->GetDefaultObject<AShooterProjectile>()->GetProfile(Profiles[ProfileIndex]);
+
+	ProfileClasses.Add(ProjectileClass);
+	ProxyPools.AddDefaulted();
+	ProfileIndices.Add(ProjectileClass, ProfileIndex);
+
+	return ProfileIndex;
+}
+
+void UShooterProjectileManager::Tick(float DeltaTime)
+{
+	if (HitscanShots.Num() > 0)
+	{
+		ResolveHitscans();
+	}
+
+	if (Projectiles.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileTick);
+
+	INC_DWORD_STAT_BY(STAT_ShooterProjectilesSimulated, Projectiles.Num());
+
+	Integrate(Projectiles, DeltaTime);
+
+	Impacts.Reset();
+	Sweep(GetWorld(), Profiles, Projectiles, Impacts);
+
+	ResolveImpacts();
+
+	RetireProjectiles(DeltaTime);
+
+	SET_DWORD_STAT(STAT_ShooterLiveProjectiles, Projectiles.Num());
+}
+
+void UShooterProjectileManager::Integrate(FShooterProjectileArrays& InProjectiles, float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileIntegrate);
+
+	const int32 Count = InProjectiles.Num();
+
+	// remember where each projectile starts, the sweeps go from there to the integrated location
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		InProjectiles.StepStarts[Index] = InProjectiles.GetLocation(Index);
+	}
+
+	double* PosX = InProjectiles.PosX.GetData();
+	double* PosY = InProjectiles.PosY.GetData();
+	double* PosZ = InProjectiles.PosZ.GetData();
+	double* VelX = InProjectiles.VelX.GetData();
+	double* VelY = InProjectiles.VelY.GetData();
+	double* VelZ = InProjectiles.VelZ.GetData();
+	const double* GravityZ = InProjectiles.GravityZ.GetData();
+
+	// gravity is applied with midpoint integration, like the projectile movement component
+	const double Dt = DeltaTime;
+	const double HalfDt = Dt * 0.5;
+
+	const VectorRegister4Double VecDt = VectorSetFloat1(Dt);
+	const VectorRegister4Double VecHalfDt = VectorSetFloat1(HalfDt);
+
+	int32 Index = 0;
+
+	for (; Index + 4 <= Count; Index += 4)
+	{
+		const VectorRegister4Double OldVelZ = VectorLoad(VelZ + Index);
+		const VectorRegister4Double NewVelZ = VectorMultiplyAdd(VectorLoad(GravityZ + Index), VecDt, OldVelZ);
+
+		VectorStore(VectorMultiplyAdd(VectorLoad(VelX + Index), VecDt, VectorLoad(PosX + Index)), PosX + Index);
+		VectorStore(VectorMultiplyAdd(VectorLoad(VelY + Index), VecDt, VectorLoad(PosY + Index)), PosY + Index);
+		VectorStore(VectorMultiplyAdd(VectorAdd(OldVelZ, NewVelZ), VecHalfDt, VectorLoad(PosZ + Index)), PosZ + Index);
+		VectorStore(NewVelZ, VelZ + Index);
+	}
+
+	// scalar tail
+	for (; Index < Count; ++Index)
+	{
+		const double NewVelZ = VelZ[Index] + GravityZ[Index] * Dt;
+
+		PosX[Index] += VelX[Index] * Dt;
+		PosY[Index] += VelY[Index] * Dt;
+		PosZ[Index] += (VelZ[Index] + NewVelZ) * HalfDt;
+		VelZ[Index] = NewVelZ;
+	}
+}
+
+void UShooterProjectileManager::Sweep(UWorld* World, TConstArrayView<FShooterProjectileProfile> InProfiles, FShooterProjectileArrays& InProjectiles, TArray<FShooterProjectileImpact>& OutImpacts)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileSweep);
+
+	const int32 Count = InProjectiles.Num();
+	int32 NumSweeps = 0;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FShooterProjectileProfile& Profile = InProfiles[InProjectiles.ProfileIndices[Index]];
+
+		// clamp to the max speed, like the projectile movement component
+		if (Profile.MaxSpeed > 0.0f)
+		{
+			const FVector Velocity = InProjectiles.GetVelocity(Index);
+
+			if (Velocity.SizeSquared() > FMath::Square(Profile.MaxSpeed))
+			{
+				InProjectiles.SetVelocity(Index, Velocity.GetSafeNormal() * Profile.MaxSpeed);
+			}
+		}
+
+		// spent projectiles fly through everything, like the projectile actor once its collision is disabled
+		if (InProjectiles.Bounces[Index] > 0)
+		{
+			continue;
+		}
+
+		// ignore the pawn that shot the projectile
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterProjectileSweep), false, InProjectiles.Instigators[Index].Get());
+		QueryParams.bReturnPhysicalMaterial = true;
+
+		const FVector End = InProjectiles.GetLocation(Index);
+
+		++NumSweeps;
+
+		FHitResult Hit;
+		if (World->SweepSingleByChannel(Hit, InProjectiles.StepStarts[Index], End, FQuat::Identity, ECC_WorldDynamic, FCollisionShape::MakeSphere(Profile.CollisionRadius), QueryParams))
+		{
+			// stop at the impact
+			InProjectiles.SetLocation(Index, Hit.Location);
+
+			OutImpacts.Add({ Index, Hit });
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ShooterProjectileSweeps, NumSweeps);
+	INC_DWORD_STAT_BY(STAT_ShooterProjectileImpactCount, OutImpacts.Num());
+}
+
+void UShooterProjectileManager::ResolveHitscans()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterHitscanResolve);
+
+	INC_DWORD_STAT_BY(STAT_ShooterHitscanShots, HitscanShots.Num());
+
+	UWorld* World = GetWorld();
+
+	Swap(HitscanShots, ResolvingHitscanShots);
+
+	// trace every shot before applying any hit, so damage and impulses from one shot can't change what the others see
+	HitscanHits.SetNum(ResolvingHitscanShots.Num(), EAllowShrinking::No);
+
+	for (int32 Index = 0; Index < ResolvingHitscanShots.Num(); ++Index)
+	{
+		const FShooterHitscanShot& Shot = ResolvingHitscanShots[Index];
+
+		// ignore the pawn that fired the shot
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShooterHitscan), false, Shot.Instigator.Get());
+		QueryParams.bReturnPhysicalMaterial = true;
+
+		if (!World->LineTraceSingleByChannel(HitscanHits[Index], Shot.Start, Shot.End, ECC_WorldDynamic, QueryParams))
+		{
+			// keep the trace extents so tracers can still be drawn for misses
+			HitscanHits[Index] = FHitResult(Shot.Start, Shot.End);
+		}
+	}
+
+	// apply the hits in bulk
+	for (int32 Index = 0; Index < ResolvingHitscanShots.Num(); ++Index)
+	{
+		const FShooterHitscanShot& Shot = ResolvingHitscanShots[Index];
+		const FHitResult& Hit = HitscanHits[Index];
+
+		AShooterWeapon* Weapon = Shot.Weapon.Get();
+
+		if (Hit.bBlockingHit)
+		{
+			FShooterProjectileSource Source;
+			Source.Owner = Shot.Owner.Get();
+			Source.Instigator = Shot.Instigator.Get();
+			// never the shooter. If the weapon is gone the damage is only credited through the instigator
+			Source.DamageCauser = Weapon;
+
+			AShooterProjectile::ResolveImpact(World, Profiles[Shot.ProfileIndex], Source, Hit);
+		}
+
+		if (Weapon)
+		{
+			Weapon->NotifyHitscanShot(Hit);
+		}
+	}
+
+	ResolvingHitscanShots.Reset();
+}
+
+void UShooterProjectileManager::ResolveImpacts()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShooterProjectileImpacts);
+
+	for (const FShooterProjectileImpact& Impact : Impacts)
+	{
+		const int32 Index = Impact.Index;
+		const FShooterProjectileProfile& Profile = Profiles[Projectiles.ProfileIndices[Index]];
+
+		AShooterProjectile* Proxy = Projectiles.Proxies[Index].Get();
+
+		// the proxy stands in for the projectile actor. Without one the damage is only credited through the instigator,
+		// since damage is dispatched at the end of the frame and a shared causer would carry whoever fired last
+		FShooterProjectileSource Source;
+		Source.Owner = Projectiles.Owners[Index].Get();
+		Source.Instigator = Projectiles.Instigators[Index].Get();
+		Source.DamageCauser = Proxy;
+
+		AShooterProjectile::ResolveImpact(GetWorld(), Profile, Source, Impact.Hit);
+
+		if (Proxy)
+		{
+			Proxy->SetActorLocation(Impact.Hit.Location);
+			Proxy->PlayProxyHitEffects(Impact.Hit);
+		}
+
+		++Projectiles.Bounces[Index];
+		Projectiles.Ages[Index] = 0.0f;
+
+		if (Profile.bShouldBounce)
+		{
+			// reflect off the surface, like the projectile movement component
+			const FVector Velocity = Projectiles.GetVelocity(Index);
+			const FVector NormalVelocity = (Velocity | Impact.Hit.Normal) * Impact.Hit.Normal;
+			const FVector TangentVelocity = Velocity - NormalVelocity;
+
+			Projectiles.SetVelocity(Index, TangentVelocity * FMath::Clamp(1.0f - Profile.Friction, 0.0f, 1.0f) - NormalVelocity * Profile.Bounciness);
+
+		} else {
+
+			// stop simulating
+			Projectiles.SetVelocity(Index, FVector::ZeroVector);
+			Projectiles.GravityZ[Index] = 0.0;
+		}
+	}
+}
+
+void UShooterProjectileManager::RetireProjectiles(float DeltaTime)
+{
+	const AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+	const double KillZ = WorldSettings->bEnableWorldBoundsChecks ? WorldSettings->KillZ : -UE_BIG_NUMBER;
+
+	for (int32 Index = Projectiles.Num() - 1; Index >= 0; --Index)
+	{
+		const FShooterProjectileProfile& Profile = Profiles[Projectiles.ProfileIndices[Index]];
+
+		AShooterProjectile* Proxy = Projectiles.Proxies[Index].Get();
+
+		Projectiles.Ages[Index] += DeltaTime;
+
+		bool bExpired;
+
+		if (Projectiles.Bounces[Index] == 0)
+		{
+			// still flying
+			bExpired = (Profile.MaxLifetime > 0.0f && Projectiles.Ages[Index] >= Profile.MaxLifetime) || Projectiles.PosZ[Index] < KillZ;
+
+		} else {
+
+			// spent projectiles are only kept around to show the proxy until the deferred destruction time
+			bExpired = !Proxy || Projectiles.Ages[Index] >= Profile.DeferredDestructionTime;
+		}
+
+		if (bExpired)
+		{
+			if (Proxy)
+			{
+				ReleaseProxy(Projectiles.ProfileIndices[Index], Proxy);
+			}
+
+			Projectiles.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (Proxy)
+		{
+			Proxy->SetActorLocation(Projectiles.GetLocation(Index));
+		}
+	}
+}
+
+AShooterProjectile* UShooterProjectileManager::AcquireProxy(int32 ProfileIndex, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	TArray<TObjectPtr<AShooterProjectile>>& Free = ProxyPools[ProfileIndex].Free;
+
+	while (Free.Num() > 0)
+	{
+		AShooterProjectile* Proxy = Free.Pop(EAllowShrinking::No);
+
+		if (IsValid(Proxy))
+		{
+			Proxy->SetOwner(Owner);
+			Proxy->SetInstigator(Instigator);
+			Proxy->SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation());
+			Proxy->SetActorHiddenInGame(false);
+
+			return Proxy;
+		}
+	}
+
+	// the pool is empty, spawn a new proxy
+	AShooterProjectile* Proxy = GetWorld()->SpawnActorDeferred<AShooterProjectile>(ProfileClasses[ProfileIndex], Transform, Owner, Instigator, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+
+	if (Proxy)
+	{
+		Proxy->InitializeAsVisualProxy();
+		Proxy->FinishSpawning(Transform);
+
+		INC_DWORD_STAT(STAT_ShooterProjectileProxiesSpawned);
+	}
+
+	return Proxy;
+}
+
+void UShooterProjectileManager::ReleaseProxy(int32 ProfileIndex, AShooterProjectile* Proxy)
+{
+	Proxy->SetActorHiddenInGame(true);
+
+	ProxyPools[ProfileIndex].Free.Add(Proxy);
+}
+
+#if !UE_BUILD_SHIPPING
+void UShooterProjectileManager::RunBenchmark(int32 Count, int32 Steps, const FVector& Origin, APawn* IgnoredPawn)
+{
+	// simulate with the default projectile settings in a separate batch so live projectiles are left alone
+	const FShooterProjectileProfile Profile;
+	const double ProjectileGravityZ = GetWorld()->GetGravityZ() * Profile.GravityScale;
+
+	FShooterProjectileArrays Batch;
+	FRandomStream Stream(Count);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		Batch.Add(Origin, Stream.VRand() * Profile.InitialSpeed, ProjectileGravityZ, 0, nullptr, IgnoredPawn, nullptr);
+	}
+
+	TArray<FShooterProjectileImpact> BatchImpacts;
+
+	const float StepTime = 1.0f / 60.0f;
+	double IntegrateSeconds = 0.0;
+	double SweepSeconds = 0.0;
+	int64 NumSwept = 0;
+	int64 NumImpacts = 0;
+
+	for (int32 Step = 0; Step < Steps; ++Step)
+	{
+		for (const uint8 Bounces : Batch.Bounces)
+		{
+			NumSwept += Bounces == 0 ? 1 : 0;
+		}
+
+		const double IntegrateStart = FPlatformTime::Seconds();
+		Integrate(Batch, StepTime);
+
+		const double SweepStart = FPlatformTime::Seconds();
+		BatchImpacts.Reset();
+		Sweep(GetWorld(), MakeArrayView(&Profile, 1), Batch, BatchImpacts);
+
+		const double SweepEnd = FPlatformTime::Seconds();
+
+		IntegrateSeconds += SweepStart - IntegrateStart;
+		SweepSeconds += SweepEnd - SweepStart;
+
+		// stop the projectiles that hit something, without applying any damage
+		for (const FShooterProjectileImpact& Impact : BatchImpacts)
+		{
+			++Batch.Bounces[Impact.Index];
+			Batch.SetVelocity(Impact.Index, FVector::ZeroVector);
+			Batch.GravityZ[Impact.Index] = 0.0;
+		}
+
+		NumImpacts += BatchImpacts.Num();
+	}
+
+	const double TotalMs = (IntegrateSeconds + SweepSeconds) * 1000.0;
+	const int64 NumSimulated = int64(Count) * Steps;
+
+	UE_LOG(LogFPS, Display, TEXT("Projectile benchmark: %d projectiles x %d steps, %lld sweeps, %lld impacts"), Count, Steps, NumSwept, NumImpacts);
+	UE_LOG(LogFPS, Display, TEXT("Projectile benchmark: integrate %.3f ms/step, sweeps %.3f ms/step, %.0f projectiles/ms, %.1f ns/sweep"),
+		IntegrateSeconds * 1000.0 / Steps,
+		SweepSeconds * 1000.0 / Steps,
+		TotalMs > 0.0 ? NumSimulated / TotalMs : 0.0,
+		NumSwept > 0 ? SweepSeconds * 1.0e9 / NumSwept : 0.0);
+}
+#endif
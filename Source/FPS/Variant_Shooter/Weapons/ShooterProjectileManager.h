@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSSubsystemTickFunction.h"
+#include "ShooterProjectile.h"
+#include "ShooterProjectileManager.generated.h"
+
+class AShooterWeapon;
+
+/**
+ *  Live pooled projectiles laid out as structure of arrays
+ *  Every array is indexed the same way
+ */
+struct FShooterProjectileArrays
+{
+	/** Position and velocity components, split so they can be integrated four projectiles at a time */
+	TArray<double> PosX;
+	TArray<double> PosY;
+	TArray<double> PosZ;
+	TArray<double> VelX;
+	TArray<double> VelY;
+	TArray<double> VelZ;
+
+	/** Gravity acceleration of each projectile */
+	TArray<double> GravityZ;
+
+	/** Position at the start of the current step, where the collision sweep starts */
+	TArray<FVector> StepStarts;
+
+	/** Time since launch, or since the impact once the projectile is spent */
+	TArray<float> Ages;
+
+	/** Number of surfaces hit. Projectiles only deal damage on their first hit, like the projectile actor */
+	TArray<uint8> Bounces;
+
+	/** Index of the projectile class settings in the manager's profiles */
+	TArray<uint16> ProfileIndices;
+
+	/** Who fired each projectile */
+	TArray<TWeakObjectPtr<AActor>> Owners;
+	TArray<TWeakObjectPtr<APawn>> Instigators;
+
+	/** Optional visual stand-in for each projectile. The actors are kept alive by their level and the proxy pools */
+	TArray<TWeakObjectPtr<AShooterProjectile>> Proxies;
+
+	/** Returns the number of live projectiles */
+	int32 Num() const { return PosX.Num(); }
+
+	/** Adds a projectile and returns its index */
+	int32 Add(const FVector& Location, const FVector& Velocity, double InGravityZ, uint16 ProfileIndex, AActor* Owner, APawn* Instigator, AShooterProjectile* Proxy);
+
+	/** Removes a projectile, filling the gap with the last one */
+	void RemoveAtSwap(int32 Index);
+
+	/** Removes every projectile */
+	void Reset();
+
+	/** Returns the position of a projectile */
+	FVector GetLocation(int32 Index) const { return FVector(PosX[Index], PosY[Index], PosZ[Index]); }
+
+	/** Returns the velocity of a projectile */
+	FVector GetVelocity(int32 Index) const { return FVector(VelX[Index], VelY[Index], VelZ[Index]); }
+
+	/** Sets the position of a projectile */
+	void SetLocation(int32 Index, const FVector& Location);
+
+	/** Sets the velocity of a projectile */
+	void SetVelocity(int32 Index, const FVector& Velocity);
+};
+
+/**
+ *  Projectile surface hit found by the collision sweeps
+ */
+struct FShooterProjectileImpact
+{
+	/** Index of the projectile */
+	int32 Index = INDEX_NONE;
+
+	/** Sweep hit */
+	FHitResult Hit;
+};
+
+/**
+ *  Hitscan shot waiting for the batched trace pass
+ */
+struct FShooterHitscanShot
+{
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+
+	/** Index of the projectile class providing the damage settings */
+	uint16 ProfileIndex = 0;
+
+	/** Weapon that fired the shot, notified once it's traced */
+	TWeakObjectPtr<AShooterWeapon> Weapon;
+
+	/** Who fired the shot */
+	TWeakObjectPtr<AActor> Owner;
+	TWeakObjectPtr<APawn> Instigator;
+};
+
+/**
+ *  Hidden visual proxies of a projectile class, ready to be reused
+ */
+USTRUCT()
+struct FShooterProjectileProxyPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AShooterProjectile>> Free;
+};
+
+/**
+ *  Simulates the projectiles fired by shooter weapons without spawning an actor per shot
+ *  Projectiles are integrated in bulk, collided with one sweep each in a single pass after physics,
+ *  and their hits are resolved with the same rules as AShooterProjectile.
+ *  A pooled projectile actor is only used as an optional visual stand-in.
+ *  Hitscan shots are queued during the frame and traced together in the same pass
+ */
+UCLASS()
+class FPS_API UShooterProjectileManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Live projectiles */
+	FShooterProjectileArrays Projectiles;
+
+	/** Flight and damage settings of every projectile class launched so far */
+	TArray<FShooterProjectileProfile> Profiles;
+
+	/** Projectile class of each profile */
+	UPROPERTY()
+	TArray<TSubclassOf<AShooterProjectile>> ProfileClasses;
+
+	/** Visual proxy pool of each profile */
+	UPROPERTY()
+	TArray<FShooterProjectileProxyPool> ProxyPools;
+
+	/** Index of each projectile class in the profiles */
+	TMap<UClass*, int32> ProfileIndices;
+
+	/** Impacts found this frame. Kept around to avoid reallocating every frame */
+	TArray<FShooterProjectileImpact> Impacts;
+
+	/** Hitscan shots fired since the last trace pass */
+	TArray<FShooterHitscanShot> HitscanShots;
+
+	/** Hitscan shots being resolved. Shots fired while applying hits wait for the next pass */
+	TArray<FShooterHitscanShot> ResolvingHitscanShots;
+
+	/** Trace results of the hitscan shots. Kept around to avoid reallocating every frame */
+	TArray<FHitResult> HitscanHits;
+
+	/** Runs the simulation after physics */
+	FFPSSubsystemTickFunction TickFunction;
+
+public:
+
+	/**
+	 *  Launches a pooled projectile
+	 *  @param ProjectileClass	Projectile class to read the flight and damage settings and visual proxy from
+	 *  @param Transform		Launch location and direction
+	 *  @param Owner			Character that owns the weapon
+	 *  @param Instigator		Pawn credited with the damage
+	 *  @return false if pooled projectiles are disabled, in which case the caller should spawn the projectile actor
+	 */
+	bool LaunchProjectile(TSubclassOf<AShooterProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator);
+
+	/**
+	 *  Queues a hitscan shot. Every shot queued during the frame is traced and applied in one pass after movement
+	 *  @param ProjectileClass	Projectile class providing the damage settings
+	 *  @param Weapon			Weapon that fired the shot
+	 *  @param Start			Start of the shot trace
+	 *  @param End				End of the shot trace
+	 *  @param Owner			Character that owns the weapon
+	 *  @param Instigator		Pawn credited with the damage
+	 */
+	void QueueHitscan(TSubclassOf<AShooterProjectile> ProjectileClass, AShooterWeapon* Weapon, const FVector& Start, const FVector& End, AActor* Owner, APawn* Instigator);
+
+	/** Returns the number of live pooled projectiles */
+	int32 GetNumProjectiles() const { return Projectiles.Num(); }
+
+	/** Returns the tick function running the simulation, so other batched systems can depend on it */
+	FTickFunction& GetTickFunction() { return TickFunction; }
+
+	/** Returns true if weapons should launch pooled projectiles instead of spawning projectile actors */
+	static bool IsEnabled();
+
+#if !UE_BUILD_SHIPPING
+	/**
+	 *  Simulates a burst of projectiles against the world, without applying their hits, and logs the throughput
+	 *  @param Count		Number of projectiles to launch
+	 *  @param Steps		Number of 60Hz steps to simulate
+	 *  @param Origin		Launch location. Projectiles are launched in random directions
+	 *  @param IgnoredPawn	Pawn the projectiles shouldn't collide with
+	 */
+	void RunBenchmark(int32 Count, int32 Steps, const FVector& Origin, APawn* IgnoredPawn);
+#endif
+
+	//~Begin UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	//~End UWorldSubsystem interface
+
+protected:
+
+	/** Steps every live projectile */
+	void Tick(float DeltaTime);
+
+	/** Returns the profile index of a projectile class, reading its settings the first time */
+	int32 FindOrAddProfile(TSubclassOf<AShooterProjectile> ProjectileClass);
+
+	/** Traces every queued hitscan shot, then applies their hits */
+	void ResolveHitscans();
+
+	/** Applies the hits found by the sweeps and bounces or stops the projectiles */
+	void ResolveImpacts();
+
+	/** Ages the projectiles, removes the expired ones and moves the visual proxies */
+	void RetireProjectiles(float DeltaTime);
+
+	/** Returns a visual proxy for a profile, reusing a pooled one if possible */
+	AShooterProjectile* AcquireProxy(int32 ProfileIndex, const FTransform& Transform, AActor* Owner, APawn* Instigator);
+
+	/** Hides a visual proxy and returns it to its pool */
+	void ReleaseProxy(int32 ProfileIndex, AShooterProjectile* Proxy);
+
+	/** Moves every projectile by DeltaTime, four at a time */
+	static void Integrate(FShooterProjectileArrays& InProjectiles, float DeltaTime);
+
+	/** Sweeps every projectile that hasn't hit anything yet along its last step and collects the hits */
+	static void Sweep(UWorld* World, TConstArrayView<FShooterProjectileProfile> InProfiles, FShooterProjectileArrays& InProjectiles, TArray<FShooterProjectileImpact>& OutImpacts);
+};
@@ -5,16 +5,23 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Engine/World.h"
 #include "ShooterProjectile.h"
+#include "ShooterProjectileManager.h"
+#include "ShooterFireScheduler.h"
+#include "ShooterNoiseBus.h"
+#include "ShooterAimProvider.h"
 #include "ShooterWeaponHolder.h"
 #include "Components/SceneComponent.h"
-#include "TimerManager.h"
 #include "Animation/AnimInstance.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "AnimationRuntime.h"
 #include "GameFramework/Pawn.h"
 
 AShooterWeapon::AShooterWeapon()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// firing is driven by the fire scheduler, the weapon has no tick work
+	PrimaryActorTick.bCanEverTick = false;
 
 	// create the root
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -50,6 +57,12 @@ void AShooterWeapon::BeginPlay()
 	// fill the first ammo clip
 	CurrentBullets = MagazineSize;
 
+	// find the AI muzzle offset once from the reference pose. Fall back to the first person mesh if the third person one has no muzzle
+	if (!GetRefPoseMuzzleOffset(ThirdPersonMesh, AnalyticMuzzleOffset))
+	{
+		GetRefPoseMuzzleOffset(FirstPersonMesh, AnalyticMuzzleOffset);
+	}
+
 	// attach the meshes to the owner
 	WeaponOwner->AttachWeaponMeshes(this);
 }
@@ -58,8 +71,11 @@ void AShooterWeapon::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
-	// clear the refire timer
-	GetWorld()->GetTimerManager().ClearTimer(RefireTimer);
+	// drop any pending refire event
+	ScheduledFireHandle = 0;
+
+	// stop caching the muzzle
+	ReleaseMuzzleCache();
 }
 
 void AShooterWeapon::OnOwnerDestroyed(AActor* DestroyedActor)
@@ -82,6 +98,9 @@ void AShooterWeapon::DeactivateWeapon()
 	// ensure we're no longer firing this weapon while deactivated
 	StopFiring();
 
+	// the muzzle doesn't need caching while holstered
+	ReleaseMuzzleCache();
+
 	// hide the weapon
 	SetActorHiddenInGame(true);
 
@@ -94,21 +113,25 @@ void AShooterWeapon::StartFiring()
 	// raise the firing flag
 	bIsFiring = true;
 
+	// the last shot belongs to an earlier burst, the muzzle has moved since
+	bLastShotInBurst = false;
+
 	// check how much time has passed since we last shot
 	// this may be under the refire rate if the weapon shoots slow enough and the player is spamming the trigger
-	const float TimeSinceLastShot = GetWorld()->GetTimeSeconds() - TimeOfLastShot;
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double TimeSinceLastShot = Now - TimeOfLastShot;
 
-	if (TimeSinceLastShot > RefireRate)
+	if (TimeSinceLastShot >= RefireRate)
 	{
 		// fire the weapon right away
-		Fire();
+		Fire(Now);
 
 	} else {
 
-		// if we're full auto, schedule the next shot
+		// if we're full auto, schedule the next shot for when the cooldown runs out
 		if (bFullAuto)
 		{
-			GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::Fire, TimeSinceLastShot, false);
+			ScheduleFireEvent(EShooterFireEvent::Shot, TimeOfLastShot + RefireRate);
 		}
 
 	}
@@ -118,12 +141,13 @@ void AShooterWeapon::StopFiring()
 {
 	// lower the firing flag
 	bIsFiring = false;
+	bLastShotInBurst = false;
 
-	// clear the refire timer
-	GetWorld()->GetTimerManager().ClearTimer(RefireTimer);
+	// drop any pending refire event. The muzzle stays cached while the weapon is equipped, so the next burst doesn't re-register
+	ScheduledFireHandle = 0;
 }
 
-void AShooterWeapon::Fire()
+void AShooterWeapon::Fire(double ShotTime)
 {
 	// ensure the player still wants to fire. They may have let go of the trigger
 	if (!bIsFiring)
@@ -132,46 +156,88 @@ void AShooterWeapon::Fire()
 	}
 	
 	// fire a projectile at the target
-	FireProjectile(WeaponOwner->GetWeaponTargetLocation());
+	FireProjectile(WeaponOwner->GetWeaponTargetLocation(), ShotTime);
 
 	// update the time of our last shot
-	TimeOfLastShot = GetWorld()->GetTimeSeconds();
+	TimeOfLastShot = ShotTime;
 
 	// make noise so the AI perception system can hear us
-	MakeNoise(ShotLoudness, PawnOwner, PawnOwner->GetActorLocation(), ShotNoiseRange, ShotNoiseTag);
+	UShooterNoiseBus::MakeNoise(this, ShotLoudness, PawnOwner, PawnOwner->GetActorLocation(), ShotNoiseRange, ShotNoiseTag);
 
 	// are we full auto?
 	if (bFullAuto)
 	{
-		// schedule the next shot
-		GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::Fire, RefireRate, false);
+		// schedule the next shot relative to this one, so the fire rate doesn't depend on the frame rate
+		ScheduleFireEvent(EShooterFireEvent::Shot, TimeOfLastShot + RefireRate);
 	} else {
 
 		// for semi-auto weapons, schedule the cooldown notification
-		GetWorld()->GetTimerManager().SetTimer(RefireTimer, this, &AShooterWeapon::FireCooldownExpired, RefireRate, false);
+		ScheduleFireEvent(EShooterFireEvent::Cooldown, TimeOfLastShot + RefireRate);
 
 	}
 }
 
+void AShooterWeapon::ScheduleFireEvent(EShooterFireEvent Event, double Time)
+{
+	if (UShooterFireScheduler* FireScheduler = GetWorld()->GetSubsystem<UShooterFireScheduler>())
+	{
+		ScheduledFireHandle = FireScheduler->Schedule(this, Time, Event);
+	}
+}
+
+bool AShooterWeapon::ConsumeScheduledFire(uint32 Handle)
+{
+	if (Handle == 0 || Handle != ScheduledFireHandle)
+	{
+		return false;
+	}
+
+	ScheduledFireHandle = 0;
+	return true;
+}
+
 void AShooterWeapon::FireCooldownExpired()
 {
 	// notify the owner
 	WeaponOwner->OnSemiWeaponRefire();
 }
 
-void AShooterWeapon::FireProjectile(const FVector& TargetLocation)
+void AShooterWeapon::FireProjectile(const FVector& TargetLocation, double ShotTime)
 {
+	// find the muzzle location at the time of the shot
+	const FVector MuzzleLoc = GetMuzzleLocation(ShotTime);
+	LastShotMuzzleLocation = MuzzleLoc;
+	bLastShotInBurst = true;
+
 	// get the projectile transform
-	FTransform ProjectileTransform = CalculateProjectileSpawnTransform(TargetLocation);
+	FTransform ProjectileTransform = CalculateProjectileSpawnTransform(MuzzleLoc, TargetLocation);
 	
-	// spawn the projectile
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
-	SpawnParams.Owner = GetOwner();
-	SpawnParams.Instigator = PawnOwner;
+	UShooterProjectileManager* ProjectileManager = GetWorld()->GetSubsystem<UShooterProjectileManager>();
 
-	AShooterProjectile* Projectile = GetWorld()->SpawnActor<AShooterProjectile>(ProjectileClass, ProjectileTransform, SpawnParams);
+	if (bHitscan && ProjectileManager)
+	{
+		// queue a trace, resolved along with every other hitscan shot fired this frame
+		const FVector TraceStart = ProjectileTransform.GetLocation();
+		const FVector TraceEnd = TraceStart + ProjectileTransform.GetRotation().GetForwardVector() * HitscanRange;
+
+		ProjectileManager->QueueHitscan(ProjectileClass, this, TraceStart, TraceEnd, GetOwner(), PawnOwner);
+
+	} else {
+
+		// launch a pooled projectile, or spawn a projectile actor if pooling is disabled
+		if (!ProjectileManager || !ProjectileManager->LaunchProjectile(ProjectileClass, ProjectileTransform, GetOwner(), PawnOwner))
+		{
+			// spawn the projectile
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			SpawnParams.TransformScaleMethod = ESpawnActorScaleMethod::OverrideRootScale;
+			SpawnParams.Owner = GetOwner();
+			SpawnParams.Instigator = PawnOwner;
+
+			GetWorld()->SpawnActor<AShooterProjectile>(ProjectileClass, ProjectileTransform, SpawnParams);
+		}
+
+	}
 
 	// play the firing montage
 	WeaponOwner->PlayFiringMontage(FiringMontage);
@@ -192,11 +258,106 @@ void AShooterWeapon::FireProjectile(const FVector& TargetLocation)
 	WeaponOwner->UpdateWeaponHUD(CurrentBullets, MagazineSize);
 }
 
-FTransform AShooterWeapon::CalculateProjectileSpawnTransform(const FVector& TargetLocation) const
+FVector AShooterWeapon::GetMuzzleLocation(double ShotTime)
 {
 	// find the muzzle location
-	const FVector MuzzleLoc = FirstPersonMesh->GetSocketLocation(MuzzleSocketName);
+	const FVector MuzzleLoc = GetCurrentMuzzleLocation();
+
+	// shots caught up by the fire scheduler happened earlier in the frame.
+	// Move the muzzle back along the path from the last shot, since we only know where it is now.
+	// The first shot of a burst has nothing to interpolate from, so it leaves from the current muzzle
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	if (bLastShotInBurst && ShotTime < Now && TimeOfLastShot < ShotTime)
+	{
+		const double Alpha = (ShotTime - TimeOfLastShot) / (Now - TimeOfLastShot);
+
+		return FMath::Lerp(LastShotMuzzleLocation, MuzzleLoc, Alpha);
+	}
+
+	return MuzzleLoc;
+}
+
+FVector AShooterWeapon::GetCurrentMuzzleLocation()
+{
+	// AI never renders the first person mesh, so place the muzzle analytically on the third person mesh
+	if (!PawnOwner || !PawnOwner->IsPlayerControlled())
+	{
+		return ThirdPersonMesh->GetComponentTransform().TransformPosition(AnalyticMuzzleOffset);
+	}
 
+	// start caching the first person muzzle on the first player shot
+	if (!bMuzzleCacheValid)
+	{
+		if (UShooterAimProvider* AimProvider = GetWorld()->GetSubsystem<UShooterAimProvider>())
+		{
+			AimProvider->RegisterWeapon(this);
+		}
+
+		// no aim provider, so read the socket directly
+		if (!bMuzzleCacheValid)
+		{
+			return FirstPersonMesh->GetSocketLocation(MuzzleSocketName);
+		}
+	}
+
+	// the socket was cached after animation, so only the mesh transform is needed to place it
+	return FirstPersonMesh->GetComponentTransform().TransformPosition(CachedMuzzleOffset);
+}
+
+void AShooterWeapon::UpdateMuzzleCache()
+{
+	CachedMuzzleOffset = FirstPersonMesh->GetSocketTransform(MuzzleSocketName, RTS_Component).GetLocation();
+	bMuzzleCacheValid = true;
+}
+
+void AShooterWeapon::ReleaseMuzzleCache()
+{
+	if (!bMuzzleCacheValid)
+	{
+		return;
+	}
+
+	bMuzzleCacheValid = false;
+
+	if (UShooterAimProvider* AimProvider = GetWorld()->GetSubsystem<UShooterAimProvider>())
+	{
+		AimProvider->UnregisterWeapon(this);
+	}
+}
+
+bool AShooterWeapon::GetRefPoseMuzzleOffset(const USkeletalMeshComponent* Mesh, FVector& OutOffset) const
+{
+	const USkeletalMesh* SkeletalMesh = Mesh ? Mesh->GetSkeletalMeshAsset() : nullptr;
+
+	if (!SkeletalMesh)
+	{
+		return false;
+	}
+
+	const USkeletalMeshSocket* Socket = SkeletalMesh->FindSocket(MuzzleSocketName);
+
+	if (!Socket)
+	{
+		return false;
+	}
+
+	const int32 BoneIndex = SkeletalMesh->GetRefSkeleton().FindBoneIndex(Socket->BoneName);
+
+	if (BoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// the socket relative to its bone, then the bone relative to the mesh in the reference pose
+	const FTransform BoneTransform = FAnimationRuntime::GetComponentSpaceTransformRefPose(SkeletalMesh->GetRefSkeleton(), BoneIndex);
+	OutOffset = (Socket->GetSocketLocalTransform() * BoneTransform).GetLocation();
+
+	return true;
+}
+
+FTransform AShooterWeapon::CalculateProjectileSpawnTransform(const FVector& MuzzleLoc, const FVector& TargetLocation) const
+{
 	// calculate the spawn location ahead of the muzzle
 	const FVector SpawnLoc = MuzzleLoc + ((TargetLocation - MuzzleLoc).GetSafeNormal() * MuzzleOffset);
 
@@ -207,6 +368,12 @@ FTransform AShooterWeapon::CalculateProjectileSpawnTransform(const FVector& Targ
 	return FTransform(AimRot, SpawnLoc, FVector::OneVector);
 }
 
+void AShooterWeapon::NotifyHitscanShot(const FHitResult& Hit)
+{
+	// pass control to BP for tracers and impact effects
+	BP_OnHitscanShot(Hit);
+}
+
 const TSubclassOf<UAnimInstance>& AShooterWeapon::GetFirstPersonAnimInstanceClass() const
 {
 	return FirstPersonAnimInstanceClass;
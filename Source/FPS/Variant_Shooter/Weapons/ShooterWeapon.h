@@ -13,6 +13,7 @@ class AShooterProjectile;
 class USkeletalMeshComponent;
 class UAnimMontage;
 class UAnimInstance;
+enum class EShooterFireEvent : uint8;
 
 /**
  *  Base class for a simple first person shooter weapon
@@ -24,6 +25,8 @@ UCLASS(abstract)
 class FPS_API AShooterWeapon : public AActor
 {
 	GENERATED_BODY()
+
+	friend class UShooterFireScheduler;
 	
 	/** First person perspective mesh */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
@@ -42,6 +45,14 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Ammo")
 	TSubclassOf<AShooterProjectile> ProjectileClass;
 
+	/** If true, shots are resolved with a trace instead of launching a projectile. The projectile class still provides the damage settings */
+	UPROPERTY(EditAnywhere, Category="Ammo")
+	bool bHitscan = false;
+
+	/** Max range of hitscan shots */
+	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, Units = "cm", EditCondition = "bHitscan"))
+	float HitscanRange = 10000.0f;
+
 	/** Number of bullets in a magazine */
 	UPROPERTY(EditAnywhere, Category="Ammo", meta = (ClampMin = 0, ClampMax = 100))
 	int32 MagazineSize = 10;
@@ -61,6 +72,18 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Animation")
 	TSubclassOf<UAnimInstance> ThirdPersonAnimInstanceClass;
 
+	/**
+	 *  Anim layers to link into the first person character mesh when this weapon is active. Takes priority over the AnimInstance class.
+	 *  None of the shipped weapon blueprints set this yet, so they keep swapping the whole AnimInstance until layer assets are authored.
+	 *  The layers must implement the layer interface of the character's host AnimInstance
+	 */
+	UPROPERTY(EditAnywhere, Category="Animation")
+	TSubclassOf<UAnimInstance> FirstPersonAnimLayersClass;
+
+	/** Anim layers to link into the third person character mesh when this weapon is active. Same requirements as FirstPersonAnimLayersClass */
+	UPROPERTY(EditAnywhere, Category="Animation")
+	TSubclassOf<UAnimInstance> ThirdPersonAnimLayersClass;
+
 	/** Cone half-angle for variance while aiming */
 	UPROPERTY(EditAnywhere, Category="Aim", meta = (ClampMin = 0, ClampMax = 90, Units = "Degrees"))
 	float AimVariance = 0.0f;
@@ -86,13 +109,28 @@ protected:
 	float RefireRate = 0.5f;
 
 	/** Game time of last shot fired, used to enforce refire rate on semi auto */
-	float TimeOfLastShot = 0.0f;
+	double TimeOfLastShot = 0.0;
+
+	/** Muzzle location of the last shot, used to place shots fired between frames */
+	FVector LastShotMuzzleLocation = FVector::ZeroVector;
+
+	/** If true, LastShotMuzzleLocation was set by a shot of the current burst and can be interpolated from */
+	bool bLastShotInBurst = false;
+
+	/** Muzzle socket location relative to the first person mesh, cached once per frame by the aim provider for player owners */
+	FVector CachedMuzzleOffset = FVector::ZeroVector;
+
+	/** If true, CachedMuzzleOffset is up to date and the weapon is registered with the aim provider */
+	bool bMuzzleCacheValid = false;
+
+	/** Muzzle socket location relative to the third person mesh in the reference pose. Used for AI owners, which never render the first person mesh */
+	FVector AnalyticMuzzleOffset = FVector::ZeroVector;
 
 	/** If true, the weapon is currently firing */
 	bool bIsFiring = false;
 
-	/** Timer to handle full auto refiring */
-	FTimerHandle RefireTimer;
+	/** Handle of the pending refire or cooldown event in the fire scheduler. Zero if nothing is scheduled */
+	uint32 ScheduledFireHandle = 0;
 
 	/** Cast pawn pointer to the owner for AI perception system interactions */
 	TObjectPtr<APawn> PawnOwner;
@@ -144,20 +182,51 @@ public:
 
 protected:
 
-	/** Fire the weapon */
-	virtual void Fire();
+	/**
+	 *  Fire the weapon
+	 *  @param ShotTime		Game time of the shot. Can be earlier in the frame when the fire scheduler catches up
+	 */
+	virtual void Fire(double ShotTime);
+
+	/** Schedules the next full auto shot or semi auto cooldown notification */
+	void ScheduleFireEvent(EShooterFireEvent Event, double Time);
+
+	/** Returns true and clears the handle if it matches the pending fire scheduler event */
+	bool ConsumeScheduledFire(uint32 Handle);
 
 	/** Called when the refire rate time has passed while shooting semi auto weapons */
 	void FireCooldownExpired();
 
 	/** Fire a projectile towards the target location */
-	virtual void FireProjectile(const FVector& TargetLocation);
+	virtual void FireProjectile(const FVector& TargetLocation, double ShotTime);
+
+	/** Returns the muzzle location at the time of a shot, interpolated from the last shot for shots earlier in the frame */
+	FVector GetMuzzleLocation(double ShotTime);
+
+	/** Returns the current muzzle location without querying the skeletal pose */
+	FVector GetCurrentMuzzleLocation();
+
+	/** Stops caching the muzzle socket with the aim provider */
+	void ReleaseMuzzleCache();
+
+	/** Finds the muzzle socket location relative to a mesh in its reference pose. Returns false if the mesh has no muzzle socket */
+	bool GetRefPoseMuzzleOffset(const USkeletalMeshComponent* Mesh, FVector& OutOffset) const;
 
 	/** Calculates the spawn transform for projectiles shot by this weapon */
-	FTransform CalculateProjectileSpawnTransform(const FVector& TargetLocation) const;
+	FTransform CalculateProjectileSpawnTransform(const FVector& MuzzleLoc, const FVector& TargetLocation) const;
+
+	/** Passes control to Blueprint to implement tracers and impact effects for hitscan shots */
+	UFUNCTION(BlueprintImplementableEvent, Category="Weapon", meta = (DisplayName = "On Hitscan Shot"))
+	void BP_OnHitscanShot(const FHitResult& Hit);
 
 public:
 
+	/** Called by the projectile manager once a hitscan shot fired by this weapon has been traced */
+	void NotifyHitscanShot(const FHitResult& Hit);
+
+	/** Called by the aim provider after animation to cache the first person muzzle socket for this frame */
+	void UpdateMuzzleCache();
+
 	/** Returns the first person mesh */
 	UFUNCTION(BlueprintPure, Category="Weapon")
 	USkeletalMeshComponent* GetFirstPersonMesh() const { return FirstPersonMesh; };
@@ -172,6 +241,12 @@ public:
 	/** Returns the third person anim instance class */
 	const TSubclassOf<UAnimInstance>& GetThirdPersonAnimInstanceClass() const;
 
+	/** Returns the first person anim layers class */
+	const TSubclassOf<UAnimInstance>& GetFirstPersonAnimLayersClass() const { return FirstPersonAnimLayersClass; }
+
+	/** Returns the third person anim layers class */
+	const TSubclassOf<UAnimInstance>& GetThirdPersonAnimLayersClass() const { return ThirdPersonAnimLayersClass; }
+
 	/** Returns the magazine size */
 	int32 GetMagazineSize() const { return MagazineSize; };
 
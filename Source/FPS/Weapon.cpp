@@ -2,13 +2,16 @@
 
 
 #include "Weapon.h"
+#include "FPSCharacter.h"
+#include "InteractableComponent.h"
 
 // Sets default values
 AWeapon::AWeapon()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// the weapon has no per frame work
+	PrimaryActorTick.bCanEverTick = false;
 
+	InteractableComponent = CreateDefaultSubobject<UInteractableComponent>(TEXT("Interactable"));
 }
 
 // Called when the game starts or when spawned
@@ -18,15 +21,17 @@ void AWeapon::BeginPlay()
 	
 }
 
-// Called every frame
-void AWeapon::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-}
-
 USkeletalMeshComponent* AWeapon::GetSkeletalMesh()
 {
 	return WeaponMesh;
 }
 
+
+void AWeapon::OnFocusGained(AFPSCharacter* Character)
+{
+	// weapons are picked up as soon as they're looked at
+	Character->PickupWeapon(this);
+
+	// owned weapons can't be focused again
+	InteractableComponent->SetInteractionEnabled(false);
+}
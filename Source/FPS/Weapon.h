@@ -4,10 +4,13 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "FPSInteractable.h"
 #include "Weapon.generated.h"
 
+class UInteractableComponent;
+
 UCLASS()
-class FPS_API AWeapon : public AActor
+class FPS_API AWeapon : public AActor, public IFPSInteractable
 {
 	GENERATED_BODY()
 	
@@ -19,10 +22,6 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Weapon")
 	USkeletalMeshComponent* WeaponMesh;
@@ -38,4 +37,12 @@ public:
 	UPROPERTY(VisibleAnywhere)
 	bool bReloading = false;
 
+	/** Lets players pick the weapon up by looking at it */
+	UPROPERTY(VisibleAnywhere, Category = "Weapon")
+	UInteractableComponent* InteractableComponent;
+
+	//~Begin IFPSInteractable interface
+	virtual void OnFocusGained(AFPSCharacter* Character) override;
+	//~End IFPSInteractable interface
+
 };
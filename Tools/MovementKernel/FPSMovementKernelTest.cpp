@@ -0,0 +1,296 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+ *  Standalone check of FPSMovementKernel against the formulas AFPSCharacter used before the kernel was extracted:
+ *  the falling gravity ramp, the koyote timer, the double jump and wall jump launch vectors and the StartShoot launch.
+ *  Lives outside Source so Unreal Build Tool doesn't pick up its main(). Build and run with the Makefile next to it:
+ *      make -C Tools/MovementKernel test
+ */
+
+#include "FPSMovementKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace FPSMovementKernel;
+
+namespace
+{
+	int32_t NumChecks = 0;
+	int32_t NumFailed = 0;
+
+	/** Counts a check and prints it if it failed */
+	void Check(bool bPassed, const char* Case, int32_t Index, float Value, float Expected)
+	{
+		++NumChecks;
+
+		if (!bPassed)
+		{
+			++NumFailed;
+			std::printf("FAIL %s [%d]: got %.9g, expected %.9g\n", Case, Index, Value, Expected);
+		}
+	}
+
+	bool NearlyEqual(float A, float B, float Tolerance)
+	{
+		return std::fabs(A - B) <= Tolerance * std::max(1.f, std::max(std::fabs(A), std::fabs(B)));
+	}
+
+	void CheckVector(const FVec3& Value, const FVec3& Expected, float Tolerance, const char* Case, int32_t Index)
+	{
+		Check(NearlyEqual(Value.X, Expected.X, Tolerance), Case, Index, Value.X, Expected.X);
+		Check(NearlyEqual(Value.Y, Expected.Y, Tolerance), Case, Index, Value.Y, Expected.Y);
+		Check(NearlyEqual(Value.Z, Expected.Z, Tolerance), Case, Index, Value.Z, Expected.Z);
+	}
+
+	/** The FVector operations the old character code was written with */
+	namespace Old
+	{
+		float Dot(const FVec3& A, const FVec3& B)
+		{
+			return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+		}
+
+		FVec3 Scale(const FVec3& V, float Scale)
+		{
+			return FVec3{ V.X * Scale, V.Y * Scale, V.Z * Scale };
+		}
+
+		/** FVector::Normalize, which leaves tiny vectors alone */
+		FVec3 Normalize(const FVec3& V)
+		{
+			const float SquareSum = Dot(V, V);
+			return SquareSum > 1.e-8f ? Scale(V, 1.f / std::sqrt(SquareSum)) : V;
+		}
+
+		/** FVector::GetSafeNormal */
+		FVec3 GetSafeNormal(const FVec3& V)
+		{
+			const float SquareSum = Dot(V, V);
+
+			if (SquareSum == 1.f)
+			{
+				return V;
+			}
+
+			return SquareSum < 1.e-8f ? FVec3() : Scale(V, 1.f / std::sqrt(SquareSum));
+		}
+
+		/** FVector::VectorPlaneProject, which projects on the plane normal as if it were normalized */
+		FVec3 VectorPlaneProject(const FVec3& V, const FVec3& PlaneNormal)
+		{
+			const FVec3 Projection = Scale(PlaneNormal, Dot(V, PlaneNormal));
+			return FVec3{ V.X - Projection.X, V.Y - Projection.Y, V.Z - Projection.Z };
+		}
+
+		/** The camera forward flattened onto the ground, as the jumps used it */
+		FVec3 FlatForward(const FVec3& CameraForward)
+		{
+			return Normalize(FVec3{ CameraForward.X, CameraForward.Y, 0.f });
+		}
+
+		/** AFPSCharacter::FallingGravity */
+		float FallingGravity(float FallGravityMultiplier, float DeltaTime, float FallGravityScaler, float FallGravityMultiplierMax)
+		{
+			return (FallGravityMultiplier < FallGravityMultiplierMax) ? FallGravityMultiplier + DeltaTime * FallGravityScaler : FallGravityMultiplierMax;
+		}
+
+		/** The koyote half of AFPSCharacter::DoJumpCustom */
+		bool CanKoyoteJump(float TimeSinceLeftGround, float KoyoteTime)
+		{
+			return TimeSinceLeftGround <= KoyoteTime;
+		}
+
+		/** The double jump branch of AFPSCharacter::DoJumpCustom */
+		FVec3 DoubleJumpVelocity(const FVec3& CameraForward, float DoubleJumpForwardBoost, float JumpZVelocity)
+		{
+			FVec3 JumpVelocity = Scale(FlatForward(CameraForward), DoubleJumpForwardBoost);
+			JumpVelocity.Z += JumpZVelocity;
+			return JumpVelocity;
+		}
+
+		/** The wall run branch of AFPSCharacter::DoJumpCustom, before it's scaled by the wall run speed */
+		FVec3 WallJumpDirection(const FVec3& CameraForward, const FVec3& CurrentWallNormal)
+		{
+			const FVec3 Forward = FlatForward(CameraForward);
+
+			if (Dot(Forward, CurrentWallNormal) < 0.f)
+			{
+				return GetSafeNormal(VectorPlaneProject(Forward, Scale(CurrentWallNormal, 15.f)));
+			}
+
+			return Forward;
+		}
+
+		/** Horizontal launch direction of AFPSCharacter::StartShoot */
+		FVec3 ShootDirectionXY(const FVec3& Delta)
+		{
+			return GetSafeNormal(FVec3{ Delta.X, Delta.Y, 0.f });
+		}
+	}
+
+	FVec3 RandomDirection(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Axis(-1.f, 1.f);
+
+		for (;;)
+		{
+			const FVec3 V{ Axis(Random), Axis(Random), Axis(Random) };
+			const float SizeSquared = Old::Dot(V, V);
+
+			if (SizeSquared > 1.e-4f && SizeSquared <= 1.f)
+			{
+				return Old::Scale(V, 1.f / std::sqrt(SizeSquared));
+			}
+		}
+	}
+
+	void TestFallGravity()
+	{
+		const FFallGravityParams Params;
+		const float DeltaTimes[] = { 1.f / 120.f, 1.f / 60.f, 1.f / 30.f, .1f, .5f };
+
+		// single steps on both sides of the clamp
+		int32_t Index = 0;
+
+		for (const float DeltaTime : DeltaTimes)
+		{
+			for (float Multiplier = 0.f; Multiplier <= Params.Max * 1.5f; Multiplier += 2.5f, ++Index)
+			{
+				const float Expected = Old::FallingGravity(Multiplier, DeltaTime, Params.Scaler, Params.Max);
+				Check(StepFallGravity(Multiplier, DeltaTime, Params) == Expected, "StepFallGravity", Index, StepFallGravity(Multiplier, DeltaTime, Params), Expected);
+			}
+		}
+
+		// a whole fall from the ground value, long enough to reach the clamp
+		float Multiplier = 10.f;
+		float OldMultiplier = 10.f;
+
+		for (int32_t Step = 0; Step < 2000; ++Step)
+		{
+			Multiplier = StepFallGravity(Multiplier, 1.f / 60.f, Params);
+			OldMultiplier = Old::FallingGravity(OldMultiplier, 1.f / 60.f, Params.Scaler, Params.Max);
+
+			Check(Multiplier == OldMultiplier, "StepFallGravity ramp", Step, Multiplier, OldMultiplier);
+		}
+	}
+
+	void TestKoyoteJump()
+	{
+		const float KoyoteTime = .2f;
+		const float Times[] = { 0.f, .1f, KoyoteTime, std::nextafter(KoyoteTime, 1.f), .3f, 5.f };
+
+		for (int32_t Index = 0; Index < int32_t(sizeof(Times) / sizeof(Times[0])); ++Index)
+		{
+			const bool bExpected = Old::CanKoyoteJump(Times[Index], KoyoteTime);
+			Check(CanKoyoteJump(Times[Index], KoyoteTime) == bExpected, "CanKoyoteJump", Index, CanKoyoteJump(Times[Index], KoyoteTime), bExpected);
+		}
+	}
+
+	void TestDoubleJump(std::mt19937& Random)
+	{
+		for (int32_t Index = 0; Index < 1000; ++Index)
+		{
+			// include looking straight up or down, where the flattened forward is degenerate
+			FVec3 CameraForward = RandomDirection(Random);
+			if (Index % 100 == 0)
+			{
+				CameraForward = FVec3{ 0.f, 0.f, (Index % 200 == 0) ? 1.f : -1.f };
+			}
+
+			const FVec3 Expected = Old::DoubleJumpVelocity(CameraForward, 600.f, 700.f);
+			CheckVector(DoubleJumpVelocity(Old::FlatForward(CameraForward), 600.f, 700.f), Expected, 1.e-6f, "DoubleJumpVelocity", Index);
+		}
+	}
+
+	void TestWallJump(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Angle(0.f, 6.2831853f);
+
+		for (int32_t Index = 0; Index < 1000; ++Index)
+		{
+			const FVec3 CameraForward = RandomDirection(Random);
+
+			// wall run surfaces are close to vertical, so their normals are close to horizontal
+			const float WallAngle = Angle(Random);
+			const FVec3 WallNormal = Old::Normalize(FVec3{ std::cos(WallAngle), std::sin(WallAngle), (Index % 4 == 0) ? .1f : 0.f });
+
+			const FVec3 Expected = Old::WallJumpDirection(CameraForward, WallNormal);
+			CheckVector(WallJumpDirection(Old::FlatForward(CameraForward), WallNormal), Expected, 1.e-5f, "WallJumpDirection", Index);
+		}
+	}
+
+	void TestLaunch(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Horizontal(-3000.f, 3000.f);
+		std::uniform_real_distribution<float> Vertical(-800.f, 800.f);
+
+		const float Power = 2000.f;
+		const float UpwardBoost = 800.f;
+
+		FBallisticParams Braked;
+		Braked.BrakingDeceleration = 300.f;
+
+		// no falling ramp, where the arc is a plain parabola
+		FBallisticParams Parabola;
+		Parabola.FallGravityStart = 0.f;
+		Parabola.FallGravityMax = 0.f;
+
+		const FBallisticParams ParamSets[] = { FBallisticParams(), Braked, Parabola };
+
+		for (int32_t Index = 0; Index < 600; ++Index)
+		{
+			const FBallisticParams& Params = ParamSets[Index % 3];
+			const FVec3 Delta{ Horizontal(Random), Horizontal(Random), Vertical(Random) };
+
+			FLaunchSolution Solution;
+			if (!SolveLaunchVelocity(Delta, Power, UpwardBoost, Params, Solution))
+			{
+				Check(false, "SolveLaunchVelocity found no launch", Index, Delta.Z, 0.f);
+				continue;
+			}
+
+			// launched the same way the old arc was, but landing on the target
+			const FVec3 DirectionXY = Old::GetSafeNormal(FVec3{ Solution.Velocity.X, Solution.Velocity.Y, 0.f });
+			CheckVector(DirectionXY, Old::ShootDirectionXY(Delta), 1.e-4f, "SolveLaunchVelocity direction", Index);
+
+			const FVec3 Landing = ArcOffset(Solution.Velocity, Solution.FlightTime, Params);
+			CheckVector(Landing, Delta, 1.e-3f, "SolveLaunchVelocity landing", Index);
+
+			Check(Solution.Velocity.Z >= UpwardBoost - 1.e-3f, "SolveLaunchVelocity upward boost", Index, Solution.Velocity.Z, UpwardBoost);
+
+			// the old arc always flew at Power horizontally, the solve lofts rather than going faster
+			if (Params.BrakingDeceleration <= 0.f)
+			{
+				const float SpeedXY = std::sqrt(Solution.Velocity.X * Solution.Velocity.X + Solution.Velocity.Y * Solution.Velocity.Y);
+				Check(SpeedXY <= Power * (1.f + 1.e-4f), "SolveLaunchVelocity horizontal speed", Index, SpeedXY, Power);
+			}
+
+			// a plain parabola lands when the closed form says it does
+			if (Index % 3 == 2)
+			{
+				const float Gravity = Params.Gravity;
+				const float Vz = Solution.Velocity.Z;
+				const float Expected = (Vz + std::sqrt(std::max(Vz * Vz - 2.f * Gravity * Delta.Z, 0.f))) / Gravity;
+
+				Check(NearlyEqual(Solution.FlightTime, Expected, 1.e-3f), "SolveLaunchVelocity parabola flight time", Index, Solution.FlightTime, Expected);
+			}
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 Random(1234);
+
+	TestFallGravity();
+	TestKoyoteJump();
+	TestDoubleJump(Random);
+	TestWallJump(Random);
+	TestLaunch(Random);
+
+	std::printf("%d of %d movement kernel checks match the character formulas\n", NumChecks - NumFailed, NumChecks);
+
+	return NumFailed == 0 ? 0 : 1;
+}